@@ -0,0 +1,79 @@
+/**
+*		    Filename:  emit.c
+*    Description:  buffered writer for the records of a run
+*        Version:  1.0
+*        Created:  10.19.2026 03h02min31s
+*         Author:  Ningyuan Zhang （狮子劫博丽）(elithz), elithz@iastate.edu
+*        Company:  NERVE Software
+*/
+
+#include "emit.h"
+#include <stdio.h>
+#include <string.h>
+
+//make room for a piece of at most EM_SLACK bytes
+static void emRoom(emit *e)
+{
+  if (e->len > EM_BUF - EM_SLACK)
+    emFlush(e);
+}
+
+void emInit(emit *e, FILE *f)
+{
+  e->f = f;
+  e->len = 0;
+}
+
+void emStr(emit *e, const char *s)
+{
+  //length of what is left of s and of the part that fits
+  size_t left = strlen(s), part;
+
+  while (left)
+  {
+    if (e->len == EM_BUF)
+      emFlush(e);
+    part = EM_BUF - e->len < left ? EM_BUF - e->len : left;
+    memcpy(e->buf + e->len, s, part);
+    e->len += part;
+    s += part;
+    left -= part;
+  }
+}
+
+void emInt(emit *e, long long v)
+{
+  //digits backwards and how many
+  char dig[24];
+  int i = 0;
+  //magnitude, safe for the smallest long long
+  unsigned long long u = v < 0 ? 0ULL - v : v;
+
+  emRoom(e);
+  do
+  {
+    dig[i++] = '0' + u % 10;
+    u /= 10;
+  } while (u);
+  if (v < 0)
+    e->buf[e->len++] = '-';
+  while (i)
+    e->buf[e->len++] = dig[--i];
+}
+
+void emDbl(emit *e, double v)
+{
+  //length printed, cut to what fits
+  int n;
+
+  emRoom(e);
+  n = snprintf(e->buf + e->len, EM_SLACK, "%.3f", v);
+  e->len += n < EM_SLACK ? n : EM_SLACK - 1;
+}
+
+void emFlush(emit *e)
+{
+  if (e->len)
+    fwrite(e->buf, 1, e->len, e->f);
+  e->len = 0;
+}
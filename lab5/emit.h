@@ -0,0 +1,51 @@
+/**
+*		    Filename:  emit.h
+*    Description:  buffered writer for the records of a run
+*        Version:  1.0
+*        Created:  10.19.2026 03h02min31s
+*         Author:  Ningyuan Zhang （狮子劫博丽）(elithz), elithz@iastate.edu
+*        Company:  NERVE Software
+*/
+
+/*
+ *  A run of a million processes writes a million records, with a
+ *  formatted print per field the printing costs more than the
+ *  simulation. The writer fills a buffer of its own, integers are
+ *  formatted by hand and only the doubles go through snprintf, and the
+ *  buffer reaches the file in one fwrite whenever it is nearly full.
+ */
+
+#ifndef EMIT
+#define EMIT
+
+#include <stdio.h>
+
+//size of the buffer, the longest single piece written must fit in
+//EM_SLACK
+#define EM_BUF 65536
+#define EM_SLACK 64
+
+//a writer
+typedef struct emit_struct
+{
+  FILE *f;
+  char buf[EM_BUF];
+  int len;
+} emit;
+
+//start writing to f
+void emInit(emit *e, FILE *f);
+
+//write the string s
+void emStr(emit *e, const char *s);
+
+//write v in decimal
+void emInt(emit *e, long long v);
+
+//write v with 3 decimals
+void emDbl(emit *e, double v);
+
+//write what is buffered to the file
+void emFlush(emit *e);
+
+#endif
@@ -0,0 +1,56 @@
+/**
+*		    Filename:  fifo.c
+*    Description:  O(1) queues of process ids linked through one array
+*        Version:  1.0
+*        Created:  10.18.2026 23h58min20s
+*         Author:  Ningyuan Zhang （狮子劫博丽）(elithz), elithz@iastate.edu
+*        Company:  NERVE Software
+*/
+
+#include "fifo.h"
+
+void fqInit(fifo *q, int *next)
+{
+  q->next = next;
+  q->head = q->tail = -1;
+  q->size = 0;
+}
+
+void fqPush(fifo *q, int id)
+{
+  q->next[id] = -1;
+  if (q->tail < 0)
+    q->head = id;
+  else
+    q->next[q->tail] = id;
+  q->tail = id;
+  q->size++;
+}
+
+int fqPop(fifo *q)
+{
+  //id taken
+  int id = q->head;
+
+  if (id < 0)
+    return -1;
+  q->head = q->next[id];
+  if (q->head < 0)
+    q->tail = -1;
+  q->size--;
+  return id;
+}
+
+void fqCat(fifo *dst, fifo *src)
+{
+  if (src->head < 0)
+    return;
+  if (dst->tail < 0)
+    dst->head = src->head;
+  else
+    dst->next[dst->tail] = src->head;
+  dst->tail = src->tail;
+  dst->size += src->size;
+  src->head = src->tail = -1;
+  src->size = 0;
+}
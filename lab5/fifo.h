@@ -0,0 +1,46 @@
+/**
+*		    Filename:  fifo.h
+*    Description:  O(1) queues of process ids linked through one array
+*        Version:  1.0
+*        Created:  10.18.2026 23h58min20s
+*         Author:  Ningyuan Zhang （狮子劫博丽）(elithz), elithz@iastate.edu
+*        Company:  NERVE Software
+*/
+
+/*
+ *  A process waits in at most one queue at a time, so the queues of a
+ *  policy share a single next array indexed by process id instead of
+ *  each holding a buffer: the levels of a multilevel queue cost a head
+ *  and a tail each. Push and pop are O(1), and so is appending a whole
+ *  queue to another.
+ */
+
+#ifndef FIFO
+#define FIFO
+
+//a queue
+typedef struct fifo_struct
+{
+  //links shared with the other queues over the same ids
+  int *next;
+  //first and last id, -1 = empty
+  int head;
+  int tail;
+  //ids queued
+  int size;
+} fifo;
+
+//make an empty queue over the links next
+void fqInit(fifo *q, int *next);
+
+//add id at the tail
+void fqPush(fifo *q, int id);
+
+//take the id at the head, -1 = queue empty
+int fqPop(fifo *q);
+
+//move every id of src to the tail of dst in O(1), src is left empty,
+//both must share the links
+void fqCat(fifo *dst, fifo *src);
+
+#endif
@@ -0,0 +1,158 @@
+/**
+*		    Filename:  heap.c
+*    Description:  binary min-heap shared by the event list and ready queues
+*        Version:  1.0
+*        Created:  10.18.2026 22h31min05s
+*         Author:  Ningyuan Zhang （狮子劫博丽）(elithz), elithz@iastate.edu
+*        Company:  NERVE Software
+*/
+
+#include "heap.h"
+#include <stdlib.h>
+
+//1 if item a comes out before item b
+static int hpLess(hpItem *a, hpItem *b)
+{
+  if (a->key != b->key)
+    return a->key < b->key;
+  if (a->sub != b->sub)
+    return a->sub < b->sub;
+  return a->id < b->id;
+}
+
+//put it in slot i
+static void hpSet(heap *hp, int i, hpItem *it)
+{
+  hp->items[i] = *it;
+  if (hp->pos)
+    hp->pos[it->id] = i;
+}
+
+//move it up from slot i to where it belongs
+static void hpUp(heap *hp, int i, hpItem it)
+{
+  //parent slot
+  int up;
+
+  for (; i > 0; i = up)
+  {
+    up = (i - 1) / 2;
+    if (!hpLess(&it, &hp->items[up]))
+      break;
+    hpSet(hp, i, &hp->items[up]);
+  }
+  hpSet(hp, i, &it);
+}
+
+//move it down from slot i to where it belongs
+static void hpDown(heap *hp, int i, hpItem it)
+{
+  //smaller child slot
+  int down;
+
+  for (; (down = i * 2 + 1) < hp->size; i = down)
+  {
+    if (down + 1 < hp->size && hpLess(&hp->items[down + 1], &hp->items[down]))
+      down++;
+    if (!hpLess(&hp->items[down], &it))
+      break;
+    hpSet(hp, i, &hp->items[down]);
+  }
+  hpSet(hp, i, &it);
+}
+
+int hpInit(heap *hp, int cap)
+{
+  if (cap < 1)
+    cap = 1;
+  hp->items = malloc(cap * sizeof(hpItem));
+  hp->size = 0;
+  hp->cap = hp->items ? cap : 0;
+  hp->pos = NULL;
+  return hp->items ? 0 : -1;
+}
+
+int hpInitIdx(heap *hp, int cap, int ids)
+{
+  //counter
+  int i;
+
+  if (hpInit(hp, cap))
+    return -1;
+  hp->pos = malloc((ids + 1) * sizeof(int));
+  if (!hp->pos)
+  {
+    hpFree(hp);
+    return -1;
+  }
+  for (i = 0; i < ids; i++)
+    hp->pos[i] = -1;
+  return 0;
+}
+
+int hpPush(heap *hp, long long key, long long sub, int id)
+{
+  //new item and grown array
+  hpItem it, *grown;
+
+  if (hp->size == hp->cap)
+  {
+    grown = realloc(hp->items, hp->cap * 2 * sizeof(hpItem));
+    if (!grown)
+      return -1;
+    hp->items = grown;
+    hp->cap *= 2;
+  }
+  it.key = key;
+  it.sub = sub;
+  it.id = id;
+  hpUp(hp, hp->size++, it);
+  return 0;
+}
+
+int hpPop(heap *hp, hpItem *it)
+{
+  if (!hp->size)
+    return -1;
+  *it = hp->items[0];
+  if (hp->pos)
+    hp->pos[it->id] = -1;
+  if (--hp->size)
+    hpDown(hp, 0, hp->items[hp->size]);
+  return 0;
+}
+
+int hpDel(heap *hp, int id)
+{
+  //slot of the item
+  int i = hp->pos[id];
+  //item moved in from the end
+  hpItem last;
+
+  if (i < 0)
+    return -1;
+  hp->pos[id] = -1;
+  if (i == --hp->size)
+    return 0;
+  last = hp->items[hp->size];
+  //the last item may belong above or below the hole
+  if (i > 0 && hpLess(&last, &hp->items[(i - 1) / 2]))
+    hpUp(hp, i, last);
+  else
+    hpDown(hp, i, last);
+  return 0;
+}
+
+hpItem *hpTop(heap *hp)
+{
+  return hp->size ? &hp->items[0] : NULL;
+}
+
+void hpFree(heap *hp)
+{
+  free(hp->items);
+  free(hp->pos);
+  hp->items = NULL;
+  hp->pos = NULL;
+  hp->size = hp->cap = 0;
+}
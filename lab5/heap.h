@@ -0,0 +1,64 @@
+/**
+*		    Filename:  heap.h
+*    Description:  binary min-heap shared by the event list and ready queues
+*        Version:  1.0
+*        Created:  10.18.2026 22h31min05s
+*         Author:  Ningyuan Zhang （狮子劫博丽）(elithz), elithz@iastate.edu
+*        Company:  NERVE Software
+*/
+
+/*
+ *  Items are ordered by key, then sub, then id, so equal keys come out
+ *  in a fixed order and every run of the simulator is reproducible. The
+ *  event list keys on time with the event kind as sub, the FCFS and SJF
+ *  ready queues key on arrival time and runtime. An indexed heap also
+ *  tracks the slot of every id so an item can be removed by id in
+ *  O(log n), ids must then be below the count given and unique in the
+ *  heap: the event list cancels the completion of a preempted process.
+ */
+
+#ifndef HEAP
+#define HEAP
+
+//an item
+typedef struct hpItem_struct
+{
+  long long key;
+  long long sub;
+  int id;
+} hpItem;
+
+//a heap
+typedef struct heap_struct
+{
+  hpItem *items;
+  int size;
+  int cap;
+  //slot of each id, NULL = not indexed
+  int *pos;
+} heap;
+
+//make a heap with room for cap items, ret 0 = success, -1 = no memory
+int hpInit(heap *hp, int cap);
+
+//make a heap of ids 0..ids-1 that can be removed by id
+//ret 0 = success, -1 = no memory
+int hpInitIdx(heap *hp, int cap, int ids);
+
+//add an item, the heap grows as needed, ret 0 = success, -1 = no memory
+int hpPush(heap *hp, long long key, long long sub, int id);
+
+//take the smallest item into it, ret 0 = success, -1 = heap empty
+int hpPop(heap *hp, hpItem *it);
+
+//remove the item of id from an indexed heap, ret 0 = success, -1 = not
+//in the heap
+int hpDel(heap *hp, int id);
+
+//smallest item, NULL = heap empty
+hpItem *hpTop(heap *hp);
+
+//free the heap
+void hpFree(heap *hp);
+
+#endif
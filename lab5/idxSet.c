@@ -0,0 +1,121 @@
+/**
+*		    Filename:  idxSet.c
+*    Description:  set of process ids with ordered next lookup
+*        Version:  1.0
+*        Created:  10.18.2026 22h38min44s
+*         Author:  Ningyuan Zhang （狮子劫博丽）(elithz), elithz@iastate.edu
+*        Company:  NERVE Software
+*/
+
+#include "idxSet.h"
+#include <stdlib.h>
+
+//most levels, 64^6 ids
+#define IS_MAX_LEVELS 6
+
+int isInit(idxSet *set, int n)
+{
+  //counter and words of the level
+  int lv, words;
+
+  set->n = n;
+  set->map = calloc(IS_MAX_LEVELS, sizeof(unsigned long long *));
+  if (!set->map)
+    return -1;
+  //every level has a bit per word of the level below, down to one word
+  words = n;
+  for (lv = 0; lv < IS_MAX_LEVELS; lv++)
+  {
+    words = (words + 63) / 64;
+    if (!words)
+      words = 1;
+    set->map[lv] = calloc(words, sizeof(unsigned long long));
+    if (!set->map[lv])
+    {
+      set->lvNum = lv;
+      isFree(set);
+      return -1;
+    }
+    if (words == 1)
+      break;
+  }
+  set->lvNum = lv + 1;
+  return 0;
+}
+
+void isAdd(idxSet *set, int i)
+{
+  //counter and word that was empty
+  int lv, empty;
+
+  for (lv = 0; lv < set->lvNum; lv++, i >>= 6)
+  {
+    empty = !set->map[lv][i >> 6];
+    set->map[lv][i >> 6] |= 1ULL << (i & 63);
+    //the levels above already know about a non-empty word
+    if (!empty)
+      break;
+  }
+}
+
+void isDel(idxSet *set, int i)
+{
+  //counter
+  int lv;
+
+  for (lv = 0; lv < set->lvNum; lv++, i >>= 6)
+  {
+    set->map[lv][i >> 6] &= ~(1ULL << (i & 63));
+    //the word still has ids, the levels above stay set
+    if (set->map[lv][i >> 6])
+      break;
+  }
+}
+
+int isNext(idxSet *set, int i)
+{
+  //counter, word and its ids >= i
+  int lv, w;
+  unsigned long long bits;
+
+  if (i < 0)
+    i = 0;
+  if (i >= set->n)
+    return -1;
+
+  //up until a word has an id at or after i
+  for (lv = 0; lv < set->lvNum; lv++)
+  {
+    w = i >> 6;
+    bits = set->map[lv][w] & (~0ULL << (i & 63));
+    if (bits)
+    {
+      i = (w << 6) + __builtin_ctzll(bits);
+      break;
+    }
+    //the next word on this level is the next bit on the one above
+    i = w + 1;
+    if (lv + 1 == set->lvNum || (i >> 6) > ((set->n - 1) >> (6 * (lv + 2))))
+      return -1;
+  }
+  if (lv == set->lvNum)
+    return -1;
+
+  //down to the first id under the word found
+  while (lv-- > 0)
+    i = (i << 6) + __builtin_ctzll(set->map[lv][i]);
+  return i;
+}
+
+void isFree(idxSet *set)
+{
+  //counter
+  int lv;
+
+  if (!set->map)
+    return;
+  for (lv = 0; lv < set->lvNum; lv++)
+    free(set->map[lv]);
+  free(set->map);
+  set->map = NULL;
+}
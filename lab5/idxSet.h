@@ -0,0 +1,47 @@
+/**
+*		    Filename:  idxSet.h
+*    Description:  set of process ids with ordered next lookup
+*        Version:  1.0
+*        Created:  10.18.2026 22h38min44s
+*         Author:  Ningyuan Zhang （狮子劫博丽）(elithz), elithz@iastate.edu
+*        Company:  NERVE Software
+*/
+
+/*
+ *  The round robins hand the cpu to the next ready process after the
+ *  last one in process id order. The ids are kept in a bitmap with a
+ *  summary bitmap over it, a bit per non-empty word, and so on up to a
+ *  single word, so the next id at or after i is found by walking up and
+ *  down the levels: 4 levels cover 16 million processes.
+ */
+
+#ifndef IDXSET
+#define IDXSET
+
+//a set
+typedef struct idxSet_struct
+{
+  //bitmap of each level, level 0 has a bit per id
+  unsigned long long **map;
+  //levels
+  int lvNum;
+  //ids 0..n-1
+  int n;
+} idxSet;
+
+//make an empty set of ids 0..n-1, ret 0 = success, -1 = no memory
+int isInit(idxSet *set, int n);
+
+//add id i
+void isAdd(idxSet *set, int i);
+
+//remove id i
+void isDel(idxSet *set, int i);
+
+//smallest id >= i in the set, -1 = none
+int isNext(idxSet *set, int i);
+
+//free the set
+void isFree(idxSet *set);
+
+#endif
@@ -0,0 +1,311 @@
+/**
+*		    Filename:  rbTree.c
+*    Description:  red-black tree of process ids ordered by a key
+*        Version:  1.0
+*        Created:  10.19.2026 00h41min09s
+*         Author:  Ningyuan Zhang （狮子劫博丽）(elithz), elithz@iastate.edu
+*        Company:  NERVE Software
+*/
+
+#include "rbTree.h"
+#include <stdlib.h>
+
+//1 if id a goes left of id b
+static int rbLess(rbTree *t, int a, int b)
+{
+  if (t->key[a] != t->key[b])
+    return t->key[a] < t->key[b];
+  return a < b;
+}
+
+//leftmost id under x
+static int rbMin(rbTree *t, int x)
+{
+  while (t->left[x] != t->nil)
+    x = t->left[x];
+  return x;
+}
+
+//id after x in key order, nil = none
+static int rbNext(rbTree *t, int x)
+{
+  //parent walked up to
+  int y;
+
+  if (t->right[x] != t->nil)
+    return rbMin(t, t->right[x]);
+  for (y = t->parent[x]; y != t->nil && x == t->right[y]; y = t->parent[y])
+    x = y;
+  return y;
+}
+
+//put y where x is, y = x's right child
+static void rbRotL(rbTree *t, int x)
+{
+  //child moving up
+  int y = t->right[x];
+
+  t->right[x] = t->left[y];
+  if (t->left[y] != t->nil)
+    t->parent[t->left[y]] = x;
+  t->parent[y] = t->parent[x];
+  if (t->parent[x] == t->nil)
+    t->root = y;
+  else if (x == t->left[t->parent[x]])
+    t->left[t->parent[x]] = y;
+  else
+    t->right[t->parent[x]] = y;
+  t->left[y] = x;
+  t->parent[x] = y;
+}
+
+//put y where x is, y = x's left child
+static void rbRotR(rbTree *t, int x)
+{
+  //child moving up
+  int y = t->left[x];
+
+  t->left[x] = t->right[y];
+  if (t->right[y] != t->nil)
+    t->parent[t->right[y]] = x;
+  t->parent[y] = t->parent[x];
+  if (t->parent[x] == t->nil)
+    t->root = y;
+  else if (x == t->right[t->parent[x]])
+    t->right[t->parent[x]] = y;
+  else
+    t->left[t->parent[x]] = y;
+  t->right[y] = x;
+  t->parent[x] = y;
+}
+
+//hang v where u hangs
+static void rbSwap(rbTree *t, int u, int v)
+{
+  if (t->parent[u] == t->nil)
+    t->root = v;
+  else if (u == t->left[t->parent[u]])
+    t->left[t->parent[u]] = v;
+  else
+    t->right[t->parent[u]] = v;
+  t->parent[v] = t->parent[u];
+}
+
+int rbInit(rbTree *t, int n)
+{
+  t->key = malloc((n + 1) * sizeof(long long));
+  t->left = malloc((n + 1) * sizeof(int));
+  t->right = malloc((n + 1) * sizeof(int));
+  t->parent = malloc((n + 1) * sizeof(int));
+  t->red = malloc(n + 1);
+  if (!t->key || !t->left || !t->right || !t->parent || !t->red)
+  {
+    rbFree(t);
+    return -1;
+  }
+  t->nil = t->root = t->first = n;
+  t->red[n] = 0;
+  t->size = 0;
+  return 0;
+}
+
+void rbShare(rbTree *t, rbTree *from)
+{
+  *t = *from;
+  t->root = t->first = t->nil;
+  t->size = 0;
+}
+
+void rbInsert(rbTree *t, int id, long long key)
+{
+  //node walked down and its parent, uncle while fixing
+  int x = t->root, y = t->nil, u;
+
+  t->key[id] = key;
+  while (x != t->nil)
+  {
+    y = x;
+    x = rbLess(t, id, x) ? t->left[x] : t->right[x];
+  }
+  t->parent[id] = y;
+  if (y == t->nil)
+    t->root = id;
+  else if (rbLess(t, id, y))
+    t->left[y] = id;
+  else
+    t->right[y] = id;
+  t->left[id] = t->right[id] = t->nil;
+  t->red[id] = 1;
+  if (t->first == t->nil || rbLess(t, id, t->first))
+    t->first = id;
+  t->size++;
+
+  //no red node with a red parent
+  for (x = id; t->red[t->parent[x]];)
+  {
+    y = t->parent[x];
+    if (y == t->left[t->parent[y]])
+    {
+      u = t->right[t->parent[y]];
+      if (t->red[u])
+      {
+        t->red[y] = t->red[u] = 0;
+        t->red[t->parent[y]] = 1;
+        x = t->parent[y];
+        continue;
+      }
+      if (x == t->right[y])
+      {
+        x = y;
+        rbRotL(t, x);
+        y = t->parent[x];
+      }
+      t->red[y] = 0;
+      t->red[t->parent[y]] = 1;
+      rbRotR(t, t->parent[y]);
+    }
+    else
+    {
+      u = t->left[t->parent[y]];
+      if (t->red[u])
+      {
+        t->red[y] = t->red[u] = 0;
+        t->red[t->parent[y]] = 1;
+        x = t->parent[y];
+        continue;
+      }
+      if (x == t->left[y])
+      {
+        x = y;
+        rbRotR(t, x);
+        y = t->parent[x];
+      }
+      t->red[y] = 0;
+      t->red[t->parent[y]] = 1;
+      rbRotL(t, t->parent[y]);
+    }
+  }
+  t->red[t->root] = 0;
+}
+
+void rbDelete(rbTree *t, int id)
+{
+  //node taking id's place, node taking y's place, sibling while fixing
+  int y = id, x, w;
+  //color removed from the tree
+  char yRed = t->red[y];
+
+  if (t->first == id)
+    t->first = rbNext(t, id);
+  if (t->left[id] == t->nil)
+  {
+    x = t->right[id];
+    rbSwap(t, id, x);
+  }
+  else if (t->right[id] == t->nil)
+  {
+    x = t->left[id];
+    rbSwap(t, id, x);
+  }
+  else
+  {
+    y = rbMin(t, t->right[id]);
+    yRed = t->red[y];
+    x = t->right[y];
+    if (t->parent[y] == id)
+      t->parent[x] = y;
+    else
+    {
+      rbSwap(t, y, x);
+      t->right[y] = t->right[id];
+      t->parent[t->right[y]] = y;
+    }
+    rbSwap(t, id, y);
+    t->left[y] = t->left[id];
+    t->parent[t->left[y]] = y;
+    t->red[y] = t->red[id];
+  }
+  t->size--;
+  if (yRed)
+    return;
+
+  //a black node left, x carries an extra black up until it can drop it
+  while (x != t->root && !t->red[x])
+  {
+    if (x == t->left[t->parent[x]])
+    {
+      w = t->right[t->parent[x]];
+      if (t->red[w])
+      {
+        t->red[w] = 0;
+        t->red[t->parent[x]] = 1;
+        rbRotL(t, t->parent[x]);
+        w = t->right[t->parent[x]];
+      }
+      if (!t->red[t->left[w]] && !t->red[t->right[w]])
+      {
+        t->red[w] = 1;
+        x = t->parent[x];
+        continue;
+      }
+      if (!t->red[t->right[w]])
+      {
+        t->red[t->left[w]] = 0;
+        t->red[w] = 1;
+        rbRotR(t, w);
+        w = t->right[t->parent[x]];
+      }
+      t->red[w] = t->red[t->parent[x]];
+      t->red[t->parent[x]] = 0;
+      t->red[t->right[w]] = 0;
+      rbRotL(t, t->parent[x]);
+    }
+    else
+    {
+      w = t->left[t->parent[x]];
+      if (t->red[w])
+      {
+        t->red[w] = 0;
+        t->red[t->parent[x]] = 1;
+        rbRotR(t, t->parent[x]);
+        w = t->left[t->parent[x]];
+      }
+      if (!t->red[t->left[w]] && !t->red[t->right[w]])
+      {
+        t->red[w] = 1;
+        x = t->parent[x];
+        continue;
+      }
+      if (!t->red[t->left[w]])
+      {
+        t->red[t->right[w]] = 0;
+        t->red[w] = 1;
+        rbRotL(t, w);
+        w = t->left[t->parent[x]];
+      }
+      t->red[w] = t->red[t->parent[x]];
+      t->red[t->parent[x]] = 0;
+      t->red[t->left[w]] = 0;
+      rbRotR(t, t->parent[x]);
+    }
+    x = t->root;
+  }
+  t->red[x] = 0;
+}
+
+int rbFirst(rbTree *t)
+{
+  return t->first == t->nil ? -1 : t->first;
+}
+
+void rbFree(rbTree *t)
+{
+  free(t->key);
+  free(t->left);
+  free(t->right);
+  free(t->parent);
+  free(t->red);
+  t->key = NULL;
+  t->left = t->right = t->parent = NULL;
+  t->red = NULL;
+}
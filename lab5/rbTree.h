@@ -0,0 +1,61 @@
+/**
+*		    Filename:  rbTree.h
+*    Description:  red-black tree of process ids ordered by a key
+*        Version:  1.0
+*        Created:  10.19.2026 00h41min09s
+*         Author:  Ningyuan Zhang （狮子劫博丽）(elithz), elithz@iastate.edu
+*        Company:  NERVE Software
+*/
+
+/*
+ *  The nodes are the process ids themselves: every field is an array
+ *  indexed by id, id n is the black sentinel leaf, so inserting a
+ *  process allocates nothing. Ties on the key go to the lower id. The
+ *  leftmost id is cached as in the Linux scheduler, so the fair share
+ *  policy reads its next process in O(1) and inserts and removes in
+ *  O(log n). Trees can share the arrays as long as an id is in at most
+ *  one of them, the per-cpu ready queues of the fair share policy do.
+ */
+
+#ifndef RBTREE
+#define RBTREE
+
+//a tree
+typedef struct rbTree_struct
+{
+  //key of each id while it is in the tree
+  long long *key;
+  //links of each id, nil when there is none
+  int *left;
+  int *right;
+  int *parent;
+  //1 = red
+  char *red;
+  //root, sentinel and leftmost id
+  int root;
+  int nil;
+  int first;
+  //ids in the tree
+  int size;
+} rbTree;
+
+//make an empty tree of ids 0..n-1, ret 0 = success, -1 = no memory
+int rbInit(rbTree *t, int n);
+
+//make an empty tree on the arrays of from, an id may be in only one of
+//the trees sharing them, only from is freed
+void rbShare(rbTree *t, rbTree *from);
+
+//add id with key, id must not be in the tree
+void rbInsert(rbTree *t, int id, long long key);
+
+//remove id, which must be in the tree
+void rbDelete(rbTree *t, int id);
+
+//id with the smallest key, -1 = tree empty
+int rbFirst(rbTree *t);
+
+//free the tree
+void rbFree(rbTree *t);
+
+#endif
@@ -8,365 +8,915 @@
 */
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
-
+#include "sim.h"
+#include "heap.h"
+#include "idxSet.h"
+#include "fifo.h"
+#include "rbTree.h"
+#include "sweep.h"
+#include "workload.h"
+#include <limits.h>
+#include <unistd.h>
+
+/* Processes generated when -n is not given */
 #define NUM_PROCESSES 20
+/* Most processes -n takes, arrivals go up to 5 ticks per process */
+#define MAX_PROCESSES 100000000
+/* Levels of the multilevel feedback queue and time between its boosts
+   when -l, -m and -b are not given */
+#define MLFQ_LEVELS 3
+#define MLFQ_BOOST 100
+/* Minimum granularity of the fair share policy when -g is not given, it
+   aims to run every process once per CFS_NR_LATENCY granularities */
+#define CFS_GRAN 2
+#define CFS_NR_LATENCY 8
+/* vruntime is kept in 1/1024 of a tick of a nice 0 process */
+#define CFS_SHIFT 10
+#define CFS_NICE_0 1024
+/* Nice levels between two priorities */
+#define CFS_NICE_STEP 5
+
+/* Weight of nice -20..19 from the Linux scheduler, each nice level is
+   about 10% more or less cpu */
+static const int cfs_weights[40] = {
+    88761, 71755, 56483, 46273, 36291, 29154, 23254, 18705, 14949, 11916,
+    9548, 7620, 6100, 4904, 3906, 3121, 2501, 1991, 1586, 1277,
+    1024, 820, 655, 526, 423, 335, 272, 215, 172, 137,
+    110, 87, 70, 56, 45, 36, 29, 23, 18, 15};
+
+/* Ready queue of round robin, ids in order of arrival or expiry */
+struct rr_queue
+{
+  fifo ready;
+  int *next;
+};
 
-struct process
+/* Ready queue of round robin with priority, a set of ready ids per
+   priority */
+struct prio_queue
 {
-  /* Values initialized for each process */
-  int arrivaltime; /* Time process arrives and wishes to start */
-  int runtime;     /* Time process requires to complete job */
-  int priority;    /* Priority of the process */
+  idxSet level[PRIO_LEVELS];
+  /* id after the last process run, the search for the next starts here */
+  int next;
+};
 
-  /* Values algorithm may use to track processes */
-  int starttime;
-  int endtime;
-  int flag;
-  int remainingtime;
+/* Ready queue of the multilevel feedback queue, level 0 on top */
+struct mlfq_queue
+{
+  fifo level[MLFQ_MAX_LEVELS];
+  int *next;
+  /* bit l set = level l has a process */
+  unsigned long long busy;
+  int levels;
+  int quanta[MLFQ_MAX_LEVELS];
+  /* level of each process and how much of its quantum it used */
+  int *lv;
+  int *used;
+  /* boosts so far and the boost the level of each process is from */
+  int boosts;
+  int *epoch;
 };
 
-/* Forward declarations of Scheduling algorithms */
-void first_come_first_served(struct process *proc);
-void shortest_remaining_time(struct process *proc);
-void round_robin(struct process *proc);
-void round_robin_priority(struct process *proc);
+static void mlfq_free(sim *s);
 
-int main()
+/* Ready queue of the fair share policy, ready processes by vruntime */
+struct cfs_queue
 {
-  int i;
-  struct process proc[NUM_PROCESSES], /* List of processes */
-      proc_copy[NUM_PROCESSES];       /* Backup copy of processes */
+  rbTree tree;
+  /* vruntime of each process */
+  long long *vr;
+  /* never decreasing floor new processes start at */
+  long long minVr;
+  /* total weight of the processes arrived and not finished */
+  long long load;
+};
 
-  /* Seed random number generator */
-  /*srand(time(0));*/ /* Use this seed to test different scenarios */
-  srand(0xC0FFEE);    /* Used for test to be printed out */
+/* Forward declarations of Scheduling algorithms */
+int first_come_first_served(workload *wl, simOpt *opt, simStats *st);
+int shortest_job_first(workload *wl, simOpt *opt, simStats *st);
+int shortest_remaining_time(workload *wl, simOpt *opt, simStats *st);
+int round_robin(workload *wl, simOpt *opt, simStats *st);
+int round_robin_priority(workload *wl, simOpt *opt, simStats *st);
+int multilevel_feedback_queue(workload *wl, simOpt *opt, simStats *st);
+int completely_fair(workload *wl, simOpt *opt, simStats *st);
+
+/* Scheduling algorithms in the order they run */
+static const swAlgo algos[] = {
+    {"First come first served", first_come_first_served},
+    {"Shortest job first", shortest_job_first},
+    {"Shortest remaining time", shortest_remaining_time},
+    {"Round Robin", round_robin},
+    {"Round Robin with priority", round_robin_priority},
+    {"Multilevel feedback queue", multilevel_feedback_queue},
+    {"Completely fair", completely_fair}};
+#define ALGO_NUM (int)(sizeof(algos) / sizeof(algos[0]))
+
+/* Parse a comma-separated list of at most SW_MAX_LIST positive numbers,
+   ret how many, 0 = a bad one */
+static int parse_list(char *arg, double *val)
+{
+  char *tok, *save, *end;
+  int num = 0;
 
-  /* Initialize process structures */
-  for (i = 0; i < NUM_PROCESSES; i++)
+  for (tok = strtok_r(arg, ",", &save); tok; tok = strtok_r(NULL, ",", &save))
   {
-    proc[i].arrivaltime = rand() % 100;
-    proc[i].runtime = (rand() % 30) + 10;
-    proc[i].priority = rand() % 3;
-    proc[i].starttime = 0;
-    proc[i].endtime = 0;
-    proc[i].flag = 0;
-    proc[i].remainingtime = 0;
+    if (num == SW_MAX_LIST)
+      return 0;
+    val[num] = strtod(tok, &end);
+    if (end == tok || *end || !(val[num] > 0))
+      return 0;
+    num++;
   }
+  return num;
+}
 
-  /* Show process values */
-  printf("Process\tarrival\truntime\tpriority\n");
-  for (i = 0; i < NUM_PROCESSES; i++)
-    printf("%d\t%d\t%d\t%d\n", i, proc[i].arrivaltime, proc[i].runtime,
-           proc[i].priority);
+int main(int argc, char **argv)
+{
+  int i, c;
+  /* Processes generated and their seed, or the file they are read from */
+  int n = NUM_PROCESSES;
+  unsigned seed = 0xC0FFEE; /* Used for test to be printed out */
+  char *path = NULL;
+  /* File the records of the processes go to instead of stdout */
+  char *recPath = NULL;
+  /* Where the records of the processes and the summaries go and their
+     format, quanta, boost period, granularity, cpus, migration cost and
+     balance period */
+  simOpt opt = {stdout, stdout, SIM_TEXT, NULL, SIM_QUANTUM, MLFQ_LEVELS,
+                {0}, MLFQ_BOOST, CFS_GRAN, 1, SIM_MIG_COST, SIM_BALANCE};
+  /* Grid of a sweep, no seeds = run once and print everything, and a
+     list being parsed out of -T or -L */
+  swOpt sw = {0};
+  double list[SW_MAX_LIST];
+  /* Quantum being parsed out of -m */
+  char *tok, *save;
+  /* List of processes */
+  workload wl;
+
+  while ((c = getopt(argc, argv, "n:s:f:qt:l:m:b:g:c:M:B:S:T:L:j:F:O:")) != -1)
+  {
+    switch (c)
+    {
+    case 'n':
+      n = atoi(optarg);
+      if (n < 1 || n > MAX_PROCESSES)
+      {
+        fprintf(stderr, "error: bad process count \"%s\"\n", optarg);
+        return 1;
+      }
+      break;
+    case 's':
+      seed = strtoul(optarg, NULL, 0);
+      break;
+    case 'f':
+      path = optarg;
+      break;
+    case 'q':
+      opt.out = NULL;
+      break;
+    case 't':
+      opt.quantum = atoi(optarg);
+      if (opt.quantum < 1)
+      {
+        fprintf(stderr, "error: bad quantum \"%s\"\n", optarg);
+        return 1;
+      }
+      break;
+    case 'l':
+      opt.levels = atoi(optarg);
+      if (opt.levels < 1 || opt.levels > MLFQ_MAX_LEVELS)
+      {
+        fprintf(stderr, "error: bad level count \"%s\"\n", optarg);
+        return 1;
+      }
+      break;
+    case 'm':
+      /* One quantum per level, top first */
+      opt.levels = 0;
+      for (tok = strtok_r(optarg, ",", &save); tok;
+           tok = strtok_r(NULL, ",", &save))
+      {
+        if (opt.levels == MLFQ_MAX_LEVELS || atoi(tok) < 1)
+        {
+          fprintf(stderr, "error: bad quantum \"%s\"\n", tok);
+          return 1;
+        }
+        opt.quanta[opt.levels++] = atoi(tok);
+      }
+      if (!opt.levels)
+      {
+        fprintf(stderr, "error: no quanta\n");
+        return 1;
+      }
+      break;
+    case 'b':
+      opt.boost = atoi(optarg);
+      if (opt.boost < 0)
+      {
+        fprintf(stderr, "error: bad boost period \"%s\"\n", optarg);
+        return 1;
+      }
+      break;
+    case 'g':
+      opt.gran = atoi(optarg);
+      if (opt.gran < 1)
+      {
+        fprintf(stderr, "error: bad granularity \"%s\"\n", optarg);
+        return 1;
+      }
+      break;
+    case 'c':
+      opt.cpus = atoi(optarg);
+      if (opt.cpus < 1 || opt.cpus > SIM_MAX_CPUS)
+      {
+        fprintf(stderr, "error: bad cpu count \"%s\"\n", optarg);
+        return 1;
+      }
+      break;
+    case 'M':
+      opt.migCost = atoi(optarg);
+      if (opt.migCost < 0)
+      {
+        fprintf(stderr, "error: bad migration cost \"%s\"\n", optarg);
+        return 1;
+      }
+      break;
+    case 'B':
+      opt.balance = atoi(optarg);
+      if (opt.balance < 0)
+      {
+        fprintf(stderr, "error: bad balance period \"%s\"\n", optarg);
+        return 1;
+      }
+      break;
+    case 'S':
+      sw.seeds = atoi(optarg);
+      if (sw.seeds < 1)
+      {
+        fprintf(stderr, "error: bad seed count \"%s\"\n", optarg);
+        return 1;
+      }
+      break;
+    case 'T':
+      sw.quantumNum = parse_list(optarg, list);
+      for (i = 0; i < sw.quantumNum; i++)
+        if (list[i] > INT_MAX || (sw.quanta[i] = list[i]) != list[i])
+          sw.quantumNum = 0;
+      if (!sw.quantumNum)
+      {
+        fprintf(stderr, "error: bad quanta\n");
+        return 1;
+      }
+      break;
+    case 'L':
+      sw.loadNum = parse_list(optarg, sw.loads);
+      if (!sw.loadNum)
+      {
+        fprintf(stderr, "error: bad loads\n");
+        return 1;
+      }
+      break;
+    case 'j':
+      sw.threads = atoi(optarg);
+      if (sw.threads < 1)
+      {
+        fprintf(stderr, "error: bad thread count \"%s\"\n", optarg);
+        return 1;
+      }
+      break;
+    case 'F':
+      if (!strcmp(optarg, "text"))
+        opt.format = SIM_TEXT;
+      else if (!strcmp(optarg, "csv"))
+        opt.format = SIM_CSV;
+      else if (!strcmp(optarg, "json"))
+        opt.format = SIM_JSON;
+      else
+      {
+        fprintf(stderr, "error: bad format \"%s\"\n", optarg);
+        return 1;
+      }
+      break;
+    case 'O':
+      recPath = optarg;
+      break;
+    default:
+      fprintf(stderr, "usage: %s [-n processes] [-s seed] [-f workload] "
+                      "[-t quantum] [-l levels] [-m quanta] [-b boost] "
+                      "[-g granularity] [-c cpus] [-M migration cost] "
+                      "[-B balance period] [-F text|csv|json] "
+                      "[-O records] [-q]\n"
+                      "       %s -S seeds [-n processes] [-s seed] "
+                      "[-T quanta] [-L loads] [-j threads] [knobs above]\n",
+              argv[0],
+              argv[0]);
+      return 1;
+    }
+  }
 
-  /* Run scheduling algorithms */
-  printf("\n\nFirst come first served\n");
-  memcpy(proc_copy, proc, NUM_PROCESSES * sizeof(struct process));
-  first_come_first_served(proc_copy);
+  /* Sweep the grid into a table instead of a single run, by default at
+     the quantum given and the load of the generator of a single run */
+  if (sw.seeds)
+  {
+    if (path)
+    {
+      fprintf(stderr, "error: a sweep generates its workloads, no -f\n");
+      return 1;
+    }
+    sw.n = n;
+    sw.seed = seed;
+    if (!sw.quantumNum)
+      sw.quanta[sw.quantumNum++] = opt.quantum;
+    if (!sw.loadNum)
+      sw.loads[sw.loadNum++] = (WL_RUN_MIN + (WL_RUN_RANGE - 1) / 2.0) /
+                               (WL_SPAN * opt.cpus);
+    if (swRun(algos, ALGO_NUM, &sw, &opt, stdout))
+    {
+      fprintf(stderr, "error: out of memory\n");
+      return 1;
+    }
+    return 0;
+  }
+
+  /* Generate or load the processes */
+  if (path ? wlLoad(&wl, path) : wlGen(&wl, n, seed))
+  {
+    if (!path)
+      fprintf(stderr, "error: out of memory\n");
+    return 1;
+  }
+
+  /* Records of the processes to their own file, -q drops them */
+  if (recPath && opt.out)
+  {
+    opt.out = fopen(recPath, "w");
+    if (!opt.out)
+    {
+      fprintf(stderr, "error: cannot write %s\n", recPath);
+      wlFree(&wl);
+      return 1;
+    }
+  }
 
-  printf("\n\nShortest remaining time\n");
-  memcpy(proc_copy, proc, NUM_PROCESSES * sizeof(struct process));
-  shortest_remaining_time(proc_copy);
+  /* Show process values, the structured records carry them */
+  if (opt.out && opt.format == SIM_TEXT)
+  {
+    fprintf(opt.out, "Process\tarrival\truntime\tpriority\n");
+    for (i = 0; i < wl.n; i++)
+      fprintf(opt.out, "%d\t%d\t%d\t%d\n", i, wl.proc[i].arrivaltime,
+              wl.proc[i].runtime, wl.proc[i].priority);
+  }
 
-  printf("\n\nRound Robin\n");
-  memcpy(proc_copy, proc, NUM_PROCESSES * sizeof(struct process));
-  round_robin(proc_copy);
+  /* Run scheduling algorithms, each resets the processes it runs */
+  simHeader(&opt);
+  for (i = 0; i < ALGO_NUM; i++)
+  {
+    if (opt.format == SIM_TEXT)
+      printf("\n\n%s\n", algos[i].name);
+    opt.name = algos[i].name;
+    if (algos[i].run(&wl, &opt, NULL))
+      fprintf(stderr, "error: out of memory\n");
+  }
 
-  printf("\n\nRound Robin with priority\n");
-  memcpy(proc_copy, proc, NUM_PROCESSES * sizeof(struct process));
-  round_robin_priority(proc_copy);
+  if (opt.out && opt.out != stdout)
+    fclose(opt.out);
+  wlFree(&wl);
+  return 0;
+}
 
+//ready queue of FCFS and SJF, a heap
+static int heap_init(sim *s)
+{
+  s->rq = malloc(sizeof(heap));
+  if (!s->rq)
+    return -1;
+  //the processes are spread over the cpus, the heap grows if need be
+  if (hpInit(s->rq, s->n / s->opt->cpus + 1))
+  {
+    free(s->rq);
+    return -1;
+  }
   return 0;
 }
 
-void first_come_first_served(struct process *proc)
-{
-  /* Implement scheduling algorithm here */
-  //counters
-  int i, j;
-  //running total of completion time
-  int totalComRunTime = 0;
-  //average completion time
-  int avgComRunTime;
-  //system time
-  int sysTime = 0;
-  //track of first come
-  int firstCome;
-  //through num processes to execute them
-  for (i = 0; i < NUM_PROCESSES; i++)
+static void heap_free(sim *s)
+{
+  hpFree(s->rq);
+  free(s->rq);
+}
+
+//take the process at the top of the heap
+static int heap_pick(sim *s)
+{
+  hpItem it;
+
+  if (hpPop(s->rq, &it))
+    return -1;
+  return it.id;
+}
+
+//first come, ties by process id
+static int fcfs_ready(sim *s, int pid, int why)
+{
+  return hpPush(s->rq, s->proc[pid].arrivaltime, 0, pid);
+}
+
+//shortest runtime, ties by process id
+static int sjf_ready(sim *s, int pid, int why)
+{
+  return hpPush(s->rq, s->proc[pid].runtime, 0, pid);
+}
+
+//shortest time left, ties by process id, a preempted process is keyed
+//on what it has left
+static int srtf_ready(sim *s, int pid, int why)
+{
+  struct process *p = &s->proc[pid];
+
+  return hpPush(s->rq, p->flag ? p->remainingtime : p->runtime, 0, pid);
+}
+
+//take the cpu when the new process needs less than the running one has
+//left, equal times do not switch
+static int srtf_preempt(sim *s, int pid)
+{
+  struct process *run = &s->proc[s->running];
+
+  return s->proc[pid].runtime < run->remainingtime - (s->now - s->since);
+}
+
+//ready queue of round robin, a fifo
+static int rr_init(sim *s)
+{
+  struct rr_queue *q;
+
+  q = malloc(sizeof(struct rr_queue));
+  if (!q)
+    return -1;
+  //a process is in one queue at a time, the cpus share the links
+  q->next = s->cpu ? ((struct rr_queue *)s->cpus[0].rq)->next
+                   : malloc((s->n + 1) * sizeof(int));
+  if (!q->next)
   {
-    //initialize firstCome
-    firstCome = i;
-    //find first come
-    for (j = 0; j < NUM_PROCESSES; j++)
+    free(q);
+    return -1;
+  }
+  fqInit(&q->ready, q->next);
+  s->rq = q;
+  return 0;
+}
+
+static void rr_free(sim *s)
+{
+  struct rr_queue *q = s->rq;
+
+  if (!s->cpu)
+    free(q->next);
+  free(q);
+}
+
+//arrivals, expired and moved processes join the tail
+static int rr_ready(sim *s, int pid, int why)
+{
+  fqPush(&((struct rr_queue *)s->rq)->ready, pid);
+  return 0;
+}
+
+static int rr_pick(sim *s)
+{
+  return fqPop(&((struct rr_queue *)s->rq)->ready);
+}
+
+static int rr_slice(sim *s, int pid)
+{
+  return s->opt->quantum;
+}
+
+//ready queue of round robin with priority, a set of ids per priority
+static int prio_init(sim *s)
+{
+  struct prio_queue *q;
+  int i;
+
+  q = malloc(sizeof(struct prio_queue));
+  if (!q)
+    return -1;
+  q->next = 0;
+  for (i = 0; i < PRIO_LEVELS; i++)
+    if (isInit(&q->level[i], s->n))
     {
-      //if firstCome is already complete then overwrite it
-      if (proc[firstCome].flag)
-        firstCome = j;
-
-      //if firstCome arrival time is after current process
-      //and current process hasn't been executed
-      //then overwrite it
-      else if (proc[firstCome].arrivaltime > proc[j].arrivaltime && !proc[j].flag)
-        firstCome = j;
+      while (i--)
+        isFree(&q->level[i]);
+      free(q);
+      return -1;
     }
+  s->rq = q;
+  return 0;
+}
 
-    //advance system time if it hasn't caught up to arrival time
-    if (sysTime < proc[firstCome].arrivaltime)
-      sysTime = proc[firstCome].arrivaltime;
-
-    //execute process
-    //set firstCome start time
-    proc[firstCome].starttime = sysTime;
-    //advance system time
-    sysTime += proc[firstCome].runtime;
-    //set firstCome end time
-    proc[firstCome].endtime = sysTime;
-    //track of completion time running total
-    totalComRunTime += (proc[firstCome].endtime - proc[firstCome].arrivaltime);
-    //mark firstCome as completed
-    proc[firstCome].flag = 1;
-
-    printf("Process %d started at time %d\n", firstCome, proc[firstCome].starttime);
-    printf("Process %d finished at time %d\n", firstCome, proc[firstCome].endtime);
-  }
+static void prio_free(sim *s)
+{
+  struct prio_queue *q = s->rq;
+  int i;
+
+  for (i = 0; i < PRIO_LEVELS; i++)
+    isFree(&q->level[i]);
+  free(q);
+}
 
-  //calculate average completion time
-  avgComRunTime = totalComRunTime / NUM_PROCESSES;
+//ready processes wait in the set of their priority
+static int prio_ready(sim *s, int pid, int why)
+{
+  struct prio_queue *q = s->rq;
 
-  printf("Average time from arrival to completion is %d seconds\n", avgComRunTime);
+  isAdd(&q->level[s->proc[pid].priority], pid);
+  return 0;
 }
 
-void shortest_remaining_time(struct process *proc)
+//highest priority first, within it the next id after the last process
+//run, wrapping around to the lowest
+static int prio_pick(sim *s)
 {
-  /* Implement scheduling algorithm here */
-  //counters
-  int i, j;
-  //running total of completion time
-  int totalComRunTime = 0;
-  //average completion time
-  int avgComRunTime;
-  //system time
-  int sysTime = 0;
-  //track of first come
-  int shortestRemainTime;
+  struct prio_queue *q = s->rq;
+  int i, pid;
 
-  //through num processes to execute them
-  for (i = 0; i < NUM_PROCESSES; i++)
+  for (i = PRIO_LEVELS - 1; i >= 0; i--)
   {
-    //initialize shortestRemainTime
-    shortestRemainTime = -1;
-    //find shortest remaining time
-    for (j = 0; j < NUM_PROCESSES; j++)
+    pid = isNext(&q->level[i], q->next);
+    if (pid < 0)
+      pid = isNext(&q->level[i], 0);
+    if (pid >= 0)
     {
-      //if shortest_remaining time hasn't been set, the
-      //current process has arrived (arrival time <= system
-      //time) then overwrite it, and the current process
-      //hasn't finished
-      if (shortestRemainTime < 0 && proc[j].arrivaltime <= sysTime && !proc[j].flag)
-        shortestRemainTime = j;
-      //else if shortest remaining time has been set, the
-      //current process has arrived, the current process
-      //runtime is shorter than shortest remaining time, and
-      //current process hasn't finished than overwrite it
-      else if (shortestRemainTime >= 0 && proc[j].arrivaltime <= sysTime && proc[j].runtime < proc[shortestRemainTime].runtime && !proc[j].flag)
-        shortestRemainTime = j;
+      isDel(&q->level[i], pid);
+      q->next = pid + 1;
+      return pid;
     }
+  }
+  return -1;
+}
 
-    //if no process was found advance system time and continue
-    if (shortestRemainTime < 0)
-    {
-      sysTime++;
-      i--;
-      continue;
-    }
+//ready queue of the multilevel feedback queue, a fifo per level
+static int mlfq_init(sim *s)
+{
+  struct mlfq_queue *q, *own;
+  int i;
 
-    //execute process
-    //set shortestRemainTime start time
-    proc[shortestRemainTime].starttime = sysTime;
-    //advance system time
-    sysTime += proc[shortestRemainTime].runtime;
-    //set shortestRemainTime end time
-    proc[shortestRemainTime].endtime = sysTime;
-    //track of completion time running total
-    totalComRunTime += (proc[shortestRemainTime].endtime - proc[shortestRemainTime].arrivaltime);
-    //mark shortestRemainTime as completed
-    proc[shortestRemainTime].flag = 1;
-
-    printf("Process %d started at time %d\n", shortestRemainTime, proc[shortestRemainTime].starttime);
-    printf("Process %d finished at time %d\n", shortestRemainTime, proc[shortestRemainTime].endtime);
+  q = calloc(1, sizeof(struct mlfq_queue));
+  if (!q)
+    return -1;
+  //the cpus share the links and the levels of the processes, the boosts
+  //come at once on all of them so their counts stay equal
+  if (s->cpu)
+  {
+    own = s->cpus[0].rq;
+    q->next = own->next;
+    q->lv = own->lv;
+    q->used = own->used;
+    q->epoch = own->epoch;
+  }
+  else
+  {
+    q->next = malloc((s->n + 1) * sizeof(int));
+    q->lv = malloc((s->n + 1) * sizeof(int));
+    q->used = malloc((s->n + 1) * sizeof(int));
+    q->epoch = malloc((s->n + 1) * sizeof(int));
+  }
+  if (!q->next || !q->lv || !q->used || !q->epoch)
+  {
+    s->rq = q;
+    mlfq_free(s);
+    return -1;
   }
+  q->levels = s->opt->levels;
+  for (i = 0; i < q->levels; i++)
+  {
+    fqInit(&q->level[i], q->next);
+    //the quantum doubles on each level down unless given
+    if (s->opt->quanta[i])
+      q->quanta[i] = s->opt->quanta[i];
+    else if (!i)
+      q->quanta[i] = s->opt->quantum;
+    else
+      q->quanta[i] = q->quanta[i - 1] > INT_MAX / 2 ? INT_MAX
+                                                      : q->quanta[i - 1] * 2;
+  }
+  s->rq = q;
+  return 0;
+}
 
-  //calculate average completion time
-  avgComRunTime = totalComRunTime / NUM_PROCESSES;
+static void mlfq_free(sim *s)
+{
+  struct mlfq_queue *q = s->rq;
+
+  if (!s->cpu)
+  {
+    free(q->next);
+    free(q->lv);
+    free(q->used);
+    free(q->epoch);
+  }
+  free(q);
+}
 
-  printf("Average time from arrival to completion is %d seconds\n", avgComRunTime);
+//level of pid, a process not seen since the last boost is back on top
+static int mlfq_level(struct mlfq_queue *q, int pid)
+{
+  if (q->epoch[pid] != q->boosts)
+  {
+    q->epoch[pid] = q->boosts;
+    q->lv[pid] = 0;
+    q->used[pid] = 0;
+  }
+  return q->lv[pid];
 }
 
-void round_robin(struct process *proc)
+//arrivals start on top, a process that used up the quantum of its level
+//moves a level down, a preempted or moved one keeps its level and what
+//it used
+static int mlfq_ready(sim *s, int pid, int why)
 {
-  /* Implement scheduling algorithm here */
+  struct mlfq_queue *q = s->rq;
+  int l;
 
-  //counters
-  int i, j = 0;
-  //which process id we searched first at current system time
-  int startJ = 0;
-  //running total of completion time
-  int totalComRunTime = 0;
-  //average completion time
-  int avgComRunTime;
-  //system time
-  int sysTime = 0;
-  //0 until a job completes
-  int procFinish;
-  //through till all processes have completed
-  for (i = 0; i < NUM_PROCESSES; i++)
+  if (why == SIM_NEW)
   {
-    //initialize procFinish
-    procFinish = 0;
-    while (!procFinish)
+    q->epoch[pid] = q->boosts;
+    q->lv[pid] = q->used[pid] = 0;
+  }
+  else if (why == SIM_MOVED)
+    mlfq_level(q, pid);
+  else
+  {
+    l = mlfq_level(q, pid);
+    q->used[pid] += s->now - s->since;
+    if (q->used[pid] >= q->quanta[l])
     {
-      //if proc[j] has arrived and has not completed then run it for 1 second
-      if (proc[j].arrivaltime <= sysTime && proc[j].flag != 2)
-      {
-        //if proc[j] just started running initialize it
-        if (!proc[j].flag)
-        {
-          proc[j].flag = 1; //process started
-          proc[j].starttime = sysTime;
-          proc[j].remainingtime = proc[j].runtime - 1;
-        }
-
-        //else update process
-        else
-        {
-          proc[j].remainingtime--;
-          //if proc is finished update proc
-          if (!proc[j].remainingtime)
-          {
-            //process has completed
-            proc[j].flag = 2;
-            proc[j].endtime = sysTime + 1;
-            procFinish = 1;
-            totalComRunTime += (proc[j].endtime - proc[j].arrivaltime);
-            printf("Process %d started at "
-                   "time %d\n",
-                   j, proc[j].starttime);
-            printf("Process %d finished "
-                   "at time %d\n",
-                   j, proc[j].endtime);
-          }
-        }
-        //update j and increment system time
-        j = (j < (NUM_PROCESSES - 1)) ? (j + 1) : 0;
-        sysTime++;
-        startJ = j;
-      }
-      //if proc[j] can't be ran
-      else
-      {
-        //update j
-        j = (j < (NUM_PROCESSES - 1)) ? (j + 1) : 0;
-        //if j = startJ then increment system time since no process could be run at this time
-        if (j == startJ)
-          sysTime++;
-      }
+      q->used[pid] = 0;
+      if (l < q->levels - 1)
+        q->lv[pid]++;
     }
   }
+  fqPush(&q->level[q->lv[pid]], pid);
+  q->busy |= 1ULL << q->lv[pid];
+  return 0;
+}
 
-  //calculate average completion time
-  avgComRunTime = totalComRunTime / NUM_PROCESSES;
-
-  printf("Average time from arrival to completion is %d seconds\n", avgComRunTime);
-}
-
-void round_robin_priority(struct process *proc)
-{
-  /* Implement scheduling algorithm here */
-  //counters
-  int i, j = 0;
-  //which process id we searched first at current system time
-  int startJ = 0;
-  //running total of completion time
-  int totalComRunTime = 0;
-  //average completion time
-  int avgComRunTime;
-  //system time
-  int sysTime = 0;
-  //0 until a job completes
-  int procFinish;
-  //stores highest priority
-  int greatPrior;
-  //stores last executed process
-  int lastExec = 0;
-  //through till all processes have completed
-  for (i = 0; i < NUM_PROCESSES; i++)
+//head of the highest level with a process
+static int mlfq_pick(sim *s)
+{
+  struct mlfq_queue *q = s->rq;
+  int l, pid;
+
+  if (!q->busy)
+    return -1;
+  l = __builtin_ctzll(q->busy);
+  pid = fqPop(&q->level[l]);
+  if (!q->level[l].size)
+    q->busy &= ~(1ULL << l);
+  return pid;
+}
+
+//what is left of the quantum of its level
+static int mlfq_slice(sim *s, int pid)
+{
+  struct mlfq_queue *q = s->rq;
+  int l = mlfq_level(q, pid);
+
+  return q->quanta[l] - q->used[pid];
+}
+
+//an arrival is on top, so it takes the cpu from any lower level
+static int mlfq_preempt(sim *s, int pid)
+{
+  return mlfq_level(s->rq, s->running) > 0;
+}
+
+static int mlfq_period(sim *s)
+{
+  return s->opt->boost;
+}
+
+//every process back on top: the levels are appended to the top one in
+//order and the level of each process is reset when it is next looked at
+static void mlfq_boost(sim *s)
+{
+  struct mlfq_queue *q = s->rq;
+  int l;
+
+  q->boosts++;
+  for (l = 1; l < q->levels; l++)
+    fqCat(&q->level[0], &q->level[l]);
+  q->busy = q->level[0].size ? 1 : 0;
+}
+
+//ready queue of the fair share policy
+static int cfs_init(sim *s)
+{
+  struct cfs_queue *q, *own;
+
+  q = calloc(1, sizeof(struct cfs_queue));
+  if (!q)
+    return -1;
+  //the cpus share the vruntimes and the nodes of the trees
+  if (s->cpu)
   {
-    //initialize procFinish
-    procFinish = 0;
-    while (!procFinish)
-    {
-      //initialize greatPrior
-      greatPrior = -1;
-      do
-      {
-        //if proc[j] has arrived, is not done, and highest priority has not been set, set highest priority
-        if (proc[j].arrivaltime <= sysTime && greatPrior < 0 && proc[j].flag < 2)
-          greatPrior = j;
-
-        //if proc[j] has arrived, is not done, and is of higher priority than highest priority, update greatPrior
-        else if (proc[j].arrivaltime <= sysTime && proc[j].flag < 2 && proc[j].priority > proc[greatPrior].priority)
-          greatPrior = j;
-        j = (j < (NUM_PROCESSES - 1)) ? (j + 1) : 0;
-      } while (j != startJ);
-
-      //if highest_priority has been set execute
-      if (greatPrior > -1)
-      {
-        lastExec = greatPrior;
-        //if greatPrior just started running initialize it
-        if (!proc[greatPrior].flag)
-        {
-          //process started
-          proc[greatPrior].flag = 1;
-          proc[greatPrior].starttime = sysTime;
-          proc[greatPrior].remainingtime = proc[greatPrior].runtime - 1;
-        }
+    own = s->cpus[0].rq;
+    q->vr = own->vr;
+    rbShare(&q->tree, &own->tree);
+    s->rq = q;
+    return 0;
+  }
+  q->vr = malloc((s->n + 1) * sizeof(long long));
+  if (!q->vr || rbInit(&q->tree, s->n))
+  {
+    free(q->vr);
+    free(q);
+    return -1;
+  }
+  s->rq = q;
+  return 0;
+}
 
-        //else update process
-        else
-        {
-          proc[greatPrior].remainingtime--;
-
-          //if proc is finished, update proc
-          if (!proc[greatPrior].remainingtime)
-          {
-            //process has completed
-            proc[greatPrior].flag = 2;
-            proc[greatPrior].endtime = sysTime + 1;
-            procFinish = 1;
-            totalComRunTime += (proc[greatPrior].endtime - proc[greatPrior].arrivaltime);
-            printf("Process %d started at "
-                   "time %d\n",
-                   greatPrior, proc[greatPrior].starttime);
-            printf("Process %d finished "
-                   "at time %d\n",
-                   greatPrior, proc[greatPrior].endtime);
-          }
-        }
-      }
-      //increment system time and set j to search from current highest priority job
-      sysTime++;
-      if (lastExec == NUM_PROCESSES - 1)
-        startJ = j = 0;
-      else
-        startJ = j = (lastExec + 1);
-    }
+static void cfs_free(sim *s)
+{
+  struct cfs_queue *q = s->rq;
+
+  if (!s->cpu)
+  {
+    rbFree(&q->tree);
+    free(q->vr);
+  }
+  free(q);
+}
+
+//weight of pid, priority 1 is nice 0 and each priority step 5 nice levels
+static int cfs_weight(sim *s, int pid)
+{
+  int nice = (PRIO_LEVELS / 2 - s->proc[pid].priority) * CFS_NICE_STEP;
+
+  if (nice < -20)
+    nice = -20;
+  if (nice > 19)
+    nice = 19;
+  return cfs_weights[nice + 20];
+}
+
+//vruntime pid gains by running for ran ticks, slower the heavier it is
+static long long cfs_delta(sim *s, int pid, long long ran)
+{
+  return (ran << (2 * CFS_SHIFT)) / cfs_weight(s, pid);
+}
+
+//raise the floor to the smallest vruntime of the running and ready
+//processes
+static void cfs_floor(sim *s)
+{
+  struct cfs_queue *q = s->rq;
+  int first = rbFirst(&q->tree);
+  long long low;
+
+  if (first < 0 && s->running < 0)
+    return;
+  low = first < 0 ? LLONG_MAX : q->vr[first];
+  if (s->running >= 0 &&
+      q->vr[s->running] + cfs_delta(s, s->running, s->now - s->since) < low)
+    low = q->vr[s->running] + cfs_delta(s, s->running, s->now - s->since);
+  if (low > q->minVr)
+    q->minVr = low;
+}
+
+//arrivals start at the floor so they neither starve the others nor get
+//the cpu for the time they were not there, a process leaving the cpu is
+//charged what it ran, one moving in keeps its lead or lag over the floor
+static int cfs_ready(sim *s, int pid, int why)
+{
+  struct cfs_queue *q = s->rq;
+
+  if (why == SIM_RAN)
+    q->vr[pid] += cfs_delta(s, pid, s->now - s->since);
+  else
+  {
+    q->vr[pid] = why == SIM_NEW ? q->minVr : q->vr[pid] + q->minVr;
+    q->load += cfs_weight(s, pid);
   }
+  rbInsert(&q->tree, pid, q->vr[pid]);
+  cfs_floor(s);
+  return 0;
+}
+
+//smallest vruntime
+static int cfs_pick(sim *s)
+{
+  struct cfs_queue *q = s->rq;
+  int pid = rbFirst(&q->tree);
+
+  if (pid < 0)
+    return -1;
+  rbDelete(&q->tree, pid);
+  //the smallest vruntime and about to run, the floor can come up to it
+  if (q->vr[pid] > q->minVr)
+    q->minVr = q->vr[pid];
+  return pid;
+}
+
+//its weight's share of the period in which every ready process runs
+//once, not less than the granularity
+static int cfs_slice(sim *s, int pid)
+{
+  struct cfs_queue *q = s->rq;
+  long long gran = s->opt->gran, nr = q->tree.size + 1, slice;
+
+  slice = gran * (nr > CFS_NR_LATENCY ? nr : CFS_NR_LATENCY) *
+          cfs_weight(s, pid) / q->load;
+  if (slice < gran)
+    slice = gran;
+  return slice > INT_MAX ? INT_MAX : slice;
+}
+
+//an arrival takes the cpu when the running process is more than a
+//granularity of nice 0 time ahead of it
+static int cfs_preempt(sim *s, int pid)
+{
+  struct cfs_queue *q = s->rq;
+  long long cur = q->vr[s->running] +
+                  cfs_delta(s, s->running, s->now - s->since);
+
+  return cur - q->vr[pid] > ((long long)s->opt->gran << CFS_SHIFT);
+}
+
+//pid takes its weight along and its vruntime over the floor of this cpu
+static void cfs_leave(sim *s, int pid)
+{
+  struct cfs_queue *q = s->rq;
+
+  q->load -= cfs_weight(s, pid);
+  q->vr[pid] -= q->minVr;
+}
+
+static void cfs_done(sim *s, int pid)
+{
+  struct cfs_queue *q = s->rq;
+
+  q->load -= cfs_weight(s, pid);
+}
+
+int first_come_first_served(workload *wl, simOpt *opt, simStats *st)
+{
+  policy pol = {.init = heap_init, .ready = fcfs_ready, .pick = heap_pick,
+                .free = heap_free};
+
+  return simRun(&pol, wl, opt, st);
+}
+
+int shortest_job_first(workload *wl, simOpt *opt, simStats *st)
+{
+  policy pol = {.init = heap_init, .ready = sjf_ready, .pick = heap_pick,
+                .free = heap_free};
+
+  return simRun(&pol, wl, opt, st);
+}
+
+int shortest_remaining_time(workload *wl, simOpt *opt, simStats *st)
+{
+  policy pol = {.init = heap_init, .ready = srtf_ready, .pick = heap_pick,
+                .preempt = srtf_preempt, .free = heap_free};
+
+  return simRun(&pol, wl, opt, st);
+}
+
+int round_robin(workload *wl, simOpt *opt, simStats *st)
+{
+  policy pol = {.init = rr_init, .ready = rr_ready, .pick = rr_pick,
+                .slice = rr_slice, .free = rr_free};
+
+  return simRun(&pol, wl, opt, st);
+}
+
+int round_robin_priority(workload *wl, simOpt *opt, simStats *st)
+{
+  policy pol = {.init = prio_init, .ready = prio_ready, .pick = prio_pick,
+                .slice = rr_slice, .free = prio_free};
+
+  return simRun(&pol, wl, opt, st);
+}
+
+int multilevel_feedback_queue(workload *wl, simOpt *opt, simStats *st)
+{
+  policy pol = {.init = mlfq_init, .ready = mlfq_ready, .pick = mlfq_pick,
+                .slice = mlfq_slice, .preempt = mlfq_preempt,
+                .period = mlfq_period, .timer = mlfq_boost,
+                .free = mlfq_free};
+
+  return simRun(&pol, wl, opt, st);
+}
 
-  //calculate average completion time
-  avgComRunTime = totalComRunTime / NUM_PROCESSES;
+int completely_fair(workload *wl, simOpt *opt, simStats *st)
+{
+  policy pol = {.init = cfs_init, .ready = cfs_ready, .pick = cfs_pick,
+                .slice = cfs_slice, .preempt = cfs_preempt,
+                .leave = cfs_leave, .done = cfs_done, .free = cfs_free};
 
-  printf("Average time from arrival to completion is %d seconds\n", avgComRunTime);
+  return simRun(&pol, wl, opt, st);
 }
@@ -0,0 +1,757 @@
+/**
+*		    Filename:  sim.c
+*    Description:  discrete-event engine the scheduling algorithms run on
+*        Version:  1.0
+*        Created:  10.18.2026 22h45min12s
+*         Author:  Ningyuan Zhang （狮子劫博丽）(elithz), elithz@iastate.edu
+*        Company:  NERVE Software
+*/
+
+#include "sim.h"
+#include "emit.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+//sub of an event: its kind, then the cpu a completion or expiry is on
+#define SIM_SUB(kind, cpu) ((long long)(kind) << 32 | (cpu))
+
+//the machine a run is on, what the policies do not see
+typedef struct machine_struct
+{
+  //policy and knobs of the run
+  policy *pol;
+  simOpt *opt;
+  //workload, its processes and how many, next arrival in order
+  workload *wl;
+  struct process *proc;
+  int n;
+  int nextArr;
+  //current time and when the last process finished
+  long long now;
+  long long end;
+  //cpus and how many
+  sim *cpus;
+  int cpuNum;
+  //cpus an event of this instant left to pick, how many and 1 for each
+  //in the list
+  int *touched;
+  int touchNum;
+  char *mark;
+  //processes arrived and not finished
+  int live;
+  //when the timer and the balancer fire, -1 = not armed
+  long long timerAt;
+  long long balanceAt;
+  //processes moved from one cpu to another
+  long long migrations;
+  //processes in the order they finished and how many have
+  int *doneOrder;
+  int doneNum;
+  //pending events
+  heap events;
+} machine;
+
+//cpu c at the current time
+static sim *simCpu(machine *m, int c)
+{
+  m->cpus[c].now = m->now;
+  return &m->cpus[c];
+}
+
+//have cpu c pick at the end of the instant
+static void simTouch(machine *m, int c)
+{
+  if (m->mark[c])
+    return;
+  m->mark[c] = 1;
+  m->touched[m->touchNum++] = c;
+}
+
+//processes waiting in the ready queue of cpu c
+static int simWaiting(machine *m, int c)
+{
+  return m->cpus[c].nr - (m->cpus[c].running >= 0);
+}
+
+//give cpu c to its next ready process and post when it leaves it
+static int simDispatch(machine *m, int c)
+{
+  //the cpu
+  sim *s = simCpu(m, c);
+  //process picked, its quantum and time left
+  int pid, slice;
+  long long left;
+
+  pid = m->pol->pick(s);
+  if (pid < 0)
+    return 0;
+  //first time on the cpu
+  if (!m->proc[pid].flag)
+  {
+    m->proc[pid].flag = 1;
+    m->proc[pid].starttime = m->now;
+    m->proc[pid].remainingtime = m->proc[pid].runtime;
+  }
+  s->running = pid;
+  s->since = m->now;
+  //a preempted or expired process picked again keeps its context
+  if (s->last >= 0 && s->last != pid)
+  {
+    s->switches++;
+    m->proc[pid].switches++;
+  }
+  s->last = pid;
+
+  slice = m->pol->slice ? m->pol->slice(s, pid) : 0;
+  left = m->proc[pid].remainingtime;
+  if (!slice || left <= slice)
+    return hpPush(&m->events, m->now + left, SIM_SUB(EV_DONE, c), pid);
+  return hpPush(&m->events, m->now + slice, SIM_SUB(EV_SLICE, c), pid);
+}
+
+//move pid, just picked off cpu from, to the ready queue of cpu to
+static int simMove(machine *m, int from, int to, int pid)
+{
+  if (m->pol->leave)
+    m->pol->leave(simCpu(m, from), pid);
+  m->cpus[from].nr--;
+  m->cpus[to].nr++;
+  m->migrations++;
+  //a process that has run refills its cache on the new cpu
+  if (m->proc[pid].flag)
+    m->proc[pid].remainingtime += m->opt->migCost;
+  return m->pol->ready(simCpu(m, to), pid, SIM_MOVED);
+}
+
+//give idle cpu c the next process of the cpu with the most waiting
+static int simSteal(machine *m, int c)
+{
+  //counter, cpu stolen from and process stolen
+  int i, from = -1, pid;
+
+  for (i = 0; i < m->cpuNum; i++)
+    if (i != c && simWaiting(m, i) > 0 &&
+        (from < 0 || simWaiting(m, i) > simWaiting(m, from)))
+      from = i;
+  if (from < 0)
+    return 0;
+  pid = m->pol->pick(simCpu(m, from));
+  if (pid < 0)
+    return 0;
+  if (simMove(m, from, c, pid))
+    return -1;
+  return simDispatch(m, c);
+}
+
+//push processes from the most loaded cpu to the least loaded until they
+//differ by at most one
+static int simBalance(machine *m)
+{
+  //counter, most and least loaded cpu and process pushed
+  int i, hi, lo, pid;
+
+  for (;;)
+  {
+    hi = lo = 0;
+    for (i = 1; i < m->cpuNum; i++)
+    {
+      if (m->cpus[i].nr > m->cpus[hi].nr)
+        hi = i;
+      if (m->cpus[i].nr < m->cpus[lo].nr)
+        lo = i;
+    }
+    if (m->cpus[hi].nr - m->cpus[lo].nr <= 1)
+      return 0;
+    pid = m->pol->pick(simCpu(m, hi));
+    if (pid < 0)
+      return 0;
+    if (simMove(m, hi, lo, pid))
+      return -1;
+    simTouch(m, lo);
+  }
+}
+
+//cpu with the fewest processes, the lowest on a tie
+static int simPlace(machine *m)
+{
+  //counter and cpu found
+  int i, c = 0;
+
+  for (i = 1; i < m->cpuNum && m->cpus[c].nr; i++)
+    if (m->cpus[i].nr < m->cpus[c].nr)
+      c = i;
+  return c;
+}
+
+//let every idle cpu an event of this instant touched pick, then let the
+//ones still idle steal
+static int simPick(machine *m)
+{
+  //counter and cpu
+  int i, c;
+
+  for (i = 0; i < m->touchNum; i++)
+    if (m->cpus[m->touched[i]].running < 0 && simDispatch(m, m->touched[i]))
+      return -1;
+  for (i = 0; i < m->touchNum; i++)
+  {
+    c = m->touched[i];
+    m->mark[c] = 0;
+    if (m->cpuNum > 1 && m->cpus[c].running < 0 && simSteal(m, c))
+      return -1;
+  }
+  m->touchNum = 0;
+  return 0;
+}
+
+//post the next arrival in order
+static int simNextArrival(machine *m)
+{
+  //next process to arrive
+  int pid;
+
+  if (m->nextArr == m->n)
+    return 0;
+  pid = m->wl->order[m->nextArr++];
+  return hpPush(&m->events, m->proc[pid].arrivaltime,
+                SIM_SUB(EV_ARRIVE, 0), pid);
+}
+
+//post the timer and the balancer at the first multiple of their period
+//after now if they are not
+static int simArm(machine *m)
+{
+  //time between timer events and between balancing
+  int period = m->pol->period ? m->pol->period(&m->cpus[0]) : 0;
+  int balance = m->cpuNum > 1 ? m->opt->balance : 0;
+
+  //ids 0..n-1 are processes, n is the timer and n+1 the balancer
+  if (period > 0 && m->timerAt < 0)
+  {
+    m->timerAt = (m->now / period + 1) * period;
+    if (hpPush(&m->events, m->timerAt, SIM_SUB(EV_TIMER, 0), m->n))
+      return -1;
+  }
+  if (balance > 0 && m->balanceAt < 0)
+  {
+    m->balanceAt = (m->now / balance + 1) * balance;
+    if (hpPush(&m->events, m->balanceAt, SIM_SUB(EV_BALANCE, 0),
+               m->n + 1))
+      return -1;
+  }
+  return 0;
+}
+
+//take cpu s from its running process and put it back in the ready queue
+static int simPreempt(machine *m, sim *s)
+{
+  //preempted process
+  int pid = s->running;
+
+  hpDel(&m->events, pid);
+  m->proc[pid].remainingtime -= s->now - s->since;
+  s->busy += s->now - s->since;
+  s->running = -1;
+  return m->pol->ready(s, pid, SIM_RAN);
+}
+
+const char *const simMetricName[SIM_METRICS] = {"waiting", "response",
+                                                "turnaround", "slowdown",
+                                                "switches"};
+
+//metric k of process p
+static double simMetric(struct process *p, int k)
+{
+  //time from arrival to completion and slowdown
+  long long turn = p->endtime - p->arrivaltime;
+  double slow;
+
+  switch (k)
+  {
+  case SIM_WAITING:
+    return turn - p->runtime;
+  case SIM_RESPONSE:
+    return p->starttime - p->arrivaltime;
+  case SIM_TURNAROUND:
+    return turn;
+  case SIM_SLOWDOWN:
+    slow = (double)turn / (p->runtime > 1 ? p->runtime : 1);
+    return slow > 1 ? slow : 1;
+  default:
+    return p->switches;
+  }
+}
+
+//k-th smallest of the n values at v, which are reordered around it
+static double simSelect(double *v, int n, int k)
+{
+  //part still holding it, scans from both ends and the pivot
+  int lo = 0, hi = n - 1, i, j;
+  double pivot, swap;
+
+  while (lo < hi)
+  {
+    pivot = v[lo + (hi - lo) / 2];
+    for (i = lo, j = hi; i <= j;)
+    {
+      while (v[i] < pivot)
+        i++;
+      while (v[j] > pivot)
+        j--;
+      if (i <= j)
+      {
+        swap = v[i];
+        v[i++] = v[j];
+        v[j--] = swap;
+      }
+    }
+    if (k <= j)
+      hi = j;
+    else if (k >= i)
+      lo = i;
+    else
+      return v[k];
+  }
+  return v[k];
+}
+
+//mean and nearest rank percentiles of the n values at v
+static void simDistOf(double *v, int n, simDist *d)
+{
+  //counter, ranks of the percentiles
+  int i, r50, r95, r99;
+  double sum = 0;
+
+  if (!n)
+  {
+    d->mean = d->p50 = d->p95 = d->p99 = 0;
+    return;
+  }
+  for (i = 0; i < n; i++)
+    sum += v[i];
+  d->mean = sum / n;
+  r50 = ((long long)n * 50 + 99) / 100 - 1;
+  r95 = ((long long)n * 95 + 99) / 100 - 1;
+  r99 = ((long long)n * 99 + 99) / 100 - 1;
+  //each selection leaves the larger values above its rank for the next
+  d->p50 = simSelect(v, n, r50);
+  d->p95 = simSelect(v + r50, n - r50, r95 - r50);
+  d->p99 = simSelect(v + r95, n - r95, r99 - r95);
+}
+
+//write the record of each process in the order they finished
+static void simRecords(machine *m, emit *e)
+{
+  //counter, process and metric
+  int i, pid, k;
+  struct process *p;
+  int format = m->opt->format;
+  const char *name = m->opt->name ? m->opt->name : "";
+
+  for (i = 0; i < m->doneNum; i++)
+  {
+    pid = m->doneOrder[i];
+    p = &m->proc[pid];
+    if (format == SIM_TEXT)
+    {
+      emStr(e, "Process ");
+      emInt(e, pid);
+      emStr(e, " started at time ");
+      emInt(e, p->starttime);
+      emStr(e, "\nProcess ");
+      emInt(e, pid);
+      emStr(e, " finished at time ");
+      emInt(e, p->endtime);
+      emStr(e, "\n");
+      continue;
+    }
+    if (format == SIM_JSON)
+    {
+      emStr(e, "{\"type\":\"process\",\"algorithm\":\"");
+      emStr(e, name);
+      emStr(e, "\",\"pid\":");
+    }
+    else
+    {
+      emStr(e, name);
+      emStr(e, ",");
+    }
+    emInt(e, pid);
+    emStr(e, format == SIM_JSON ? ",\"arrival\":" : ",");
+    emInt(e, p->arrivaltime);
+    emStr(e, format == SIM_JSON ? ",\"runtime\":" : ",");
+    emInt(e, p->runtime);
+    emStr(e, format == SIM_JSON ? ",\"priority\":" : ",");
+    emInt(e, p->priority);
+    emStr(e, format == SIM_JSON ? ",\"start\":" : ",");
+    emInt(e, p->starttime);
+    emStr(e, format == SIM_JSON ? ",\"end\":" : ",");
+    emInt(e, p->endtime);
+    for (k = 0; k < SIM_METRICS; k++)
+    {
+      if (format == SIM_JSON)
+      {
+        emStr(e, ",\"");
+        emStr(e, simMetricName[k]);
+        emStr(e, "\":");
+      }
+      else
+        emStr(e, ",");
+      if (k == SIM_SLOWDOWN)
+        emDbl(e, simMetric(p, k));
+      else
+        emInt(e, simMetric(p, k));
+    }
+    emStr(e, format == SIM_JSON ? "}\n" : "\n");
+  }
+}
+
+//write the summary of the run, legacy is the truncated average
+//turnaround the lab prints
+static void simSummary(machine *m, simStats *st, long long legacy, emit *e)
+{
+  //counter and metric
+  int i, k;
+  //utilization of a cpu
+  char util[EM_SLACK];
+  int format = m->opt->format;
+  const char *name = m->opt->name ? m->opt->name : "";
+  //what the lines of the lab call the metrics
+  static const char *label[SIM_METRICS] = {
+      "Waiting time", "Response time", "Turnaround time", "Slowdown",
+      "Switches per process"};
+
+  if (format == SIM_TEXT)
+  {
+    //calculate average completion time
+    emStr(e, "Average time from arrival to completion is ");
+    emInt(e, legacy);
+    emStr(e, " seconds\nContext switches: ");
+    emInt(e, st->switches);
+    emStr(e, "\nFairness: ");
+    emDbl(e, st->fairness);
+    emStr(e, "\n");
+    for (k = 0; k < SIM_METRICS; k++)
+    {
+      emStr(e, label[k]);
+      emStr(e, ": mean ");
+      emDbl(e, st->metric[k].mean);
+      emStr(e, ", p50 ");
+      emDbl(e, st->metric[k].p50);
+      emStr(e, ", p95 ");
+      emDbl(e, st->metric[k].p95);
+      emStr(e, ", p99 ");
+      emDbl(e, st->metric[k].p99);
+      emStr(e, "\n");
+    }
+    if (m->cpuNum == 1)
+      return;
+    emStr(e, "Migrations: ");
+    emInt(e, st->migrations);
+    emStr(e, "\nLoad imbalance: ");
+    emDbl(e, st->imbalance);
+    emStr(e, "\nCPU utilization:");
+    for (i = 0; i < m->cpuNum; i++)
+    {
+      snprintf(util, sizeof(util), " %.1f%%",
+               m->end ? 100.0 * m->cpus[i].busy / m->end : 0);
+      emStr(e, util);
+    }
+    emStr(e, "\n");
+    return;
+  }
+
+  if (format == SIM_JSON)
+  {
+    emStr(e, "{\"type\":\"run\",\"algorithm\":\"");
+    emStr(e, name);
+    emStr(e, "\",\"processes\":");
+  }
+  else
+  {
+    emStr(e, name);
+    emStr(e, ",");
+  }
+  emInt(e, m->n);
+  emStr(e, format == SIM_JSON ? ",\"cpus\":" : ",");
+  emInt(e, m->cpuNum);
+  emStr(e, format == SIM_JSON ? ",\"switches\":" : ",");
+  emInt(e, st->switches);
+  emStr(e, format == SIM_JSON ? ",\"fairness\":" : ",");
+  emDbl(e, st->fairness);
+  emStr(e, format == SIM_JSON ? ",\"migrations\":" : ",");
+  emInt(e, st->migrations);
+  emStr(e, format == SIM_JSON ? ",\"imbalance\":" : ",");
+  emDbl(e, st->imbalance);
+  for (k = 0; k < SIM_METRICS; k++)
+  {
+    if (format == SIM_JSON)
+    {
+      emStr(e, ",\"");
+      emStr(e, simMetricName[k]);
+      emStr(e, "\":{\"mean\":");
+    }
+    else
+      emStr(e, ",");
+    emDbl(e, st->metric[k].mean);
+    emStr(e, format == SIM_JSON ? ",\"p50\":" : ",");
+    emDbl(e, st->metric[k].p50);
+    emStr(e, format == SIM_JSON ? ",\"p95\":" : ",");
+    emDbl(e, st->metric[k].p95);
+    emStr(e, format == SIM_JSON ? ",\"p99\":" : ",");
+    emDbl(e, st->metric[k].p99);
+    if (format == SIM_JSON)
+      emStr(e, "}");
+  }
+  if (format == SIM_JSON)
+  {
+    emStr(e, ",\"utilization\":[");
+    for (i = 0; i < m->cpuNum; i++)
+    {
+      if (i)
+        emStr(e, ",");
+      emDbl(e, m->end ? (double)m->cpus[i].busy / m->end : 0);
+    }
+    emStr(e, "]}");
+  }
+  emStr(e, "\n");
+}
+
+//metrics of a finished run into st, then the records and the summary
+//ret 0 = success, -1 = no memory
+static int simReport(machine *m, simStats *st)
+{
+  //counter and metric
+  int i, k;
+  //total completion time, context switches and busy time of the cpus
+  long long totalComRunTime = 0, switches = 0, busySum = 0, busyMax = 0;
+  //rate each process progressed at, its sum and sum of squares
+  double rate, rateSum = 0, rateSq = 0;
+  //a metric of every process
+  double *v;
+  struct process *proc = m->proc;
+  //writer of the records and the summary
+  emit e;
+
+  v = malloc((m->n + 1) * sizeof(double));
+  if (!v)
+    return -1;
+  for (i = 0; i < m->n; i++)
+  {
+    totalComRunTime += proc[i].endtime - proc[i].arrivaltime;
+    rate = proc[i].endtime > proc[i].arrivaltime
+               ? (double)proc[i].runtime /
+                     (proc[i].endtime - proc[i].arrivaltime)
+               : 1;
+    rateSum += rate;
+    rateSq += rate * rate;
+  }
+  for (k = 0; k < SIM_METRICS; k++)
+  {
+    for (i = 0; i < m->n; i++)
+      v[i] = simMetric(&proc[i], k);
+    simDistOf(v, m->n, &st->metric[k]);
+  }
+  free(v);
+  for (i = 0; i < m->cpuNum; i++)
+  {
+    switches += m->cpus[i].switches;
+    busySum += m->cpus[i].busy;
+    if (m->cpus[i].busy > busyMax)
+      busyMax = m->cpus[i].busy;
+  }
+  st->switches = switches;
+  st->fairness = rateSq ? rateSum * rateSum / (m->n * rateSq) : 1;
+  st->migrations = m->migrations;
+  st->imbalance = busySum ? (double)busyMax * m->cpuNum / busySum - 1 : 0;
+
+  //the records go out before the summary, the two may share a file
+  if (m->opt->out)
+  {
+    emInit(&e, m->opt->out);
+    simRecords(m, &e);
+    emFlush(&e);
+  }
+  if (m->opt->report)
+  {
+    emInit(&e, m->opt->report);
+    simSummary(m, st, m->n ? totalComRunTime / m->n : 0, &e);
+    emFlush(&e);
+  }
+  return 0;
+}
+
+void simHeader(simOpt *opt)
+{
+  //metric
+  int k;
+
+  if (opt->format != SIM_CSV)
+    return;
+  if (opt->out)
+  {
+    fprintf(opt->out, "algorithm,pid,arrival,runtime,priority,start,end");
+    for (k = 0; k < SIM_METRICS; k++)
+      fprintf(opt->out, ",%s", simMetricName[k]);
+    fprintf(opt->out, "\n");
+  }
+  if (opt->report)
+  {
+    fprintf(opt->report,
+            "algorithm,processes,cpus,switches,fairness,migrations,imbalance");
+    for (k = 0; k < SIM_METRICS; k++)
+      fprintf(opt->report, ",%s_mean,%s_p50,%s_p95,%s_p99", simMetricName[k],
+              simMetricName[k], simMetricName[k], simMetricName[k]);
+    fprintf(opt->report, "\n");
+  }
+}
+
+int simRun(policy *pol, workload *wl, simOpt *opt, simStats *st)
+{
+  //counter, cpu and result
+  int i, c, rc = 0;
+  //event being handled
+  hpItem ev;
+  //the machine, a cpu and the processes
+  machine m;
+  //averages when the caller does not want them
+  simStats mine;
+  sim *s;
+  struct process *proc = wl->proc;
+
+  m.pol = pol;
+  m.opt = opt;
+  m.wl = wl;
+  m.proc = proc;
+  m.n = wl->n;
+  m.nextArr = 0;
+  m.now = m.end = 0;
+  m.cpuNum = opt->cpus > 0 ? opt->cpus : 1;
+  m.touchNum = 0;
+  m.live = 0;
+  m.timerAt = m.balanceAt = -1;
+  m.migrations = 0;
+  m.doneNum = 0;
+  for (i = 0; i < m.n; i++)
+  {
+    proc[i].starttime = 0;
+    proc[i].endtime = 0;
+    proc[i].flag = 0;
+    proc[i].remainingtime = 0;
+    proc[i].switches = 0;
+  }
+  //an arrival, a completion or expiry per cpu, the timer and the
+  //balancer, by process id
+  if (hpInitIdx(&m.events, m.cpuNum + 3, m.n + 2))
+    return -1;
+  m.cpus = calloc(m.cpuNum, sizeof(sim));
+  m.touched = malloc(m.cpuNum * sizeof(int));
+  m.mark = calloc(m.cpuNum, 1);
+  m.doneOrder = malloc((m.n + 1) * sizeof(int));
+  if (!m.cpus || !m.touched || !m.mark || !m.doneOrder)
+  {
+    rc = -1;
+    goto oom;
+  }
+  for (c = 0; c < m.cpuNum; c++)
+  {
+    s = &m.cpus[c];
+    s->opt = opt;
+    s->proc = proc;
+    s->n = m.n;
+    s->cpu = c;
+    s->cpus = m.cpus;
+    s->running = -1;
+    s->last = -1;
+    if (pol->init(s))
+    {
+      //the others share with cpu 0, it goes last
+      while (c--)
+        pol->free(&m.cpus[c]);
+      rc = -1;
+      goto oom;
+    }
+  }
+  rc = simNextArrival(&m);
+
+  while (!rc && !hpPop(&m.events, &ev))
+  {
+    m.now = ev.key;
+    switch (ev.sub >> 32)
+    {
+    case EV_ARRIVE:
+      m.live++;
+      rc = simArm(&m);
+      c = simPlace(&m);
+      s = simCpu(&m, c);
+      s->nr++;
+      simTouch(&m, c);
+      if (!rc)
+        rc = pol->ready(s, ev.id, SIM_NEW);
+      //a process finishing at this instant is not preempted
+      if (!rc && s->running >= 0 && pol->preempt &&
+          proc[s->running].remainingtime > m.now - s->since &&
+          pol->preempt(s, ev.id))
+        rc = simPreempt(&m, s);
+      if (!rc)
+        rc = simNextArrival(&m);
+      break;
+
+    case EV_DONE:
+      s = simCpu(&m, (int)ev.sub);
+      proc[ev.id].flag = 2;
+      proc[ev.id].remainingtime = 0;
+      proc[ev.id].endtime = m.now;
+      m.end = m.now;
+      m.live--;
+      s->nr--;
+      s->busy += m.now - s->since;
+      if (pol->done)
+        pol->done(s, ev.id);
+      s->running = -1;
+      simTouch(&m, s->cpu);
+      m.doneOrder[m.doneNum++] = ev.id;
+      break;
+
+    case EV_SLICE:
+      s = simCpu(&m, (int)ev.sub);
+      proc[ev.id].remainingtime -= m.now - s->since;
+      s->busy += m.now - s->since;
+      s->running = -1;
+      simTouch(&m, s->cpu);
+      rc = pol->ready(s, ev.id, SIM_RAN);
+      break;
+
+    case EV_TIMER:
+      m.timerAt = -1;
+      for (c = 0; c < m.cpuNum; c++)
+        pol->timer(simCpu(&m, c));
+      if (m.live)
+        rc = simArm(&m);
+      break;
+
+    case EV_BALANCE:
+      m.balanceAt = -1;
+      rc = simBalance(&m);
+      if (!rc && m.live)
+        rc = simArm(&m);
+      break;
+    }
+
+    //pick once every event of this instant is in
+    if (!rc && (!hpTop(&m.events) || hpTop(&m.events)->key != m.now))
+      rc = simPick(&m);
+  }
+
+  if (!rc)
+    rc = simReport(&m, st ? st : &mine);
+  for (c = m.cpuNum; c--;)
+    pol->free(&m.cpus[c]);
+oom:
+  free(m.cpus);
+  free(m.touched);
+  free(m.mark);
+  free(m.doneOrder);
+  hpFree(&m.events);
+  return rc;
+}
@@ -0,0 +1,219 @@
+/**
+*		    Filename:  sim.h
+*    Description:  discrete-event engine the scheduling algorithms run on
+*        Version:  1.0
+*        Created:  10.18.2026 22h45min12s
+*         Author:  Ningyuan Zhang （狮子劫博丽）(elithz), elithz@iastate.edu
+*        Company:  NERVE Software
+*/
+
+/*
+ *  Time jumps from one event to the next instead of ticking: every
+ *  arrival, completion and quantum expiry is an event in a min-heap
+ *  ordered by time. All events of an instant are handled, then every
+ *  cpu they left free picks its next process and the engine posts its
+ *  completion, or the expiry of its quantum if that comes first.
+ *  A policy may also preempt the running process when another arrives,
+ *  its pending event is then cancelled through the index of the event
+ *  heap and it goes back to the ready queue with the time it has left.
+ *  A policy with a period gets a timer event every period while any
+ *  process has arrived and not finished, aligned to multiples of the
+ *  period, so long idle gaps cost nothing. A
+ *  run costs O(events log events) whatever the length of the idle gaps
+ *  and bursts. Arrivals come in one at a time in arrival order, so the
+ *  heap holds the next arrival and at most one completion or expiry
+ *  per cpu. The engine resets the tracking fields of the processes
+ *  itself, one workload is run under each policy in turn without a
+ *  copy. A policy is only its ready queue: where a process goes when it
+ *  arrives or its quantum ends, which one runs next and for how long.
+ *
+ *  With several cpus each has its own ready queue, an instance of the
+ *  policy. An arrival goes to the cpu with the fewest processes, a cpu
+ *  left with nothing to run steals the next process of the cpu with the
+ *  most waiting, and every balance period the most loaded cpus push
+ *  processes to the least loaded until they differ by at most one. A
+ *  process that has run and moves pays the migration cost in extra
+ *  work, its cache is cold on the new cpu.
+ *
+ *  Nothing is printed while a run goes on. The engine keeps the order
+ *  the processes finished in and writes a record per process after the
+ *  run through a buffered writer, as the lines of the lab, CSV rows or
+ *  JSON lines, then the summary: mean, median, 95th and 99th percentile
+ *  of the waiting, response and turnaround time, slowdown and context
+ *  switches of the processes. Percentiles are nearest rank, found by
+ *  selection instead of a sort.
+ */
+
+#ifndef SIM
+#define SIM
+
+#include "heap.h"
+#include "workload.h"
+#include <stdio.h>
+
+//event kinds, also the order they are handled in at the same time
+#define EV_ARRIVE 0
+#define EV_DONE 1
+#define EV_SLICE 2
+#define EV_TIMER 3
+#define EV_BALANCE 4
+
+//why a process is put in a ready queue: it arrived, its quantum ended
+//or it was preempted, it moved in from another cpu
+#define SIM_NEW 0
+#define SIM_RAN 1
+#define SIM_MOVED 2
+
+//quantum when -t is not given
+#define SIM_QUANTUM 1
+//most levels of the multilevel feedback queue
+#define MLFQ_MAX_LEVELS 64
+//most cpus, migration cost and time between balancing when -M and -B
+//are not given
+#define SIM_MAX_CPUS 1024
+#define SIM_MIG_COST 1
+#define SIM_BALANCE 10
+
+//formats of the records
+#define SIM_TEXT 0
+#define SIM_CSV 1
+#define SIM_JSON 2
+
+//metrics of a process: time ready and not running its work, from
+//arrival to first run, from arrival to completion, turnaround over
+//runtime (a runtime of 0 counts as 1 tick, never below 1) and times it
+//got a cpu another process had
+#define SIM_WAITING 0
+#define SIM_RESPONSE 1
+#define SIM_TURNAROUND 2
+#define SIM_SLOWDOWN 3
+#define SIM_SWITCHES 4
+#define SIM_METRICS 5
+
+//knobs of a run, set from the command line
+typedef struct simOpt_struct
+{
+  //where the start and finish lines go, NULL = not at all
+  FILE *out;
+  //where the averages go, NULL = not at all
+  FILE *report;
+  //format of both and algorithm named in the records
+  int format;
+  const char *name;
+  //time a round robin process runs before the next one gets the cpu
+  int quantum;
+  //levels of the multilevel feedback queue and the quantum of each,
+  //0 = the round robin quantum doubled on each level down
+  int levels;
+  int quanta[MLFQ_MAX_LEVELS];
+  //time between moves of every process back to the top level, 0 = never
+  int boost;
+  //shortest time the fair share policy lets a process run
+  int gran;
+  //cpus, extra work of a process that moved to another cpu and time
+  //between load balancing, 0 = only when a cpu runs out of work
+  int cpus;
+  int migCost;
+  int balance;
+} simOpt;
+
+//mean and percentiles of a metric over the processes
+typedef struct simDist_struct
+{
+  double mean;
+  double p50;
+  double p95;
+  double p99;
+} simDist;
+
+//averages of a run
+typedef struct simStats_struct
+{
+  //each metric of the processes
+  simDist metric[SIM_METRICS];
+  //context switches of all cpus
+  long long switches;
+  //Jain's index of runtime / turnaround
+  double fairness;
+  long long migrations;
+  //busy time of the busiest cpu over the mean, minus 1
+  double imbalance;
+} simStats;
+
+//a cpu of a run
+typedef struct sim_struct
+{
+  //knobs of the run
+  simOpt *opt;
+  //processes and how many
+  struct process *proc;
+  int n;
+  //current time
+  long long now;
+  //this cpu and all of them
+  int cpu;
+  struct sim_struct *cpus;
+  //process on the cpu, -1 = idle
+  int running;
+  //when it got the cpu
+  long long since;
+  //process that ran last, -1 = none yet
+  int last;
+  //times the cpu went from one process to another
+  long long switches;
+  //processes queued or running here
+  int nr;
+  //time spent running processes
+  long long busy;
+  //ready queue of the policy
+  void *rq;
+} sim;
+
+//a scheduling algorithm
+typedef struct policy_struct
+{
+  //make the ready queue in s->rq, cpu 0 comes first and the others may
+  //share arrays indexed by process id with it
+  //ret 0 = success, -1 = no memory
+  int (*init)(sim *s);
+  //put pid in the ready queue, why = SIM_NEW, SIM_RAN or SIM_MOVED
+  //ret 0 = success, -1 = no memory
+  int (*ready)(sim *s, int pid, int why);
+  //take the next process to run off the ready queue, -1 = none
+  int (*pick)(sim *s);
+  //quantum of pid, NULL = run to completion
+  int (*slice)(sim *s, int pid);
+  //1 if pid, just arrived, should take the cpu from s->running,
+  //NULL = never preempt
+  int (*preempt)(sim *s, int pid);
+  //pid, just picked, moves to another cpu, NULL = nothing to do
+  void (*leave)(sim *s, int pid);
+  //pid finished, NULL = nothing to do
+  void (*done)(sim *s, int pid);
+  //time between timer events, NULL or 0 = no timer
+  int (*period)(sim *s);
+  //the timer fired, called for every cpu
+  void (*timer)(sim *s);
+  //free the ready queue, cpu 0 comes last
+  void (*free)(sim *s);
+} policy;
+
+//names of the metrics in the records
+extern const char *const simMetricName[SIM_METRICS];
+
+//run the workload under pol on opt->cpus cpus, writing a record of each
+//process to opt->out in the order they finished, then giving
+//opt->report and st, if not NULL, the metrics of the processes, the
+//context switches and Jain's fairness index of runtime / turnaround
+//over the processes (1 = every process progressed at the same rate,
+//1/n = one process got everything), with several cpus also the
+//migrations, the load imbalance (busy time of the busiest cpu over the
+//mean, minus 1) and, printed only, the utilization of each cpu
+//ret 0 = success, -1 = no memory
+int simRun(policy *pol, workload *wl, simOpt *opt, simStats *st);
+
+//write the header of the CSV tables to opt->out and opt->report, once
+//before the runs
+void simHeader(simOpt *opt);
+
+#endif
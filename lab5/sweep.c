@@ -0,0 +1,196 @@
+/**
+*		    Filename:  sweep.c
+*    Description:  runs every algorithm over a grid of settings on threads
+*        Version:  1.0
+*        Created:  10.19.2026 02h14min50s
+*         Author:  Ningyuan Zhang （狮子劫博丽）(elithz), elithz@iastate.edu
+*        Company:  NERVE Software
+*/
+
+#include "sweep.h"
+#include <limits.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+//averages of a run in the table
+#define SW_FIELDS 9
+
+//Student's t at 97.5% for 1..30 degrees of freedom, the normal one above
+static const double swT[30] = {
+    12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+    2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+    2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042};
+#define SW_Z 1.960
+
+//columns of the averages
+static const char *swNames[SW_FIELDS] = {
+    "waiting", "response", "turnaround", "turnaround_p99", "slowdown",
+    "switches", "fairness", "migrations", "imbalance"};
+
+//a sweep under way, shared by its threads
+typedef struct swJob_struct
+{
+  const swAlgo *algos;
+  swOpt *sw;
+  simOpt *opt;
+  //runs, the next one to take and the averages of each
+  long long runs;
+  long long next;
+  simStats *res;
+  //1 once a run ran out of memory
+  int failed;
+} swJob;
+
+//run r, numbered seed first, then load, quantum and algorithm
+static int swOne(swJob *job, long long r)
+{
+  swOpt *sw = job->sw;
+  //where r is in the grid
+  int seed = r % sw->seeds;
+  int load = r / sw->seeds % sw->loadNum;
+  int q = r / sw->seeds / sw->loadNum % sw->quantumNum;
+  int a = r / sw->seeds / sw->loadNum / sw->quantumNum;
+  //knobs and processes of the run
+  simOpt opt = *job->opt;
+  workload wl;
+  //ticks the arrivals spread over and result
+  double span;
+  int rc;
+
+  opt.out = NULL;
+  opt.report = NULL;
+  opt.quantum = sw->quanta[q];
+  span = sw->n * (WL_RUN_MIN + (WL_RUN_RANGE - 1) / 2.0) /
+         (sw->loads[load] * opt.cpus);
+  if (wlGenR(&wl, sw->n, sw->seed + seed,
+             span >= INT_MAX ? INT_MAX : (int)(span + 0.5)))
+    return -1;
+  rc = job->algos[a].run(&wl, &opt, &job->res[r]);
+  wlFree(&wl);
+  return rc;
+}
+
+//body of every thread: take runs until none are left
+static void *swWork(void *arg)
+{
+  swJob *job = arg;
+  //run taken
+  long long r;
+
+  while ((r = __sync_fetch_and_add(&job->next, 1)) < job->runs)
+    if (swOne(job, r))
+      __sync_lock_test_and_set(&job->failed, 1);
+  return NULL;
+}
+
+//average f of st
+static double swField(simStats *st, int f)
+{
+  switch (f)
+  {
+  case 0:
+    return st->metric[SIM_WAITING].mean;
+  case 1:
+    return st->metric[SIM_RESPONSE].mean;
+  case 2:
+    return st->metric[SIM_TURNAROUND].mean;
+  case 3:
+    return st->metric[SIM_TURNAROUND].p99;
+  case 4:
+    return st->metric[SIM_SLOWDOWN].mean;
+  case 5:
+    return st->switches;
+  case 6:
+    return st->fairness;
+  case 7:
+    return st->migrations;
+  default:
+    return st->imbalance;
+  }
+}
+
+//print the mean of average f over the k runs at st and the half width
+//of its 95% confidence interval
+static void swMean(FILE *csv, simStats *st, int k, int f)
+{
+  //counter
+  int i;
+  //sum, mean and sum of squared deviations
+  double sum = 0, mean, dev = 0;
+
+  for (i = 0; i < k; i++)
+    sum += swField(&st[i], f);
+  mean = sum / k;
+  for (i = 0; i < k; i++)
+    dev += (swField(&st[i], f) - mean) * (swField(&st[i], f) - mean);
+  fprintf(csv, ",%.3f,%.3f", mean,
+          k > 1 ? (k <= 31 ? swT[k - 2] : SW_Z) * sqrt(dev / (k - 1) / k) : 0);
+}
+
+int swRun(const swAlgo *algos, int algoNum, swOpt *sw, simOpt *opt,
+          FILE *csv)
+{
+  //counters
+  int a, q, l, f;
+  long long i;
+  //threads started
+  int threads = sw->threads, started;
+  pthread_t *tid;
+  //the sweep
+  swJob job;
+
+  job.algos = algos;
+  job.sw = sw;
+  job.opt = opt;
+  job.runs = (long long)algoNum * sw->quantumNum * sw->loadNum * sw->seeds;
+  job.next = 0;
+  job.failed = 0;
+  if (!threads)
+    threads = sysconf(_SC_NPROCESSORS_ONLN);
+  if (threads < 1)
+    threads = 1;
+  if (threads > job.runs)
+    threads = job.runs;
+  job.res = malloc(job.runs * sizeof(simStats) + 1);
+  tid = malloc(threads * sizeof(pthread_t) + 1);
+  if (!job.res || !tid)
+  {
+    free(job.res);
+    free(tid);
+    return -1;
+  }
+
+  //this thread works too, a thread that cannot start leaves its runs to
+  //the others
+  for (started = 0; started < threads - 1; started++)
+    if (pthread_create(&tid[started], NULL, swWork, &job))
+      break;
+  swWork(&job);
+  while (started--)
+    pthread_join(tid[started], NULL);
+  free(tid);
+  if (job.failed)
+  {
+    free(job.res);
+    return -1;
+  }
+
+  fprintf(csv, "algorithm,quantum,load,runs");
+  for (f = 0; f < SW_FIELDS; f++)
+    fprintf(csv, ",%s,%s_ci", swNames[f], swNames[f]);
+  fprintf(csv, "\n");
+  for (i = 0, a = 0; a < algoNum; a++)
+    for (q = 0; q < sw->quantumNum; q++)
+      for (l = 0; l < sw->loadNum; l++, i += sw->seeds)
+      {
+        fprintf(csv, "%s,%d,%.3f,%d", algos[a].name, sw->quanta[q],
+                sw->loads[l], sw->seeds);
+        for (f = 0; f < SW_FIELDS; f++)
+          swMean(csv, &job.res[i], sw->seeds, f);
+        fprintf(csv, "\n");
+      }
+  free(job.res);
+  return 0;
+}
@@ -0,0 +1,69 @@
+/**
+*		    Filename:  sweep.h
+*    Description:  runs every algorithm over a grid of settings on threads
+*        Version:  1.0
+*        Created:  10.19.2026 02h14min50s
+*         Author:  Ningyuan Zhang （狮子劫博丽）(elithz), elithz@iastate.edu
+*        Company:  NERVE Software
+*/
+
+/*
+ *  A sweep runs every algorithm on every combination of seed, quantum
+ *  and offered load. The runs are numbered and a pool of threads takes
+ *  the next number off a shared counter until none are left. Every run
+ *  generates its own workload from its seed with wlGenR and works on
+ *  its own copy of the knobs, so nothing is shared but the counter and
+ *  the result slot of each run, and a sweep prints the same table
+ *  whatever the threads and their timing. The algorithms see the same
+ *  workloads for the same seed and load, so their differences are not
+ *  noise between workloads. The offered load is the work arriving per
+ *  tick per cpu: the arrivals of n processes are spread over
+ *  n * mean runtime / (load * cpus) ticks. The runs of each algorithm,
+ *  quantum and load become a CSV line with the mean over the seeds of
+ *  the mean waiting, response and turnaround time, the 99th percentile
+ *  of the turnaround, the mean slowdown, the context switches, the
+ *  fairness, the migrations and the imbalance, each with the half width
+ *  of its 95% confidence interval (Student's t).
+ */
+
+#ifndef SWEEP
+#define SWEEP
+
+#include "sim.h"
+#include "workload.h"
+#include <stdio.h>
+
+//most quanta and loads of a sweep
+#define SW_MAX_LIST 64
+
+//an algorithm to sweep
+typedef struct swAlgo_struct
+{
+  //name in the table
+  const char *name;
+  //run it on wl, ret 0 = success, -1 = no memory
+  int (*run)(workload *wl, simOpt *opt, simStats *st);
+} swAlgo;
+
+//the grid
+typedef struct swOpt_struct
+{
+  //processes per run, first seed and how many seeds from it
+  int n;
+  unsigned long long seed;
+  int seeds;
+  //quanta and offered loads
+  int quanta[SW_MAX_LIST];
+  int quantumNum;
+  double loads[SW_MAX_LIST];
+  int loadNum;
+  //threads, 0 = one per online cpu
+  int threads;
+} swOpt;
+
+//run algos over the grid of sw with the other knobs of opt and print
+//the table to csv, ret 0 = success, -1 = no memory
+int swRun(const swAlgo *algos, int algoNum, swOpt *sw, simOpt *opt,
+          FILE *csv);
+
+#endif
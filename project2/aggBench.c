@@ -0,0 +1,111 @@
+/**
+*		Filename:  aggBench.c
+*    Description:  Benchmark of the aggregate scans over many accounts
+*        Version:  1.0
+*        Created:  10.18.2026 15h48min10s
+*         Author:  Ningyuan Zhang （狮子劫博丽）(elithz), elithz@iastate.edu
+*        Company:  NERVE Software
+*/
+
+#include "aggScan.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/time.h>
+
+#define ARGUMENT_FORMAT "aggBench [accountNum [rounds [threads]]]"
+//buckets used for the histogram runs
+#define BENCH_BUCKETS 64
+
+/**current time in usec
+ * @ret long long: time since the epoch
+ * @author elithz
+ * @modified 10.18.2026*/
+static long long benchNow(){
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return (long long) tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+/**time SUM/MIN/MAX and HIST scans with a given number of threads
+ * @param int * a: balances
+ * @param int n: number of balances
+ * @param int rounds: scans per measurement
+ * @param int threads: scan threads
+ * @ret void
+ * @author elithz
+ * @modified 10.18.2026*/
+static void benchRun(int * a, int n, int rounds, int threads){
+	//counter
+	int r;
+	//results
+	aggRes res;
+	long long cnt[BENCH_BUCKETS];
+	//timings
+	long long t0, scanUs, histUs;
+
+	threads = aggInit(threads);
+
+	t0 = benchNow();
+	for(r = 0; r < rounds; r++)
+		aggScan(a, n, &res);
+	scanUs = (benchNow() - t0) / rounds;
+
+	t0 = benchNow();
+	for(r = 0; r < rounds; r++)
+		aggHist(a, n, res.min, res.max, BENCH_BUCKETS, cnt);
+	histUs = (benchNow() - t0) / rounds;
+
+	aggFree();
+
+	printf("%d\t%.3f\t%.2f\t%.3f\t%.2f\t%lld\t%d\t%d\n", threads,
+		scanUs / 1000.0, n * sizeof(int) / (scanUs * 1000.0),
+		histUs / 1000.0, n * sizeof(int) / (histUs * 1000.0),
+		res.sum, res.min, res.max);
+}
+
+/**run the benchmark, default 10M accounts
+ * @param argv[1]: integer, number of accounts
+ * @param argv[2]: integer, scans per measurement
+ * @param argv[3]: integer, most scan threads, default online cpus
+ * @ret int: 0 = operation success, -1 = error encountered
+ * @author elithz
+ * @modified 10.18.2026*/
+int main(int argc, char ** argv){
+	//counter
+	int i;
+	//sizes
+	int n = 10000000, rounds = 20;
+	int maxThds = (int) sysconf(_SC_NPROCESSORS_ONLN), t;
+	//balances
+	int * a;
+	unsigned int seed = 308;
+
+	if((argc > 1 && sscanf(argv[1], "%d", &n) != 1) || (argc > 2
+		&& sscanf(argv[2], "%d", &rounds) != 1) || (argc > 3
+		&& sscanf(argv[3], "%d", &maxThds) != 1) || n < 1 || rounds < 1){
+		fprintf(stderr, "aggBench expected format: " ARGUMENT_FORMAT "\n");
+		return -1;
+	}
+	if(maxThds > AGG_MAX_THREADS)
+		maxThds = AGG_MAX_THREADS;
+
+	a = malloc(n * sizeof(int));
+	if(!a){
+		fprintf(stderr, "error (aggBench): out of memory\n");
+		return -1;
+	}
+	//balances like the test script uses, around 1000000
+	for(i = 0; i < n; i++)
+		a[i] = 500000 + rand_r(&seed) % 1000000;
+
+	printf("accounts %d rounds %d\n", n, rounds);
+	printf("threads\tscanms\tscanGBs\thistms\thistGBs\tsum\tmin\tmax\n");
+	for(t = 1; t <= maxThds; t *= 2)
+		benchRun(a, n, rounds, t);
+	if(t / 2 != maxThds)
+		benchRun(a, n, rounds, maxThds);
+
+	free(a);
+	return 0;
+}
@@ -0,0 +1,292 @@
+/**
+*		Filename:  aggScan.c
+*    Description:  Parallel vectorized scans over an array of balances
+*        Version:  1.0
+*        Created:  10.18.2026 15h10min27s
+*         Author:  Ningyuan Zhang （狮子劫博丽）(elithz), elithz@iastate.edu
+*        Company:  NERVE Software
+*/
+
+#include "aggScan.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <limits.h>
+#include <unistd.h>
+
+//build an AVX2 clone of the kernels next to the baseline one
+#if defined(__x86_64__) && defined(__GNUC__) && !defined(__clang__)
+#define AGG_CLONES __attribute__((target_clones("avx2", "default")))
+#else
+#define AGG_CLONES
+#endif
+
+//jobs the helpers run
+#define AGG_SCAN 0
+#define AGG_HIST 1
+
+//number of chunks a parallel scan is split in, helpers are chunks 1..
+static int aggThds = 1;
+static pthread_t aggHlp[AGG_MAX_THREADS];
+//one parallel scan at a time
+static pthread_mutex_t aggLk = PTHREAD_MUTEX_INITIALIZER;
+//job hand off between the caller and the helpers
+static pthread_mutex_t jobLk = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t jobCv = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t doneCv = PTHREAD_COND_INITIALIZER;
+static int jobGen = 0;
+static int jobDone = 0;
+static int jobStop = 0;
+//job each helper has seen when it starts
+static int hlpSeen[AGG_MAX_THREADS];
+//current job
+static int jobOp;
+static const int * jobA;
+static int jobN, jobLo, jobHi, jobNb;
+//partial results of every chunk
+static aggRes partRes[AGG_MAX_THREADS];
+static long long partHist[AGG_MAX_THREADS][AGG_MAX_BUCKETS];
+
+/**sum, min and max of one chunk, vectorized by the compiler
+ * @param const int * a: values
+ * @param int n: number of values
+ * @param aggRes * res: result
+ * @ret void
+ * @author elithz
+ * @modified 10.18.2026*/
+AGG_CLONES static void aggKrnScan(const int * restrict a, int n, aggRes * res){
+	//counter
+	int i;
+	//running reductions
+	long long s = 0;
+	int mn = INT_MAX, mx = INT_MIN, v;
+
+	for(i = 0; i < n; i++){
+		v = a[i];
+		s += v;
+		mn = v < mn ? v : mn;
+		mx = v > mx ? v : mx;
+	}
+	res->sum = s;
+	res->min = mn;
+	res->max = mx;
+}
+
+/**histogram of one chunk
+ * @param const int * a: values
+ * @param int n: number of values
+ * @param int lo, hi: range covered by the buckets
+ * @param int nb: number of buckets
+ * @param long long * cnt: bucket counts, zeroed by the caller
+ * @ret void
+ * @author elithz
+ * @modified 10.18.2026*/
+AGG_CLONES static void aggKrnHist(const int * restrict a, int n, int lo, int hi,
+	int nb, long long * restrict cnt){
+	//counter and bucket
+	int i, b;
+	//width of the range and buckets per unit, multiplying beats dividing
+	long long span = (long long) hi - lo + 1;
+	double scale = (double) nb / span;
+	long long off;
+
+	for(i = 0; i < n; i++){
+		off = (long long) a[i] - lo;
+		if(off < 0 || off >= span)
+			continue;
+		b = (int) (off * scale);
+		cnt[b < nb ? b : nb - 1]++;
+	}
+}
+
+/**run chunk k of the current job
+ * @param int k: chunk index
+ * @param int chunks: number of chunks the job is split in
+ * @ret void
+ * @author elithz
+ * @modified 10.18.2026*/
+static void aggChunk(int k, int chunks){
+	//chunk bounds
+	int from = (int) ((long long) jobN * k / chunks);
+	int to = (int) ((long long) jobN * (k + 1) / chunks);
+
+	if(jobOp == AGG_SCAN){
+		if(to > from)
+			aggKrnScan(jobA + from, to - from, &partRes[k]);
+		else{
+			partRes[k].sum = 0;
+			partRes[k].min = INT_MAX;
+			partRes[k].max = INT_MIN;
+		}
+	}
+	else{
+		memset(partHist[k], 0, jobNb * sizeof(long long));
+		aggKrnHist(jobA + from, to - from, jobLo, jobHi, jobNb, partHist[k]);
+	}
+}
+
+/**scan helper, runs its chunk of every job
+ * @param void * arg: chunk index
+ * @ret void *: NULL
+ * @author elithz
+ * @modified 10.18.2026*/
+static void * aggHelper(void * arg){
+	//chunk of this helper and last job seen
+	int k = (int) (long) arg;
+	int seen = hlpSeen[k];
+
+	while(1){
+		pthread_mutex_lock(&jobLk);
+		while(jobGen == seen && !jobStop)
+			pthread_cond_wait(&jobCv, &jobLk);
+		if(jobStop){
+			pthread_mutex_unlock(&jobLk);
+			return NULL;
+		}
+		seen = jobGen;
+		pthread_mutex_unlock(&jobLk);
+
+		aggChunk(k, aggThds);
+
+		pthread_mutex_lock(&jobLk);
+		if(++jobDone == aggThds - 1)
+			pthread_cond_signal(&doneCv);
+		pthread_mutex_unlock(&jobLk);
+	}
+}
+
+/**run the current job over all chunks, aggLk must be held
+ * @ret void
+ * @author elithz
+ * @modified 10.18.2026*/
+static void aggRun(){
+	//small arrays are not worth waking anybody
+	if(aggThds == 1 || jobN < AGG_PAR_MIN){
+		aggChunk(0, 1);
+		return;
+	}
+
+	pthread_mutex_lock(&jobLk);
+	jobDone = 0;
+	jobGen++;
+	pthread_cond_broadcast(&jobCv);
+	pthread_mutex_unlock(&jobLk);
+
+	//the caller takes chunk 0
+	aggChunk(0, aggThds);
+
+	pthread_mutex_lock(&jobLk);
+	while(jobDone < aggThds - 1)
+		pthread_cond_wait(&doneCv, &jobLk);
+	pthread_mutex_unlock(&jobLk);
+}
+
+/**start the scan helpers
+ * @param int threads: chunks per scan, <= 0 reads BAMNG_AGG_THREADS
+ * @ret int: number of threads scans use
+ * @author elithz
+ * @modified 10.18.2026*/
+int aggInit(int threads){
+	//counter
+	int i;
+	//environment value
+	char * val;
+
+	if(threads <= 0){
+		val = getenv("BAMNG_AGG_THREADS");
+		threads = val ? atoi(val) : (int) sysconf(_SC_NPROCESSORS_ONLN);
+	}
+	if(threads < 1)
+		threads = 1;
+	if(threads > AGG_MAX_THREADS)
+		threads = AGG_MAX_THREADS;
+
+	//a new helper must not run a job of the helpers before it
+	pthread_mutex_lock(&jobLk);
+	for(i = 1; i < threads; i++)
+		hlpSeen[i] = jobGen;
+	pthread_mutex_unlock(&jobLk);
+	for(i = 1; i < threads; i++)
+		if(pthread_create(&aggHlp[i], NULL, aggHelper, (void *) (long) i))
+			break;
+	aggThds = i;
+	return aggThds;
+}
+
+/**stop the scan helpers
+ * @ret void
+ * @author elithz
+ * @modified 10.18.2026*/
+void aggFree(){
+	//counter
+	int i;
+
+	pthread_mutex_lock(&jobLk);
+	jobStop = 1;
+	pthread_cond_broadcast(&jobCv);
+	pthread_mutex_unlock(&jobLk);
+	for(i = 1; i < aggThds; i++)
+		pthread_join(aggHlp[i], NULL);
+	aggThds = 1;
+	jobStop = 0;
+	jobGen = 0;
+	jobDone = 0;
+}
+
+/**sum, min and max of an array
+ * @param const int * a: values
+ * @param int n: number of values, > 0
+ * @param aggRes * res: result
+ * @ret void
+ * @author elithz
+ * @modified 10.18.2026*/
+void aggScan(const int * a, int n, aggRes * res){
+	//counter
+	int k;
+
+	pthread_mutex_lock(&aggLk);
+	jobOp = AGG_SCAN;
+	jobA = a;
+	jobN = n;
+	aggRun();
+
+	*res = partRes[0];
+	for(k = 1; k < aggThds && n >= AGG_PAR_MIN; k++){
+		res->sum += partRes[k].sum;
+		if(partRes[k].min < res->min)
+			res->min = partRes[k].min;
+		if(partRes[k].max > res->max)
+			res->max = partRes[k].max;
+	}
+	pthread_mutex_unlock(&aggLk);
+}
+
+/**histogram of an array
+ * @param const int * a: values
+ * @param int n: number of values
+ * @param int lo, hi: range covered by the buckets, lo <= hi
+ * @param int nb: number of buckets, 1 to AGG_MAX_BUCKETS
+ * @param long long * cnt: nb bucket counts
+ * @ret void
+ * @author elithz
+ * @modified 10.18.2026*/
+void aggHist(const int * a, int n, int lo, int hi, int nb, long long * cnt){
+	//counters
+	int k, b;
+
+	pthread_mutex_lock(&aggLk);
+	jobOp = AGG_HIST;
+	jobA = a;
+	jobN = n;
+	jobLo = lo;
+	jobHi = hi;
+	jobNb = nb;
+	aggRun();
+
+	memcpy(cnt, partHist[0], nb * sizeof(long long));
+	for(k = 1; k < aggThds && n >= AGG_PAR_MIN; k++)
+		for(b = 0; b < nb; b++)
+			cnt[b] += partHist[k][b];
+	pthread_mutex_unlock(&aggLk);
+}
@@ -0,0 +1,48 @@
+/**
+*		Filename:  aggScan.h
+*    Description:  Parallel vectorized scans over an array of balances
+*        Version:  1.0
+*        Created:  10.18.2026 15h10min27s
+*         Author:  Ningyuan Zhang （狮子劫博丽）(elithz), elithz@iastate.edu
+*        Company:  NERVE Software
+*/
+
+/*
+ *  Arrays of at least AGG_PAR_MIN values are split in equal chunks
+ *  over a pool of scan helpers (BAMNG_AGG_THREADS, default the number
+ *  of online cpus, at most AGG_MAX_THREADS). Every chunk runs a kernel
+ *  the compiler vectorizes, with an AVX2 clone picked at load time on
+ *  x86-64. One parallel scan runs at a time.
+ */
+
+#ifndef AGGSCAN
+#define AGGSCAN
+
+//smallest array worth splitting
+#define AGG_PAR_MIN 65536
+//most scan helpers
+#define AGG_MAX_THREADS 64
+//most histogram buckets
+#define AGG_MAX_BUCKETS 1024
+
+//result of a scan
+typedef struct aggRes_struct{
+	long long sum;
+	int min;
+	int max;
+}aggRes;
+
+//start the scan helpers, threads <= 0 reads BAMNG_AGG_THREADS
+//ret number of threads scans use
+int aggInit(int threads);
+
+//stop the scan helpers
+void aggFree();
+
+//sum, min and max of a[0..n-1], n > 0
+void aggScan(const int * a, int n, aggRes * res);
+
+//count a[0..n-1] in nb equal buckets over [lo, hi], cnt has nb entries
+void aggHist(const int * a, int n, int lo, int hi, int nb, long long * cnt);
+
+#endif
@@ -0,0 +1,110 @@
+/**
+*		Filename:  arena.c
+*    Description:  Bump allocator for the state of one cmd
+*        Version:  1.0
+*        Created:  10.18.2026 21h14min26s
+*         Author:  Ningyuan Zhang （狮子劫博丽）(elithz), elithz@iastate.edu
+*        Company:  NERVE Software
+*/
+
+#include "arena.h"
+#include <stdlib.h>
+
+//alignment of every allocation
+#define AR_ALIGN 16
+//room for the link in front of a spill block
+#define AR_LINK AR_ALIGN
+
+/**make an arena
+ * @param arena * ar: arena
+ * @param size_t cap: initial size in bytes
+ * @ret int: 0 = operation success, -1 = failure
+ * @author elithz
+ * @modified 10.18.2026*/
+int arInit(arena * ar, size_t cap){
+	ar->buf = malloc(cap);
+	ar->cap = ar->buf ? cap : 0;
+	ar->used = 0;
+	ar->spill = NULL;
+	ar->spillSize = 0;
+	return ar->buf ? 0 : -1;
+}
+
+/**take n bytes from the arena
+ * @param arena * ar: arena
+ * @param size_t n: bytes wanted
+ * @ret void *: memory, NULL = out of memory
+ * @author elithz
+ * @modified 10.18.2026*/
+void * arAlloc(arena * ar, size_t n){
+	//spill block
+	char * blk;
+
+	n = (n + AR_ALIGN - 1) & ~(size_t) (AR_ALIGN - 1);
+	if(ar->cap - ar->used >= n){
+		ar->used += n;
+		return ar->buf + ar->used - n;
+	}
+	//too big for what is left, chain a block for it alone
+	blk = malloc(AR_LINK + n);
+	if(!blk)
+		return NULL;
+	*(void **) blk = ar->spill;
+	ar->spill = blk;
+	ar->spillSize += n;
+	return blk + AR_LINK;
+}
+
+/**free the spill blocks of the current cmd
+ * @param arena * ar: arena
+ * @ret void
+ * @author elithz
+ * @modified 10.18.2026*/
+static void arDrop(arena * ar){
+	//spill block and the next one
+	void * blk, * next;
+
+	for(blk = ar->spill; blk; blk = next){
+		next = *(void **) blk;
+		free(blk);
+	}
+	ar->spill = NULL;
+	ar->used = 0;
+}
+
+/**drop everything allocated since the last reset
+ * @param arena * ar: arena
+ * @ret void
+ * @author elithz
+ * @modified 10.18.2026*/
+void arReset(arena * ar){
+	//grown buffer
+	char * grown;
+
+	if(!ar->spill){
+		ar->used = 0;
+		return;
+	}
+	arDrop(ar);
+	//make room for a cmd like this one, the old buffer holds nothing now
+	grown = malloc(ar->cap + ar->spillSize);
+	if(grown){
+		free(ar->buf);
+		ar->buf = grown;
+		ar->cap += ar->spillSize;
+	}
+	ar->spillSize = 0;
+}
+
+/**free the arena
+ * @param arena * ar: arena
+ * @ret void
+ * @author elithz
+ * @modified 10.18.2026*/
+void arFree(arena * ar){
+	arDrop(ar);
+	free(ar->buf);
+	ar->buf = NULL;
+	ar->cap = 0;
+	ar->spillSize = 0;
+}
@@ -0,0 +1,45 @@
+/**
+*		Filename:  arena.h
+*    Description:  Bump allocator for the state of one cmd
+*        Version:  1.0
+*        Created:  10.18.2026 21h14min26s
+*         Author:  Ningyuan Zhang （狮子劫博丽）(elithz), elithz@iastate.edu
+*        Company:  NERVE Software
+*/
+
+/*
+ *  Every worker (every fiber with BAMNG_FIBERS) owns an arena and takes
+ *  the tokens and legs of its cmd from it; arReset() after the cmd
+ *  drops them all at once. A cmd that does not fit spills into extra
+ *  blocks from malloc, and the next reset grows the arena by the spill
+ *  so a steady workload runs out of one block without any malloc.
+ */
+
+#ifndef ARENA
+#define ARENA
+
+#include <stddef.h>
+
+//arena
+typedef struct arena_struct{
+	char * buf;
+	size_t cap;
+	size_t used;
+	//extra blocks of the current cmd and their size
+	void * spill;
+	size_t spillSize;
+}arena;
+
+//make an arena of cap bytes, ret 0 = success, -1 = failure
+int arInit(arena * ar, size_t cap);
+
+//n bytes aligned for any type, ret NULL = out of memory
+void * arAlloc(arena * ar, size_t n);
+
+//drop everything allocated since the last reset
+void arReset(arena * ar);
+
+//free the arena
+void arFree(arena * ar);
+
+#endif
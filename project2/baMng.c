@@ -8,9 +8,32 @@
 */
 
 #include "baMng.h"
+#include "cmdQue.h"
+#include "wkPool.h"
+#include "fiber.h"
+#include "mvStore.h"
+#include "shmBank.h"
+#include "repLog.h"
+#include "detSch.h"
+#include "recLog.h"
+#include "trace.h"
+#include "lkProf.h"
+#include "txLegs.h"
+#include "ccStrat.h"
+#include "tpcPart.h"
+#include <sys/stat.h>
 #define MAX_COMMAND_SIZE 200
 #define NUM_ARGUMENTS 4
+//initial size of the arena of every worker
+#define CMD_ARENA 4096
 #define ARGUMENT_FORMAT "baMng workersNum accountNum out_file"
+//strategy when BAMNG_CC is not set, baMng_coarse is this file built
+//with BAMNG_COARSE
+#ifdef BAMNG_COARSE
+#define CC_DEFAULT "global"
+#else
+#define CC_DEFAULT "account"
+#endif
 
 //function prototypes in bankAccountManager init and define prototypes
 //sets up bank accounts
@@ -33,13 +56,10 @@ int workersNum;
 int accountNum;
 //accounts
 account * accounts;
-//cmd buffer
-LinkedList * cmdBf;
 
-//bank lock
-pthread_mutex_t bankLk;
-//lock to make str_tok threadsafe
-pthread_mutex_t tokLk;
+//bank lock, moves into shared memory with BAMNG_PROCS
+pthread_mutex_t bankPriv;
+pthread_mutex_t * bankLk = &bankPriv;
 //out file
 FILE * outFPt;
 
@@ -52,9 +72,6 @@ FILE * outFPt;
  * @author elithz
  * @modified 10.23.2017*/
 int main(int argc, char** argv){
-	//initialize cmd buffer
-	cmdBf = malloc(sizeof(LinkedList));
-
 	//parse input arguments
 	if(argParser(argc, argv))
 		//argument error
@@ -79,8 +96,11 @@ int main(int argc, char** argv){
 		return -1;
 
 	//free buffers
-	free(cmdBf);
-	free(accounts);
+	queFree();
+	mvFree();
+	//shared accounts go away with the process
+	if(!shmProcs())
+		free(accounts);
 	// freeAccount();
 	fclose(outFPt);
 
@@ -98,6 +118,14 @@ int accountSetup(){
 
 	//initialize BANK_accounts
 	initialize_accounts(accountNum);
+	//committed versions for snapshot reads
+	if(mvInit(accountNum))
+		return -1;
+	//lock request queues if cmds run in id order, and the concurrency
+	//control strategy
+	if(detInit(accountNum) || ccInit(accountNum, &accounts, &bankLk,
+		CC_DEFAULT))
+		return -1;
 
 	//loop through accountNum, create accounts for each
 	for(i = 0; i < accountNum; i++){
@@ -113,14 +141,8 @@ int accountSetup(){
  * @author elithz
  * @modified 10.23.2017 */
 int cmdBufferSetup(){
-	//initialize cmd buffer
-	pthread_mutex_init(&(cmdBf->lock), NULL);
-	cmdBf->head = NULL;
-	cmdBf->tail = NULL;
-	cmdBf->size = 0;
-
-	//return successfully
-	return 0;
+	//initialize cmd buffer and its priority classes
+	return queInit();
 }
 
 /**parse cmd line arguments
@@ -128,6 +150,9 @@ int cmdBufferSetup(){
  * @author elithz
  * @modified 10.23.2017*/
 int argParser(int argc, char** argv){
+	//type of out_file
+	struct stat outSt;
+
 	//check for correct number of arguments
 	if(argc != NUM_ARGUMENTS){
 		fprintf(stderr, "error (baMng): incorrect # of command " 
@@ -160,6 +185,9 @@ int argParser(int argc, char** argv){
 		fprintf(stderr, "baMng: exiting program\n");
 		return -1;
 	}
+	//a reader on the other end of a pipe wants every result at once
+	if(!fstat(fileno(outFPt), &outSt) && S_ISFIFO(outSt.st_mode))
+		setvbuf(outFPt, NULL, _IOLBF, 0);
 
 	//return successfully
 	return 0;
@@ -173,10 +201,6 @@ int argParser(int argc, char** argv){
  * @author elithz
  * @modified 10.23.2017 */
 int clientLoop(){
-	//pthread workers
-	pthread_t workers[workersNum];
-	//counter
-	int i;
 	//size_t used for getline
 	size_t n = 100;
 	//return value of getline
@@ -185,20 +209,39 @@ int clientLoop(){
 	char * cmd = malloc(MAX_COMMAND_SIZE * sizeof(char));
 	//cmd ID
 	int id = 1;
-
-	//init workers
-	for(i = 0; i < workersNum; i++)
-		pthread_create(&workers[i], NULL, rqstHdl, NULL);
-		//pthread_create(&workers[i], NULL, (void*)&rqstHdl, NULL);
-	pthread_mutex_init(&tokLk, NULL);
-	pthread_mutex_init(&bankLk, NULL);
+	//arrival time of refused cmds
+	struct timeval arrive;
+
+	pthread_mutex_init(bankLk, NULL);
+	//init workers, the pool grows and shrinks with the load, in worker
+	//processes if BAMNG_PROCS asks for them
+	if(shmProcs() ? shmStart(workersNum, accountNum, &accounts, &bankLk,
+		outFPt, rqstHdl, &running) : poolStart(workersNum, rqstHdl, &running))
+		return -1;
+	//record the cmd stream and trace cmds if asked to
+	if(recInit() || trInit())
+		return -1;
+	//ship committed TRANS to a follower or follow a primary
+	if(!shmProcs() && repInit(accountNum, accounts, bankLk))
+		return -1;
+	//profile lock contention if asked to
+	if(!shmProcs() && lpInit(accountNum))
+		return -1;
 
 	//client loop
 	while(1){
 		//read line
 		readSize = getline(&cmd, &n, stdin);
+		//end of input without END finishes like END
+		if(readSize <= 0){
+			running = 0;
+			break;
+		}
 		//null terminate line
-		cmd[readSize - 1] = '\0';
+		if(cmd[readSize - 1] == '\n')
+			cmd[readSize - 1] = '\0';
+		//keep it with its arrival time for replay
+		recCmd(cmd);
 		//check for end
 		if(strcmp(cmd, "END") == 0){
 			//mark done
@@ -209,20 +252,50 @@ int clientLoop(){
 
 		//print cmd id
 		printf("ID %d\n", id);
-		//add cmd to buffer
-		addCmd(cmd, id);
+		//add cmd to buffer, answer BUSY if admission control refuses it
+		if(shmProcs()){
+			if(shmPush(cmd, id) > 0)
+				fprintf(stderr, "%d INVALID REQUEST FORMAT\n", id);
+		}
+		//2PC decisions go straight to the PREP waiting for them
+		else if(tpcDecide(cmd, id))
+			;
+		else if(addCmd(cmd, id) > 0){
+			gettimeofday(&arrive, NULL);
+			prtBusy(outFPt, id, arrive);
+		}
 		//incremend id
 		id++;
 	}
 
+	//close the recording
+	recClose();
+
+	//worker processes report for themselves
+	if(shmProcs()){
+		shmJoin(stderr);
+		free(cmd);
+		return 0;
+	}
+
 	//clear out cmd buffer
 	while(cmdBf->size > 0)
 		//sleep to release control to worker thread
 		usleep(1);
 
 	//wait for workers to finish
-	for(i = 0; i < workersNum; i++)
-		pthread_join(workers[i], NULL);
+	poolJoin();
+	//flush the replication log
+	repStop(stderr);
+	//write the trace
+	trDump();
+
+	//report per class latency and pool sizing
+	quePrtStat(stderr);
+	poolPrtStat(stderr);
+	ccPrtStat(stderr);
+	mvPrtStat(stderr);
+	lpPrtStat(stderr);
 
 	//free cmd
 	free(cmd);
@@ -244,28 +317,37 @@ void icrctArgFmt(){
 void * rqstHdl(){
 	//current cmd
 	LinkedCommand cmd;
-	//string of arguments
-	char ** cmdTk = malloc(21 * sizeof(char*));
-	//current argument
-	char * curTok;
+	//tokens of the cmd, pointing into cmd.cmd
+	char ** cmdTk;
+	//current argument and strtok_r position
+	char * curTok, * save;
 	//stores account to check
 	int check_account;
 	//number of arguments in cmd
 	int tokenNum = 0;
 	//stores amount in check cmd
 	int amount;
-	//flag to mark insufficient funds
-	int isfctFd = 0;
-	//counters
-	int i, j;
+	//leg with insufficient funds, -1 = none
+	int isfctFd;
+	//legs of a TRANS, one per account in ascending order
+	int transNum;
+	int * transActs, * transAmts, * transBls;
 	//store timestamp
 	struct timeval timestamp2;
+	//result of a snapshot cmd
+	int mvRc;
+	//tokens and legs of the current cmd, dropped after each cmd
+	arena cmdAr;
+
+	if(arInit(&cmdAr, CMD_ARENA))
+		return NULL;
 
 	//while main loop is running or buffer isn't empty
 	while(running || cmdBf->size > 0){
-		//if no commands are present then sleep to release control of the thread
-		while(cmdBf->size == 0 && running)
-			usleep(1);
+		//if no commands are present wait for one, idle workers may leave
+		//the pool here
+		if(cmdBf->size == 0 && running && poolWait())
+			break;
 
 		//get next cmd
 		cmd = nextCmd();
@@ -274,117 +356,98 @@ void * rqstHdl(){
 			//if cmd = NULL we are currently out of commands
 			continue;
 
-		//parse cmd
-		pthread_mutex_lock(&tokLk);
-		curTok = strtok(cmd.cmd, " ");
-		while(curTok){
-			cmdTk[tokenNum] = malloc(21 * sizeof(char));
-			strncpy(cmdTk[tokenNum], curTok, 21);
-			tokenNum++;
-			curTok = strtok(NULL, " ");
+		//dispatcher shed the cmd under overload
+		if(cmd.shed){
+			prtBusy(outFPt, cmd.id, cmd.timestamp);
+			cmdDone(&cmd);
+			free(cmd.cmd);
+			continue;
 		}
-		pthread_mutex_unlock(&tokLk);
+
+		//parse cmd, a line of n chars has at most n / 2 + 1 tokens
+		cmdTk = arAlloc(&cmdAr, (strlen(cmd.cmd) / 2 + 1) * sizeof(char *));
+		for(curTok = cmdTk ? strtok_r(cmd.cmd, " ", &save) : NULL; curTok;
+			curTok = strtok_r(NULL, " ", &save))
+			cmdTk[tokenNum++] = curTok;
 		//execute cmd
+		//empty cmd
+		if(!tokenNum)
+			fprintf(stderr, "%d INVALID REQUEST FORMAT\n", cmd.id);
+		//CHECK of an unknown account
+		else if(strcmp(cmdTk[0], "CHECK") == 0 && tokenNum == 2
+			&& (txInt(cmdTk[1], &check_account) || check_account < 1
+			|| check_account > accountNum))
+			fprintf(stderr, "%d INVALID REQUEST FORMAT\n", cmd.id);
 		//if CHECK cmd
-		if(strcmp(cmdTk[0], "CHECK") == 0 && tokenNum == 2){
-			pthread_mutex_lock(&tokLk);
-			check_account = atoi(cmdTk[1]);
-			pthread_mutex_unlock(&tokLk);
-			pthread_mutex_lock(&(accounts[i-1].lock));
-			amount = read_account(check_account);
-			pthread_mutex_unlock(&(accounts[i-1].lock));
+		else if(strcmp(cmdTk[0], "CHECK") == 0 && tokenNum == 2){
+			amount = cc->check(check_account, cmd.id);
 			gettimeofday(&timestamp2, NULL);
 			flockfile(outFPt);
-			fprintf(outFPt, "%d BAL %d TIME %d.%06d %d.%06d\n", cmd.id, amount, cmd.timestamp.tv_sec, cmd.timestamp.tv_usec, timestamp2.tv_sec, timestamp2.tv_usec);
+			fprintf(outFPt, "%d BAL %d TIME %ld.%06ld %ld.%06ld\n", cmd.id,
+				amount, (long) cmd.timestamp.tv_sec,
+				(long) cmd.timestamp.tv_usec, (long) timestamp2.tv_sec,
+				(long) timestamp2.tv_usec);
 			funlockfile(outFPt);
+			queStat(&cmd);
 		}
+		//snapshot CHECK of several accounts or SUM
+		else if((mvRc = mvCmd(outFPt, &cmd, cmdTk, tokenNum)) >= 0){
+			if(mvRc)
+				fprintf(stderr, "%d INVALID REQUEST FORMAT\n", cmd.id);
+		}
+		//prepare part of a TRANS spanning several instances
+		else if((mvRc = tpcCmd(outFPt, &cmd, cmdTk, tokenNum,
+			accountNum, &cmdAr)) >= 0){
+			if(mvRc)
+				fprintf(stderr, "%d INVALID REQUEST FORMAT\n", cmd.id);
+		}
+		//a follower only takes writes from its primary
+		else if(strcmp(cmdTk[0], "TRANS") == 0 && repReadOnly()){
+			prtRdOnly(outFPt, cmd.id, cmd.timestamp);
+			queStat(&cmd);
+		}
+		//TRANS with an odd number of arguments or a bad leg
+		else if(strcmp(cmdTk[0], "TRANS") == 0 && (tokenNum % 2 == 0
+			|| tokenNum < 3 || (transNum = txLegs(&cmdAr, cmdTk + 1,
+			(tokenNum - 1) / 2, accountNum, &transActs, &transAmts)) < 0
+			|| !(transBls = arAlloc(&cmdAr, transNum * sizeof(int)))))
+			fprintf(stderr, "%d INVALID REQUEST FORMAT\n", cmd.id);
 		//judge if TRANS cmd
-		else if(strcmp(cmdTk[0], "TRANS") == 0 && tokenNum % 2 && tokenNum > 1){
-			//variables to store transaction info
-			int transNum = (tokenNum - 1) / 2;
-			int transActs[transNum];
-			int transAmts[transNum];
-			int transBls[transNum];
-			int temp;
-
-			//store accounts and transfer amounts
-			for(i = 0; i < transNum; i++){
-				pthread_mutex_lock(&tokLk);
-				transActs[i] = atoi(cmdTk[i*2+1]);
-				transAmts[i] = atoi(cmdTk[i*2+2]);
-				pthread_mutex_unlock(&tokLk);
-			}
-
-			//sort transactions in ascending order by account number
-			for(i = 0; i < transNum; i++){
-				for(j = i; j < transNum; j++){
-					if(transActs[j] < transActs[i]){
-						temp = transActs[i];
-						transActs[i] = transActs[j];
-						transActs[j] = temp;
-						temp = transAmts[i];
-						transAmts[i] = transAmts[j];
-						transAmts[j] = temp;
-					}
-				}
-			}
-
-			//lock accounts
-			for(i = 0; i < transNum; i++)
-				pthread_mutex_lock(&(accounts[transActs[i]-1].lock));
-
-			//check all transactions for sufficient funds
-			for(i = 0; i < transNum; i++){
-				transBls[i] = read_account(transActs[i]);
-				if(transBls[i] + transAmts[i] < 0){
-					//if ISF then let program know and * print to out file
-					gettimeofday(&timestamp2, NULL);
-					flockfile(outFPt);
-					fprintf(outFPt, "%d ISF %d TIME " 
-						"%d.06%d %d.06%d\n", 
-						cmd.id, transActs[i], 
-						cmd.timestamp.tv_sec, 
-						cmd.timestamp.tv_usec, 
-						timestamp2.tv_sec, 
-						timestamp2.tv_usec);
-					funlockfile(outFPt);
-					isfctFd = 1;
-					break;
-				}
-			}
-			//if we have sufficient funds
-			if(!isfctFd){
-				//execute transactions
-				for(i = 0; i < transNum; i++)
-					write_account(transActs[i], (transBls[i] + transAmts[i]));
-				//print transaction success
-				gettimeofday(&timestamp2, NULL);
-				flockfile(outFPt);
-				fprintf(outFPt, "%d OK TIME %d.%06d %d.%06d\n", 
-					cmd.id, cmd.timestamp.tv_sec, 
-					cmd.timestamp.tv_usec, 
-					timestamp2.tv_sec, timestamp2.tv_usec);
-				funlockfile(outFPt);
-			}
-			//unlock accounts
-			for(i = transNum - 1; i >=0; i--)
-				pthread_mutex_unlock(&(accounts[transActs[i]-1].lock));
+		else if(strcmp(cmdTk[0], "TRANS") == 0){
+			//the strategy locks, checks the funds and applies the legs
+			isfctFd = cc->trans(&cmdAr, transNum, transActs, transAmts,
+				transBls, cmd.id);
+			gettimeofday(&timestamp2, NULL);
+			flockfile(outFPt);
+			//if ISF then print the account that would overdraw
+			if(isfctFd >= 0)
+				fprintf(outFPt, "%d ISF %d TIME %ld.%06ld %ld.%06ld\n", cmd.id,
+					transActs[isfctFd], (long) cmd.timestamp.tv_sec,
+					(long) cmd.timestamp.tv_usec, (long) timestamp2.tv_sec,
+					(long) timestamp2.tv_usec);
+			//print transaction success
+			else
+				fprintf(outFPt, "%d OK TIME %ld.%06ld %ld.%06ld\n", 
+					cmd.id, (long) cmd.timestamp.tv_sec, 
+					(long) cmd.timestamp.tv_usec, 
+					(long) timestamp2.tv_sec, (long) timestamp2.tv_usec);
+			funlockfile(outFPt);
+			queStat(&cmd);
 		}
 		//invalid cmd
 		else
 			fprintf(stderr, "%d INVALID REQUEST FORMAT\n", cmd.id);
 		//free cmd
+		cmdDone(&cmd);
 		free(cmd.cmd);
-		for(i = 0; i < tokenNum; i++)
-			free(cmdTk[i]);
+		arReset(&cmdAr);
 		tokenNum = 0;
-		isfctFd = 0;
 	}
 
-	free(cmdTk);
+	arFree(&cmdAr);
 
 	//return
-	return;
+	return NULL;
 }
 
 /**attempt to lock an account mutex
@@ -412,103 +475,6 @@ int uLckAct(account * to_unlock){
 	return 0;
 }
 
-/**get next element in linked list
- * @param LinkedList * command_buffer: linked list to pull from
- * @ret char * cmd: will be next cmd in LinkedList (NULL if no cmd 
- * exists)
- * @author elithz
- * @modified 10.23.2017*/
-LinkedCommand nextCmd(){
-	//temporary pointer used to free head
-	LinkedCommand * temp_head;
-	//initialize return value
-	LinkedCommand ret;
-	//lock cmd buffer
-	pthread_mutex_lock(&(cmdBf->lock));
-
-	//are there any commands to pull?
-	if(cmdBf->size > 0){
-		//set return value
-		ret.id = cmdBf->head->id;
-		ret.cmd = malloc(MAX_COMMAND_SIZE * sizeof(char));
-		ret.timestamp = cmdBf->head->timestamp;
-		strncpy(ret.cmd, cmdBf->head->cmd, MAX_COMMAND_SIZE);
-		ret.next = NULL;
-
-		//move head and free memory from linked list
-		temp_head = cmdBf->head;
-		cmdBf->head = cmdBf->head->next;
-		free(temp_head->cmd);
-		free(temp_head);
-
-		//if head ran past tail set tail back to null
-		if(!cmdBf->head)
-			cmdBf->tail = NULL;
-
-		//update linked list size
-		cmdBf->size = cmdBf->size - 1;
-	}
-	else{
-		//unlock cmd buffer
-		pthread_mutex_unlock(&(cmdBf->lock));
-
-		ret.cmd = NULL;
-
-		//no commands in buffer
-		return ret;
-	}
-
-	//unlock cmd buffer
-	pthread_mutex_unlock(&(cmdBf->lock));
-
-	//return cmd
-	return ret;
-}
-
-/**add cmd onto linked list
- * @param LinkedList * command_buffer: cmd buffer to add cmd onto
- * @ret int: 0 = operation success -1 = operation failure
- * @author elithz
- * @modified 10.23.2017*/
-int addCmd(char * given_command, int id){
-	//initialize new LinkedCommand to add to list
-	LinkedCommand * new_tail = malloc(sizeof(LinkedCommand));
-
-	//construct the cmd
-	new_tail->cmd = malloc(MAX_COMMAND_SIZE * sizeof(char));
-	strncpy(new_tail->cmd, given_command, MAX_COMMAND_SIZE);
-	new_tail->id = id;
-	gettimeofday(&(new_tail->timestamp), NULL);
-	new_tail->next = NULL;
-
-	//lock command_buffer
-	pthread_mutex_lock(&(cmdBf->lock));
-
-	//is the list currently empty
-	if(cmdBf->size > 0){
-		//have tail point to this new cmd
-		cmdBf->tail->next = new_tail;
-
-		//set new tail and increment size of linked list
-		cmdBf->tail = new_tail;
-		cmdBf->size = cmdBf->size + 1;
-	}
-	else{
-		//add first element and set head and tail to it
-		cmdBf->head = new_tail;
-		cmdBf->tail = new_tail;
-
-		//size = one
-		cmdBf->size = 1;
-	}
-
-	//unlock cmd buffer
-	pthread_mutex_unlock(&(cmdBf->lock));
-
-	//return successfully
-	return 0;
-}
-
 //garbage, ignore
 // /*
 //  * frees memory allocated for Bank Accounts
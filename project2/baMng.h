@@ -41,12 +41,30 @@
 #include <sys/time.h>
 #endif
 
+#ifndef UNISTD
+#define UNISTD
+#include <unistd.h>
+#endif
+
+
+//priority classes, lower number is served first when deadlines tie
+#define CLS_URGENT 0
+#define CLS_TRANS 1
+#define CLS_CHECK 2
+#define CLS_NUM 3
 
 //store a command within linked list
 typedef struct LinkedCommand_struct{
-	char * command;
+	char * cmd;
 	int id;
 	struct timeval timestamp;
+	//priority class and absolute deadline
+	int cls;
+	struct timeval deadline;
+	//1 if the dispatcher shed this cmd instead of running it
+	int shed;
+	//lock set in deterministic mode, NULL otherwise
+	void * det;
 	struct LinkedCommand_struct * next;
 	
 }LinkedCommand;
@@ -58,14 +76,18 @@ typedef struct account_struct{
 }account;
 
 
-//data about a linked list
+//data about a linked list, one FIFO per priority class
 typedef struct LinkedList_struct{
 	pthread_mutex_t lock;
-	LinkedCommand * head;
-	LinkedCommand * tail;
+	LinkedCommand * head[CLS_NUM];
+	LinkedCommand * tail[CLS_NUM];
+	int clsSize[CLS_NUM];
 	int size;
 }LinkedList;
 
+//cmd buffer, lives in cmdQue.c
+extern LinkedList * cmdBf;
+
 // //free memory allocated for bankAccount not used
 // void freeAccount();
 
@@ -0,0 +1,475 @@
+/**
+*		Filename:  baRply.c
+*    Description:  Replay of recorded cmd streams and latency reports
+*        Version:  1.0
+*        Created:  10.18.2026 19h48min03s
+*         Author:  Ningyuan Zhang （狮子劫博丽）(elithz), elithz@iastate.edu
+*        Company:  NERVE Software
+*/
+
+/*
+ *  baRply recording speed server workersNum accountNum out_file
+ *    runs server with the other arguments, feeds it the recording (see
+ *    recLog.h) and prints a report of its out_file. speed 1 keeps the
+ *    recorded gaps, 2 halves them, 0 sends as fast as the pipe takes.
+ *  baRply -r out_file
+ *    prints the report of an existing out_file.
+ *  baRply -c baseline report
+ *    compares two reports, flags throughput drops and p50/p95/p99 rises
+ *    beyond BARPLY_TOL percent (default 10) and exits 1 if any.
+ *  baRply -b recording speed server workersNum accountNum out_file
+ *    plays the recording once per concurrency control strategy (BAMNG_CC,
+ *    see ccStrat.h) named in BARPLY_CC (default "global account striped
+ *    occ") and prints a table of throughput and latency of each.
+ *
+ *  A report has one "key values" line per measure, so two of them diff
+ *  cleanly:
+ *    cmds n / secs first arrival to last answer / thruput cmds per sec
+ *    lat KIND count p50 p95 p99 max     latency in ms, KIND ALL first
+ */
+
+#define _GNU_SOURCE
+#include "recLog.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+
+#define ARGUMENT_FORMAT "baRply recording speed server workersNum accountNum " \
+	"out_file\n       baRply -r out_file\n       baRply -c baseline report" \
+	"\n       baRply -b recording speed server workersNum accountNum out_file"
+//most result kinds in a report
+#define RPL_MAX_KINDS 16
+//latency changes below this many ms are noise
+#define RPL_NOISE_MS 0.1
+//strategies benchmarked when BARPLY_CC is not set, and most of them
+#define RPL_CC "global account striped occ"
+#define RPL_MAX_CC 16
+
+//latencies of one result kind
+typedef struct rplKind_struct{
+	char name[32];
+	double * lat;
+	int num;
+	int cap;
+}rplKind;
+
+//summary of a run, kind 0 is ALL
+typedef struct rplSum_struct{
+	int cmds;
+	double secs;
+	double thruput;
+	int kindNum;
+	struct{
+		char name[32];
+		int num;
+		//p50, p95, p99 and max in ms
+		double q[4];
+	}kinds[RPL_MAX_KINDS + 1];
+}rplSum;
+
+/**microseconds since the epoch
+ * @ret long long: now
+ * @author elithz
+ * @modified 10.18.2026*/
+static long long rplNow(){
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return (long long) tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+/**read an unsigned LEB128 varint
+ * @param unsigned char ** p: read position, advanced
+ * @param unsigned char * end: end of the data
+ * @param unsigned long long * v: value
+ * @ret int: 0 = operation success, -1 = truncated
+ * @author elithz
+ * @modified 10.18.2026*/
+static int rplVarint(unsigned char ** p, unsigned char * end,
+	unsigned long long * v){
+	//bit position
+	int shift = 0;
+
+	*v = 0;
+	while(*p < end && shift < 64){
+		*v |= (unsigned long long) (**p & 0x7f) << shift;
+		if(!(*(*p)++ & 0x80))
+			return 0;
+		shift += 7;
+	}
+	return -1;
+}
+
+/**add a latency to its kind
+ * @param rplKind * kinds: kinds so far
+ * @param int * kindNum: number of kinds
+ * @param char * name: kind of the result
+ * @param double ms: latency
+ * @ret void
+ * @author elithz
+ * @modified 10.18.2026*/
+static void rplAdd(rplKind * kinds, int * kindNum, char * name, double ms){
+	//counter
+	int i;
+	double * grown;
+
+	for(i = 0; i < *kindNum && strcmp(kinds[i].name, name); i++)
+		;
+	if(i == *kindNum){
+		if(*kindNum == RPL_MAX_KINDS)
+			return;
+		snprintf(kinds[i].name, sizeof(kinds[i].name), "%s", name);
+		(*kindNum)++;
+	}
+	if(kinds[i].num == kinds[i].cap){
+		kinds[i].cap = kinds[i].cap ? kinds[i].cap * 2 : 1024;
+		grown = realloc(kinds[i].lat, kinds[i].cap * sizeof(double));
+		if(!grown){
+			kinds[i].cap = kinds[i].num;
+			return;
+		}
+		kinds[i].lat = grown;
+	}
+	kinds[i].lat[kinds[i].num++] = ms;
+}
+
+/**compare two latencies for qsort
+ * @ret int: <0, 0, >0 as a is smaller, equal, larger than b
+ * @author elithz
+ * @modified 10.18.2026*/
+static int rplCmp(const void * a, const void * b){
+	double x = *(const double *) a, y = *(const double *) b;
+	return (x > y) - (x < y);
+}
+
+/**sum up the results in an out_file
+ * @param char * path: out_file of a run
+ * @param rplSum * sum: summary
+ * @ret int: 0 = operation success, -1 = failure
+ * @author elithz
+ * @modified 10.18.2026*/
+static int rplLoad(char * path, rplSum * sum){
+	//counter
+	int i;
+	//out file and its lines
+	FILE * in = fopen(path, "r");
+	char * line = NULL, * t;
+	size_t n = 0;
+	//fields of a result
+	int id;
+	char kind[32];
+	long long as, au, bs, bu, a, b;
+	//span of the run
+	long long first = -1, last = -1;
+	rplKind kinds[RPL_MAX_KINDS + 1];
+	int kindNum = 1;
+	rplKind * k;
+
+	if(!in){
+		fprintf(stderr, "error (baRply): failed to open %s\n", path);
+		return -1;
+	}
+	memset(kinds, 0, sizeof(kinds));
+	strcpy(kinds[0].name, "ALL");
+
+	while(getline(&line, &n, in) > 0){
+		if(sscanf(line, "%d %31s", &id, kind) != 2 || !(t = strstr(line, " TIME "))
+			|| sscanf(t, " TIME %lld.%lld %lld.%lld", &as, &au, &bs, &bu) != 4)
+			continue;
+		a = as * 1000000 + au;
+		b = bs * 1000000 + bu;
+		if(first < 0 || a < first)
+			first = a;
+		if(b > last)
+			last = b;
+		rplAdd(kinds, &kindNum, "ALL", (b - a) / 1000.0);
+		rplAdd(kinds, &kindNum, kind, (b - a) / 1000.0);
+	}
+	free(line);
+	fclose(in);
+
+	sum->cmds = kinds[0].num;
+	sum->secs = last > first ? (last - first) / 1e6 : 0.0;
+	sum->thruput = last > first ? kinds[0].num * 1e6 / (last - first) : 0.0;
+	sum->kindNum = 0;
+	for(i = 0; i < kindNum; i++){
+		k = &kinds[i];
+		if(!k->num)
+			continue;
+		qsort(k->lat, k->num, sizeof(double), rplCmp);
+		strcpy(sum->kinds[sum->kindNum].name, k->name);
+		sum->kinds[sum->kindNum].num = k->num;
+		sum->kinds[sum->kindNum].q[0] = k->lat[(k->num - 1) * 50 / 100];
+		sum->kinds[sum->kindNum].q[1] = k->lat[(k->num - 1) * 95 / 100];
+		sum->kinds[sum->kindNum].q[2] = k->lat[(k->num - 1) * 99 / 100];
+		sum->kinds[sum->kindNum].q[3] = k->lat[k->num - 1];
+		sum->kindNum++;
+		free(k->lat);
+	}
+	return 0;
+}
+
+/**print the report of an out_file
+ * @param char * path: out_file of a run
+ * @ret int: 0 = operation success, -1 = failure
+ * @author elithz
+ * @modified 10.18.2026*/
+static int rplReport(char * path){
+	//counter
+	int i;
+	//summary of the run
+	rplSum sum;
+
+	if(rplLoad(path, &sum))
+		return -1;
+	printf("cmds %d\n", sum.cmds);
+	printf("secs %.3f\n", sum.secs);
+	printf("thruput %.1f\n", sum.thruput);
+	for(i = 0; i < sum.kindNum; i++)
+		printf("lat %s %d %.3f %.3f %.3f %.3f\n", sum.kinds[i].name,
+			sum.kinds[i].num, sum.kinds[i].q[0], sum.kinds[i].q[1],
+			sum.kinds[i].q[2], sum.kinds[i].q[3]);
+	return 0;
+}
+
+/**compare a report against a baseline
+ * @param char * basePath: baseline report
+ * @param char * newPath: new report
+ * @ret int: 0 = no regression, 1 = regression, -1 = failure
+ * @author elithz
+ * @modified 10.18.2026*/
+static int rplCompare(char * basePath, char * newPath){
+	//counter
+	int i;
+	//reports
+	FILE * base = fopen(basePath, "r"), * cur = fopen(newPath, "r");
+	char bl[256], cl[256], name[32], cname[32];
+	double bv[5], cv[5];
+	int bn, cn;
+	//tolerance in percent
+	double tol = getenv("BARPLY_TOL") ? atof(getenv("BARPLY_TOL")) : 10;
+	int bad = 0;
+	//percentile names
+	const char * pct[4] = {"p50", "p95", "p99", "max"};
+
+	if(!base || !cur){
+		fprintf(stderr, "error (baRply): failed to open reports\n");
+		return -1;
+	}
+	while(fgets(bl, sizeof(bl), base)){
+		if(sscanf(bl, "thruput %lf", &bv[0]) == 1){
+			rewind(cur);
+			while(fgets(cl, sizeof(cl), cur))
+				if(sscanf(cl, "thruput %lf", &cv[0]) == 1){
+					printf("thruput\t%.1f\t%.1f\t%+.1f%%%s\n", bv[0], cv[0],
+						bv[0] > 0 ? (cv[0] - bv[0]) * 100 / bv[0] : 0.0,
+						cv[0] < bv[0] * (1 - tol / 100) ? "\tREGRESSION" : "");
+					bad |= cv[0] < bv[0] * (1 - tol / 100);
+				}
+			continue;
+		}
+		if(sscanf(bl, "lat %31s %d %lf %lf %lf %lf", name, &bn, &bv[0], &bv[1],
+			&bv[2], &bv[3]) != 6)
+			continue;
+		rewind(cur);
+		while(fgets(cl, sizeof(cl), cur)){
+			if(sscanf(cl, "lat %31s %d %lf %lf %lf %lf", cname, &cn, &cv[0],
+				&cv[1], &cv[2], &cv[3]) != 6 || strcmp(name, cname))
+				continue;
+			//max is shown but too noisy to judge
+			for(i = 0; i < 4; i++){
+				printf("%s %s\t%.3f\t%.3f\t%+.1f%%", name, pct[i], bv[i], cv[i],
+					bv[i] > 0 ? (cv[i] - bv[i]) * 100 / bv[i] : 0.0);
+				if(i < 3 && cv[i] > bv[i] * (1 + tol / 100)
+					&& cv[i] - bv[i] > RPL_NOISE_MS){
+					printf("\tREGRESSION");
+					bad = 1;
+				}
+				printf("\n");
+			}
+		}
+	}
+	fclose(base);
+	fclose(cur);
+	return bad;
+}
+
+/**play a recording into a server
+ * @param char ** argv: recording speed server workersNum accountNum out_file
+ * @ret int: 0 = operation success, -1 = failure
+ * @author elithz
+ * @modified 10.18.2026*/
+static int rplRun(char ** argv){
+	//recording
+	FILE * rec = fopen(argv[1], "rb");
+	unsigned char * data, * p, * end;
+	long size;
+	//replay speed, time line
+	double speed = atof(argv[2]);
+	long long start, due, wait;
+	unsigned long long gap, len, at = 0;
+	//server and the pipe to it
+	int fds[2], devNull, status;
+	pid_t pid;
+	FILE * to;
+	//END was among the records
+	int sawEnd = 0;
+	long long lines = 0;
+
+	if(!rec){
+		fprintf(stderr, "error (baRply): failed to open %s\n", argv[1]);
+		return -1;
+	}
+	fseek(rec, 0, SEEK_END);
+	size = ftell(rec);
+	rewind(rec);
+	data = malloc(size > 0 ? size : 1);
+	if(!data || fread(data, 1, size, rec) != (size_t) size || size < 13
+		|| memcmp(data, REC_MAGIC, 4) || data[4] != REC_VERSION){
+		fprintf(stderr, "error (baRply): %s is not a recording\n", argv[1]);
+		return -1;
+	}
+	fclose(rec);
+	p = data + 13;
+	end = data + size;
+
+	if(pipe(fds))
+		return -1;
+	fflush(stdout);
+	pid = fork();
+	if(pid < 0)
+		return -1;
+	if(pid == 0){
+		//ID lines are of no use here
+		devNull = open("/dev/null", O_WRONLY);
+		dup2(fds[0], 0);
+		dup2(devNull, 1);
+		close(fds[0]);
+		close(fds[1]);
+		execv(argv[3], argv + 3);
+		fprintf(stderr, "error (baRply): failed to execute %s\n", argv[3]);
+		_exit(1);
+	}
+	close(fds[0]);
+	signal(SIGPIPE, SIG_IGN);
+	to = fdopen(fds[1], "w");
+
+	start = rplNow();
+	while(p < end){
+		if(rplVarint(&p, end, &gap) || rplVarint(&p, end, &len)
+			|| len > (unsigned long long) (end - p)){
+			fprintf(stderr, "error (baRply): recording truncated after %lld "
+				"lines\n", lines);
+			break;
+		}
+		at += gap;
+		//keep the recorded gaps, scaled
+		if(speed > 0){
+			due = start + (long long) (at / speed);
+			wait = due - rplNow();
+			if(wait > 0){
+				fflush(to);
+				usleep(wait);
+			}
+		}
+		fwrite(p, 1, len, to);
+		putc('\n', to);
+		sawEnd = len == 3 && !memcmp(p, "END", 3);
+		p += len;
+		lines++;
+		if(sawEnd)
+			break;
+	}
+	//a recording cut short still ends the run
+	if(!sawEnd)
+		fputs("END\n", to);
+	fclose(to);
+	free(data);
+	waitpid(pid, &status, 0);
+
+	fprintf(stderr, "baRply: %lld lines in %.3f s\n", lines,
+		(rplNow() - start) / 1e6);
+	if(!WIFEXITED(status) || WEXITSTATUS(status)){
+		fprintf(stderr, "error (baRply): %s did not exit cleanly\n", argv[3]);
+		return -1;
+	}
+	return 0;
+}
+
+/**play a recording into a server, then report its out_file
+ * @param char ** argv: recording speed server workersNum accountNum out_file
+ * @ret int: 0 = operation success, -1 = failure
+ * @author elithz
+ * @modified 10.18.2026*/
+static int rplPlay(char ** argv){
+	return rplRun(argv) ? -1 : rplReport(argv[6]);
+}
+
+/**play a recording once per concurrency control strategy and compare
+ * @param char ** argv: recording speed server workersNum accountNum out_file
+ * @ret int: 0 = operation success, -1 = failure
+ * @author elithz
+ * @modified 10.18.2026*/
+static int rplBench(char ** argv){
+	//counters
+	int i, j, k;
+	//strategies to run
+	char * val = getenv("BARPLY_CC");
+	char * names = strdup(val ? val : RPL_CC), * save, * name;
+	char * ccs[RPL_MAX_CC];
+	rplSum sums[RPL_MAX_CC];
+	int ccNum = 0;
+
+	if(!names)
+		return -1;
+	for(name = strtok_r(names, " ,", &save); name && ccNum < RPL_MAX_CC;
+		name = strtok_r(NULL, " ,", &save)){
+		fprintf(stderr, "baRply: BAMNG_CC=%s\n", name);
+		setenv("BAMNG_CC", name, 1);
+		if(rplRun(argv) || rplLoad(argv[6], &sums[ccNum])){
+			free(names);
+			return -1;
+		}
+		ccs[ccNum++] = name;
+	}
+
+	//throughput and latency over all cmds
+	printf("cc\tcmds\tsecs\tthruput\tp50ms\tp95ms\tp99ms\tmaxms\n");
+	for(i = 0; i < ccNum; i++)
+		printf("%s\t%d\t%.3f\t%.1f\t%.3f\t%.3f\t%.3f\t%.3f\n", ccs[i],
+			sums[i].cmds, sums[i].secs, sums[i].thruput, sums[i].kinds[0].q[0],
+			sums[i].kinds[0].q[1], sums[i].kinds[0].q[2], sums[i].kinds[0].q[3]);
+	//then per result kind, in the order of the first run
+	printf("cc\tkind\tcount\tp50ms\tp95ms\tp99ms\tmaxms\n");
+	for(k = 1; ccNum && k < sums[0].kindNum; k++)
+		for(i = 0; i < ccNum; i++)
+			for(j = 1; j < sums[i].kindNum; j++)
+				if(strcmp(sums[i].kinds[j].name, sums[0].kinds[k].name) == 0)
+					printf("%s\t%s\t%d\t%.3f\t%.3f\t%.3f\t%.3f\n", ccs[i],
+						sums[i].kinds[j].name, sums[i].kinds[j].num,
+						sums[i].kinds[j].q[0], sums[i].kinds[j].q[1],
+						sums[i].kinds[j].q[2], sums[i].kinds[j].q[3]);
+	free(names);
+	return 0;
+}
+
+/**replay a recording or report and compare runs
+ * @ret int: 0 = operation success, 1 = regression, -1 = error encountered
+ * @author elithz
+ * @modified 10.18.2026*/
+int main(int argc, char ** argv){
+	if(argc == 3 && strcmp(argv[1], "-r") == 0)
+		return rplReport(argv[2]);
+	if(argc == 4 && strcmp(argv[1], "-c") == 0)
+		return rplCompare(argv[2], argv[3]);
+	if(argc == 8 && strcmp(argv[1], "-b") == 0)
+		return rplBench(argv + 1);
+	if(argc == 7)
+		return rplPlay(argv);
+	fprintf(stderr, "baRply expected format: " ARGUMENT_FORMAT "\n");
+	return -1;
+}
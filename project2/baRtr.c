@@ -0,0 +1,688 @@
+/**
+*		Filename:  baRtr.c
+*    Description:  Router partitioning the accounts over several baMng
+*        Version:  1.0
+*        Created:  10.18.2026 18h05min37s
+*         Author:  Ningyuan Zhang （狮子劫博丽）(elithz), elithz@iastate.edu
+*        Company:  NERVE Software
+*/
+
+/*
+ *  baRtr takes the cmds of baMng on stdin and spreads the accounts over
+ *  instances copies of baMng running on this box. Account a lives in
+ *  instance (a-1) % instances as local account (a-1) / instances + 1.
+ *
+ *  CHECK and TRANS touching one instance are forwarded as they are. A
+ *  TRANS touching several instances runs two phase commit (tpcPart.h):
+ *  PREP to every instance, COMMIT when all voted yes, ABORT otherwise.
+ *  A BUSY vote (lock timeout) is retried RTR_TRIES times. Lines for an
+ *  instance are written once per round of the event loop, so PREPs and
+ *  decisions of concurrent transactions travel in batches.
+ *
+ *  Results are written to out_file with the router's ids and accounts.
+ *    BARTR_BANK  server to run (default ./baMng)
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include "txLegs.h"
+
+#define NUM_ARGUMENTS 5
+#define ARGUMENT_FORMAT "baRtr instances workersNum accountNum out_file"
+//most instances, one bit each in a vote mask
+#define RTR_MAX_PARTS 64
+//longest int written with a space in front, " -2147483648"
+#define RTR_INT_LEN 12
+//tries of a transaction that keeps getting BUSY votes
+#define RTR_TRIES 5
+//bytes read at once
+#define RTR_CHUNK 65536
+
+//what a line sent to an instance was
+#define RTR_PLAIN 0
+#define RTR_PREP 1
+#define RTR_DEC 2
+
+//why a transaction was voted down
+#define RTR_YES 0
+#define RTR_BUSY 1
+#define RTR_ISF 2
+
+//a line sent to an instance, the n-th one gets id n there
+typedef struct rtrSent_struct{
+	int gid;
+	int kind;
+}rtrSent;
+
+//one baMng instance
+typedef struct rtrPart_struct{
+	pid_t pid;
+	FILE * in;
+	int outFd;
+	//partial result line
+	char * buf;
+	size_t len;
+	size_t cap;
+	//lines sent so far
+	rtrSent * sent;
+	int sentNum;
+	int sentCap;
+}rtrPart;
+
+//a TRANS over several instances
+typedef struct rtrTxn_struct{
+	int gid;
+	struct timeval arrive;
+	//instances involved and their legs in local accounts
+	unsigned long long parts;
+	char ** legs;
+	//votes and decision acks still to come
+	int votes;
+	int acks;
+	unsigned long long yes;
+	int no;
+	int isfAct;
+	int tries;
+}rtrTxn;
+
+//instances
+static rtrPart * parts;
+static int partNum;
+static int accountNum;
+//out file
+static FILE * outFPt;
+//open transactions by router id
+static rtrTxn ** txns = NULL;
+static int txnCap = 0;
+static int openTxns = 0;
+//statistics
+static int cmdNum = 0;
+static int singleNum = 0;
+static int crossNum = 0;
+static int retryNum = 0;
+static int busyNum = 0;
+
+/**allocate or give up
+ * @param size_t size: bytes
+ * @ret void *: the memory
+ * @author elithz
+ * @modified 10.18.2026*/
+static void * rtrMem(size_t size){
+	//the memory
+	void * mem = malloc(size);
+
+	if(!mem){
+		fprintf(stderr, "error (baRtr): out of memory\n");
+		exit(-1);
+	}
+	return mem;
+}
+
+/**instance of a global account
+ * @param int a: account ID from 1
+ * @ret int: instance index
+ * @author elithz
+ * @modified 10.18.2026*/
+static int rtrPartOf(int a){
+	return (a - 1) % partNum;
+}
+
+/**local account ID of a global account
+ * @param int a: account ID from 1
+ * @ret int: account ID in its instance, from 1
+ * @author elithz
+ * @modified 10.18.2026*/
+static int rtrLocal(int a){
+	return (a - 1) / partNum + 1;
+}
+
+/**global account ID of a local account
+ * @param int k: instance index
+ * @param int l: local account ID from 1
+ * @ret int: global account ID
+ * @author elithz
+ * @modified 10.18.2026*/
+static int rtrGlobal(int k, int l){
+	return (l - 1) * partNum + k + 1;
+}
+
+/**queue a line for an instance and remember what it was
+ * @param int k: instance index
+ * @param int gid: router id the line belongs to
+ * @param int kind: RTR_PLAIN, RTR_PREP or RTR_DEC
+ * @param char * line: line without newline
+ * @ret void
+ * @author elithz
+ * @modified 10.18.2026*/
+static void rtrSend(int k, int gid, int kind, char * line){
+	//instance
+	rtrPart * p = &parts[k];
+	rtrSent * grown;
+
+	if(p->sentNum == p->sentCap){
+		p->sentCap = p->sentCap ? p->sentCap * 2 : 1024;
+		grown = realloc(p->sent, p->sentCap * sizeof(rtrSent));
+		if(!grown){
+			fprintf(stderr, "error (baRtr): out of memory\n");
+			exit(-1);
+		}
+		p->sent = grown;
+	}
+	p->sent[p->sentNum].gid = gid;
+	p->sent[p->sentNum].kind = kind;
+	p->sentNum++;
+	fprintf(p->in, "%s\n", line);
+}
+
+/**write a result line with the arrival time of the router
+ * @param int gid: router id
+ * @param struct timeval arrive: arrival at the router
+ * @param char * what: text between the id and TIME
+ * @ret void
+ * @author elithz
+ * @modified 10.18.2026*/
+static void rtrEmit(int gid, struct timeval arrive, char * what){
+	//time of the answer
+	struct timeval now;
+
+	gettimeofday(&now, NULL);
+	fprintf(outFPt, "%d %s TIME %ld.%06ld %ld.%06ld\n", gid, what,
+		(long) arrive.tv_sec, (long) arrive.tv_usec, (long) now.tv_sec,
+		(long) now.tv_usec);
+}
+
+/**send PREP to every instance of a transaction
+ * @param rtrTxn * t: the transaction
+ * @ret void
+ * @author elithz
+ * @modified 10.18.2026*/
+static void rtrPrep(rtrTxn * t){
+	//counter
+	int k;
+	//line to send
+	char * line;
+
+	t->votes = 0;
+	t->yes = 0;
+	t->no = RTR_YES;
+	for(k = 0; k < partNum; k++){
+		if(!(t->parts >> k & 1))
+			continue;
+		line = rtrMem(strlen(t->legs[k]) + 5 + RTR_INT_LEN);
+		sprintf(line, "PREP %d%s", t->gid, t->legs[k]);
+		rtrSend(k, t->gid, RTR_PREP, line);
+		free(line);
+		t->votes++;
+	}
+}
+
+/**a transaction got all its decision acks, answer or retry it
+ * @param rtrTxn * t: the transaction
+ * @ret void
+ * @author elithz
+ * @modified 10.18.2026*/
+static void rtrFinish(rtrTxn * t){
+	//counter
+	int k;
+	//result text
+	char what[32];
+
+	if(t->no == RTR_BUSY && t->tries < RTR_TRIES){
+		t->tries++;
+		retryNum++;
+		rtrPrep(t);
+		return;
+	}
+	if(t->no == RTR_YES)
+		rtrEmit(t->gid, t->arrive, "OK");
+	else if(t->no == RTR_ISF){
+		snprintf(what, sizeof(what), "ISF %d", t->isfAct);
+		rtrEmit(t->gid, t->arrive, what);
+	}
+	else{
+		rtrEmit(t->gid, t->arrive, "BUSY");
+		busyNum++;
+	}
+
+	for(k = 0; k < partNum; k++)
+		free(t->legs[k]);
+	free(t->legs);
+	txns[t->gid] = NULL;
+	free(t);
+	openTxns--;
+}
+
+/**all votes are in, send the decision
+ * @param rtrTxn * t: the transaction
+ * @ret void
+ * @author elithz
+ * @modified 10.18.2026*/
+static void rtrDecide(rtrTxn * t){
+	//counter
+	int k;
+	//line to send
+	char line[64];
+
+	snprintf(line, sizeof(line), "%s %d", t->no == RTR_YES ? "COMMIT" : "ABORT",
+		t->gid);
+	t->acks = 0;
+	for(k = 0; k < partNum; k++){
+		if(!(t->yes >> k & 1))
+			continue;
+		rtrSend(k, t->gid, RTR_DEC, line);
+		t->acks++;
+	}
+	if(!t->acks)
+		rtrFinish(t);
+}
+
+/**route one cmd line
+ * @param char * line: cmd line
+ * @param int gid: router id of the cmd
+ * @ret void
+ * @author elithz
+ * @modified 10.18.2026*/
+static void rtrCmd(char * line, int gid){
+	//counters
+	int i, k;
+	//PRI prefix kept on forwarded lines
+	char pri[32] = "";
+	int cls, skip = 0;
+	//tokens, a line of n chars has at most n / 2 + 1
+	size_t maxTok;
+	char ** tok, * save, * cur;
+	int tokNum = 0;
+	//accounts and amounts
+	int * acts, * amts;
+	int n;
+	//forwarded line, bytes written to it and to each instance's legs
+	char * fwd;
+	size_t used, legLen[RTR_MAX_PARTS];
+	//legs per instance
+	int legNum[RTR_MAX_PARTS];
+	//instances touched
+	unsigned long long mask = 0;
+	rtrTxn * t;
+	rtrTxn ** grown;
+
+	if(sscanf(line, "PRI %d %n", &cls, &skip) == 1 && skip > 0){
+		snprintf(pri, sizeof(pri), "PRI %d ", cls);
+		line += skip;
+	}
+	maxTok = strlen(line) / 2 + 1;
+	tok = rtrMem(maxTok * sizeof(char *));
+	acts = rtrMem(maxTok * sizeof(int));
+	amts = rtrMem(maxTok * sizeof(int));
+	fwd = NULL;
+	for(cur = strtok_r(line, " ", &save); cur;
+		cur = strtok_r(NULL, " ", &save))
+		tok[tokNum++] = cur;
+	if(!tokNum)
+		goto invalid;
+	//every token forwarded is an int
+	fwd = rtrMem(strlen(pri) + 6 + tokNum * RTR_INT_LEN);
+
+	if(strcmp(tok[0], "CHECK") == 0 && tokNum > 1){
+		for(i = 1; i < tokNum; i++){
+			if(txInt(tok[i], &acts[i]) || acts[i] < 1 || acts[i] > accountNum)
+				goto invalid;
+			mask |= 1ULL << rtrPartOf(acts[i]);
+		}
+		//snapshots do not span instances
+		if(mask & (mask - 1))
+			goto invalid;
+		k = rtrPartOf(acts[1]);
+		used = sprintf(fwd, "%sCHECK", pri);
+		for(i = 1; i < tokNum; i++)
+			used += sprintf(fwd + used, " %d", rtrLocal(acts[i]));
+		rtrSend(k, gid, RTR_PLAIN, fwd);
+		goto done;
+	}
+
+	if(strcmp(tok[0], "TRANS") || tokNum < 3 || tokNum % 2 == 0)
+		goto invalid;
+	n = (tokNum - 1) / 2;
+	for(i = 0; i < n; i++){
+		//parsed as strictly as baMng does
+		if(txInt(tok[i * 2 + 1], &acts[i]) || txInt(tok[i * 2 + 2], &amts[i])
+			|| acts[i] < 1 || acts[i] > accountNum)
+			goto invalid;
+		mask |= 1ULL << rtrPartOf(acts[i]);
+	}
+
+	//one instance, forward as it is
+	if(!(mask & (mask - 1))){
+		k = rtrPartOf(acts[0]);
+		used = sprintf(fwd, "%sTRANS", pri);
+		for(i = 0; i < n; i++)
+			used += sprintf(fwd + used, " %d %d", rtrLocal(acts[i]), amts[i]);
+		rtrSend(k, gid, RTR_PLAIN, fwd);
+		singleNum++;
+		goto done;
+	}
+
+	//several instances, two phase commit, PREP merges legs on the same
+	//account itself
+	t = calloc(1, sizeof(rtrTxn));
+	if(!t || !(t->legs = calloc(partNum, sizeof(char *)))){
+		fprintf(stderr, "error (baRtr): out of memory\n");
+		exit(-1);
+	}
+	t->gid = gid;
+	t->parts = mask;
+	gettimeofday(&(t->arrive), NULL);
+	memset(legNum, 0, sizeof(legNum));
+	for(i = 0; i < n; i++)
+		legNum[rtrPartOf(acts[i])]++;
+	for(k = 0; k < partNum; k++){
+		t->legs[k] = rtrMem(legNum[k] * 2 * RTR_INT_LEN + 1);
+		t->legs[k][0] = '\0';
+		legLen[k] = 0;
+	}
+	for(i = 0; i < n; i++){
+		k = rtrPartOf(acts[i]);
+		legLen[k] += sprintf(t->legs[k] + legLen[k], " %d %d",
+			rtrLocal(acts[i]), amts[i]);
+	}
+	if(gid >= txnCap){
+		txnCap = txnCap ? txnCap * 2 : 1024;
+		while(gid >= txnCap)
+			txnCap *= 2;
+		grown = realloc(txns, txnCap * sizeof(rtrTxn *));
+		if(!grown){
+			fprintf(stderr, "error (baRtr): out of memory\n");
+			exit(-1);
+		}
+		txns = grown;
+	}
+	txns[gid] = t;
+	openTxns++;
+	crossNum++;
+	rtrPrep(t);
+	goto done;
+
+invalid:
+	fprintf(stderr, "%d INVALID REQUEST FORMAT\n", gid);
+done:
+	free(tok);
+	free(acts);
+	free(amts);
+	free(fwd);
+}
+
+/**handle a result line of an instance
+ * @param int k: instance index
+ * @param char * line: result line without newline
+ * @ret void
+ * @author elithz
+ * @modified 10.18.2026*/
+static void rtrResult(int k, char * line){
+	//id in the instance, position after it
+	int cid, pos = 0;
+	//local account of an ISF
+	int a, apos = 0;
+	long long txid;
+	rtrSent * s;
+	rtrTxn * t;
+
+	if(sscanf(line, "%d %n", &cid, &pos) != 1 || cid < 1
+		|| cid > parts[k].sentNum){
+		fprintf(stderr, "error (baRtr): bad result \"%s\", ignored\n", line);
+		return;
+	}
+	s = &parts[k].sent[cid - 1];
+	line += pos;
+
+	if(s->kind == RTR_PLAIN){
+		if(sscanf(line, "ISF %d%n", &a, &apos) == 1)
+			fprintf(outFPt, "%d ISF %d%s\n", s->gid, rtrGlobal(k, a), line + apos);
+		else
+			fprintf(outFPt, "%d %s\n", s->gid, line);
+		return;
+	}
+
+	t = s->gid < txnCap ? txns[s->gid] : NULL;
+	if(!t)
+		return;
+	if(s->kind == RTR_DEC){
+		if(--t->acks == 0)
+			rtrFinish(t);
+		return;
+	}
+
+	//a vote
+	if(strncmp(line, "PREPARED", 8) == 0)
+		t->yes |= 1ULL << k;
+	else if(sscanf(line, "NO %lld ISF %d", &txid, &a) == 2){
+		t->no = RTR_ISF;
+		t->isfAct = rtrGlobal(k, a);
+	}
+	//lock timeout or refused by admission control
+	else if(t->no == RTR_YES)
+		t->no = RTR_BUSY;
+	if(--t->votes == 0)
+		rtrDecide(t);
+}
+
+/**read what an fd has and hand every complete line to a handler
+ * @param int fd: fd to read
+ * @param char ** buf: partial line buffer
+ * @param size_t * len: bytes in the buffer
+ * @param size_t * cap: size of the buffer
+ * @param void (*fn)(int, char *): handler
+ * @param int k: first argument of the handler
+ * @ret int: 1 = read something, 0 = end of file
+ * @author elithz
+ * @modified 10.18.2026*/
+static int rtrLines(int fd, char ** buf, size_t * len, size_t * cap,
+	void (*fn)(int, char *), int k){
+	//bytes read and lines found
+	ssize_t r;
+	char * line, * nl, * grown;
+
+	if(*cap - *len < RTR_CHUNK + 1){
+		grown = realloc(*buf, *len + RTR_CHUNK + 1);
+		if(!grown){
+			fprintf(stderr, "error (baRtr): out of memory\n");
+			exit(-1);
+		}
+		*buf = grown;
+		*cap = *len + RTR_CHUNK + 1;
+	}
+	r = read(fd, *buf + *len, RTR_CHUNK);
+	if(r <= 0)
+		return 0;
+	*len += r;
+	(*buf)[*len] = '\0';
+
+	line = *buf;
+	while((nl = memchr(line, '\n', *buf + *len - line))){
+		*nl = '\0';
+		fn(k, line);
+		line = nl + 1;
+	}
+	*len -= line - *buf;
+	memmove(*buf, line, *len);
+	return 1;
+}
+
+//set once END was read
+static int ending = 0;
+//next router id
+static int nextGid = 1;
+
+/**handle a line of stdin
+ * @param int k: unused
+ * @param char * line: cmd line without newline
+ * @ret void
+ * @author elithz
+ * @modified 10.18.2026*/
+static void rtrStdin(int k, char * line){
+	if(ending)
+		return;
+	if(strcmp(line, "END") == 0){
+		ending = 1;
+		return;
+	}
+	printf("ID %d\n", nextGid);
+	cmdNum++;
+	rtrCmd(line, nextGid++);
+}
+
+/**start instance k of the bank server
+ * @param int k: instance index
+ * @param char * bank: path of the server
+ * @param char * workers: workersNum argument
+ * @ret int: 0 = operation success, -1 = failure
+ * @author elithz
+ * @modified 10.18.2026*/
+static int rtrSpawn(int k, char * bank, char * workers){
+	//pipes to and from the instance
+	int in[2], out[2];
+	//local account count
+	char acts[16];
+	int devNull;
+
+	if(pipe2(in, O_CLOEXEC) || pipe2(out, O_CLOEXEC))
+		return -1;
+	snprintf(acts, sizeof(acts), "%d", (accountNum - k + partNum - 1) / partNum);
+	fflush(stdout);
+	parts[k].pid = fork();
+	if(parts[k].pid < 0)
+		return -1;
+	if(parts[k].pid == 0){
+		//stdin from the router, results on fd 3, ID lines dropped
+		devNull = open("/dev/null", O_WRONLY);
+		dup2(in[0], 0);
+		dup2(out[1], 3);
+		dup2(devNull, 1);
+		execl(bank, bank, workers, acts, "/dev/fd/3", (char *) NULL);
+		fprintf(stderr, "error (baRtr): failed to execute %s\n", bank);
+		_exit(1);
+	}
+	close(in[0]);
+	close(out[1]);
+	parts[k].in = fdopen(in[1], "w");
+	parts[k].outFd = out[0];
+	if(!parts[k].in)
+		return -1;
+	setvbuf(parts[k].in, NULL, _IOFBF, RTR_CHUNK);
+	return 0;
+}
+
+/**start the instances, route stdin to them until END and collect results
+ * @param argv[1]: integer, number of baMng instances
+ * @param argv[2]: integer, number of working threads of each instance
+ * @param argv[3]: integer, number of accounts over all instances
+ * @param argv[4]: string, name of output file
+ * @ret int: 0 = operation success, -1 = error encountered
+ * @author elithz
+ * @modified 10.18.2026*/
+int main(int argc, char ** argv){
+	//counter
+	int k;
+	//server to run
+	char * bank = getenv("BARTR_BANK") ? getenv("BARTR_BANK") : "./baMng";
+	//fds to wait on, the instance of each
+	struct pollfd fds[RTR_MAX_PARTS + 1];
+	int fdPart[RTR_MAX_PARTS + 1];
+	int fdNum;
+	//partial stdin line
+	char * inBuf = NULL;
+	size_t inLen = 0, inCap = 0;
+	//END was passed on to the instances
+	int ended = 0;
+
+	if(argc != NUM_ARGUMENTS || sscanf(argv[1], "%d", &partNum) != 1
+		|| sscanf(argv[3], "%d", &accountNum) != 1 || partNum < 1
+		|| partNum > RTR_MAX_PARTS || accountNum < partNum){
+		fprintf(stderr, "baRtr expected format: " ARGUMENT_FORMAT "\n");
+		fprintf(stderr, "instances 1 to %d, at least one account each\n",
+			RTR_MAX_PARTS);
+		return -1;
+	}
+	outFPt = fopen(argv[4], "w");
+	parts = calloc(partNum, sizeof(rtrPart));
+	if(!outFPt || !parts){
+		fprintf(stderr, "error (baRtr): failed to open out_file\n");
+		return -1;
+	}
+	//an instance that died must not kill the router
+	signal(SIGPIPE, SIG_IGN);
+	for(k = 0; k < partNum; k++)
+		if(rtrSpawn(k, bank, argv[2])){
+			perror("error (baRtr): starting instance");
+			return -1;
+		}
+
+	while(1){
+		fdNum = 0;
+		if(!ending){
+			fds[fdNum].fd = 0;
+			fds[fdNum].events = POLLIN;
+			fdPart[fdNum++] = -1;
+		}
+		for(k = 0; k < partNum; k++)
+			if(parts[k].outFd >= 0){
+				fds[fdNum].fd = parts[k].outFd;
+				fds[fdNum].events = POLLIN;
+				fdPart[fdNum++] = k;
+			}
+		if(!fdNum)
+			break;
+		if(poll(fds, fdNum, -1) < 0)
+			continue;
+
+		for(k = 0; k < fdNum; k++){
+			if(!fds[k].revents)
+				continue;
+			if(fdPart[k] < 0){
+				//end of input counts as END
+				if(!rtrLines(0, &inBuf, &inLen, &inCap, rtrStdin, -1))
+					ending = 1;
+			}
+			else if(!rtrLines(fds[k].fd, &(parts[fdPart[k]].buf),
+				&(parts[fdPart[k]].len), &(parts[fdPart[k]].cap), rtrResult,
+				fdPart[k])){
+				close(parts[fdPart[k]].outFd);
+				parts[fdPart[k]].outFd = -1;
+			}
+		}
+
+		//instances finish once no transaction waits for them
+		if(ending && !ended && !openTxns){
+			for(k = 0; k < partNum; k++){
+				fputs("END\n", parts[k].in);
+				fclose(parts[k].in);
+			}
+			ended = 1;
+		}
+		//one write per instance and round
+		if(!ended)
+			for(k = 0; k < partNum; k++)
+				fflush(parts[k].in);
+	}
+
+	for(k = 0; k < partNum; k++){
+		waitpid(parts[k].pid, NULL, 0);
+		free(parts[k].buf);
+		free(parts[k].sent);
+	}
+	fprintf(stderr, "router: %d cmds, %d single instance TRANS, %d cross "
+		"instance TRANS (%d retries, %d busy)\n", cmdNum, singleNum, crossNum,
+		retryNum, busyNum);
+
+	free(parts);
+	free(txns);
+	free(inBuf);
+	fclose(outFPt);
+	return 0;
+}
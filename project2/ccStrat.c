@@ -0,0 +1,533 @@
+/**
+*		Filename:  ccStrat.c
+*    Description:  Concurrency control strategies of the server
+*        Version:  1.0
+*        Created:  10.18.2026 21h52min40s
+*         Author:  Ningyuan Zhang （狮子劫博丽）(elithz), elithz@iastate.edu
+*        Company:  NERVE Software
+*/
+
+#include "ccStrat.h"
+#include "cmdQue.h"
+#include "fiber.h"
+#include "mvStore.h"
+#include "repLog.h"
+#include "shmBank.h"
+#include "trace.h"
+#include "lkProf.h"
+#include <errno.h>
+
+//stripes when BAMNG_CC_STRIPES is not set
+#define CC_STRIPES 64
+//first backoff of a PREP waiting for a lock, usec
+#define CC_BACKOFF 50
+
+//account table and bank lock of the server
+static account ** ccActs;
+static pthread_mutex_t ** ccBank;
+//striped locks
+static pthread_mutex_t * stripes = NULL;
+static int stripeNum;
+//commit versions of occ, odd while a commit writes the account
+static unsigned * ccVer = NULL;
+//occ validations that failed
+static long long ccRetries = 0;
+
+/**take a lock, traced and profiled as account acct
+ * @param pthread_mutex_t * lk: lock
+ * @param int acct: account, 0 = bank
+ * @param int id: cmd taking it
+ * @ret void
+ * @author elithz
+ * @modified 10.18.2026*/
+static void ccLock(pthread_mutex_t * lk, int acct, int id){
+	TR_BEGIN(TR_LOCK, acct);
+	LP_LOCK(lk, acct, id);
+	TR_END(TR_LOCK, acct);
+}
+
+/**take a lock unless that takes longer than the deadline
+ * @param pthread_mutex_t * lk: lock
+ * @param long long deadline: usec since the epoch
+ * @ret int: 0 = locked, -1 = timed out
+ * @author elithz
+ * @modified 10.18.2026*/
+static int ccLockBy(pthread_mutex_t * lk, long long deadline){
+	//time to sleep before the next attempt and result of the last one
+	long backoff = CC_BACKOFF;
+	struct timeval now;
+	int rc;
+
+	while((rc = pthread_mutex_trylock(lk))){
+		//a shared lock left by a worker process that died is ours now
+		if(rc == EOWNERDEAD){
+			pthread_mutex_consistent(lk);
+			return 0;
+		}
+		gettimeofday(&now, NULL);
+		if(tvUsec(now) >= deadline)
+			return -1;
+		fbrSleep(backoff);
+		if(backoff < 1000)
+			backoff *= 2;
+	}
+	return 0;
+}
+
+/**lock of an account
+ * @param int acct: account
+ * @ret pthread_mutex_t *: its lock
+ * @author elithz
+ * @modified 10.18.2026*/
+static pthread_mutex_t * actLk(int acct){
+	return &((*ccActs)[acct - 1].lock);
+}
+
+/**write balances to the legs and publish them
+ * @param int n: legs
+ * @param int * acts: accounts
+ * @param int * bls: balances to write
+ * @ret void
+ * @author elithz
+ * @modified 10.18.2026*/
+static void ccWrite(int n, int * acts, int * bls){
+	//counter
+	int i;
+
+	for(i = 0; i < n; i++)
+		write_account(acts[i], bls[i]);
+	//publish the new versions for snapshot readers and the follower
+	mvCommit(n, acts, bls);
+	repAppend(n, acts, bls);
+}
+
+/**step the occ versions of the legs, odd before a write, even after
+ * @param int n: legs
+ * @param int * acts: accounts
+ * @ret void
+ * @author elithz
+ * @modified 10.18.2026*/
+static void ccBump(int n, int * acts){
+	//counter
+	int i;
+
+	for(i = 0; i < n; i++)
+		__atomic_store_n(&ccVer[acts[i]], ccVer[acts[i]] + 1, __ATOMIC_RELEASE);
+}
+
+/**read the legs, and write them if no leg overdraws
+ * @param int n: legs
+ * @param int * acts: accounts
+ * @param int * amts: amounts
+ * @param int * bls: balances read, then written
+ * @ret int: -1 = applied, i = leg i overdraws
+ * @author elithz
+ * @modified 10.18.2026*/
+static int ccApply(int n, int * acts, int * amts, int * bls){
+	//counter
+	int i;
+
+	for(i = 0; i < n; i++){
+		bls[i] = read_account(acts[i]);
+		if(bls[i] + amts[i] < 0)
+			return i;
+	}
+	for(i = 0; i < n; i++)
+		bls[i] += amts[i];
+	ccWrite(n, acts, bls);
+	return -1;
+}
+
+/**CHECK under the bank lock
+ * @param int acct: account
+ * @param int id: cmd
+ * @ret int: balance
+ * @author elithz
+ * @modified 10.18.2026*/
+static int glbCheck(int acct, int id){
+	//balance
+	int amount;
+
+	ccLock(*ccBank, 0, id);
+	amount = read_account(acct);
+	LP_UNLOCK(*ccBank, 0);
+	return amount;
+}
+
+/**TRANS under the bank lock, ar is not needed
+ * @ret int: -1 = applied, i = leg i overdraws
+ * @author elithz
+ * @modified 10.18.2026*/
+static int glbTrans(arena * ar, int n, int * acts, int * amts, int * bls,
+	int id){
+	//result
+	int rc;
+
+	(void) ar;
+	ccLock(*ccBank, 0, id);
+	rc = ccApply(n, acts, amts, bls);
+	LP_UNLOCK(*ccBank, 0);
+	return rc;
+}
+
+/**PREP under the bank lock, only the deadline is needed
+ * @ret void *: the bank lock, NULL = timed out
+ * @author elithz
+ * @modified 10.18.2026*/
+static void * glbPrep(arena * ar, int n, int * acts, long long deadline,
+	int id){
+	(void) ar;
+	(void) n;
+	(void) acts;
+	(void) id;
+	return ccLockBy(*ccBank, deadline) ? NULL : *ccBank;
+}
+
+/**end a PREP under the bank lock
+ * @ret void
+ * @author elithz
+ * @modified 10.18.2026*/
+static void glbCommit(void * held, int n, int * acts, int * bls){
+	if(bls)
+		ccWrite(n, acts, bls);
+	pthread_mutex_unlock(held);
+}
+
+/**CHECK under the account lock
+ * @param int acct: account
+ * @param int id: cmd
+ * @ret int: balance
+ * @author elithz
+ * @modified 10.18.2026*/
+static int actCheck(int acct, int id){
+	//balance
+	int amount;
+
+	ccLock(actLk(acct), acct, id);
+	amount = read_account(acct);
+	LP_UNLOCK(actLk(acct), acct);
+	return amount;
+}
+
+/**TRANS under the locks of its accounts, taken in ascending order,
+ * ar is not needed
+ * @ret int: -1 = applied, i = leg i overdraws
+ * @author elithz
+ * @modified 10.18.2026*/
+static int actTrans(arena * ar, int n, int * acts, int * amts, int * bls,
+	int id){
+	//counter and result
+	int i, rc;
+
+	(void) ar;
+	for(i = 0; i < n; i++)
+		ccLock(actLk(acts[i]), acts[i], id);
+	rc = ccApply(n, acts, amts, bls);
+	for(i = n - 1; i >= 0; i--)
+		LP_UNLOCK(actLk(acts[i]), acts[i]);
+	return rc;
+}
+
+/**PREP under the locks of its accounts, taken in ascending order, ar
+ * and id are not needed
+ * @ret void *: acts, NULL = timed out
+ * @author elithz
+ * @modified 10.18.2026*/
+static void * actPrep(arena * ar, int n, int * acts, long long deadline,
+	int id){
+	//locks taken
+	int held;
+
+	(void) ar;
+	(void) id;
+	for(held = 0; held < n; held++)
+		if(ccLockBy(actLk(acts[held]), deadline))
+			break;
+	if(held == n)
+		return acts;
+	while(held--)
+		pthread_mutex_unlock(actLk(acts[held]));
+	return NULL;
+}
+
+/**end a PREP under the locks of its accounts
+ * @ret void
+ * @author elithz
+ * @modified 10.18.2026*/
+static void actCommit(void * held, int n, int * acts, int * bls){
+	//counter
+	int i;
+
+	(void) held;
+	if(bls)
+		ccWrite(n, acts, bls);
+	for(i = n - 1; i >= 0; i--)
+		pthread_mutex_unlock(actLk(acts[i]));
+}
+
+/**CHECK under the stripe of the account, profiled as the stripe's
+ * first account
+ * @param int acct: account
+ * @param int id: cmd
+ * @ret int: balance
+ * @author elithz
+ * @modified 10.18.2026*/
+static int strCheck(int acct, int id){
+	//stripe and balance
+	int s = (acct - 1) % stripeNum, amount;
+
+	ccLock(&stripes[s], s + 1, id);
+	amount = read_account(acct);
+	LP_UNLOCK(&stripes[s], s + 1);
+	return amount;
+}
+
+/**mark the stripes of the legs
+ * @param arena * ar: arena of the cmd
+ * @param int n: legs
+ * @param int * acts: accounts
+ * @ret char *: 1 for every stripe used, NULL = no memory
+ * @author elithz
+ * @modified 10.18.2026*/
+static char * strUsed(arena * ar, int n, int * acts){
+	//counter
+	int i;
+	//stripes used
+	char * used = arAlloc(ar, stripeNum);
+
+	if(used){
+		memset(used, 0, stripeNum);
+		for(i = 0; i < n; i++)
+			used[(acts[i] - 1) % stripeNum] = 1;
+	}
+	return used;
+}
+
+/**TRANS under the stripes of its accounts, taken in ascending order
+ * @ret int: -1 = applied, i = leg i overdraws
+ * @author elithz
+ * @modified 10.18.2026*/
+static int strTrans(arena * ar, int n, int * acts, int * amts, int * bls,
+	int id){
+	//counter and result
+	int i, rc;
+	//stripes used, in order by construction, NULL = no memory, take all
+	char * used = strUsed(ar, n, acts);
+
+	for(i = 0; i < stripeNum; i++)
+		if(!used || used[i])
+			ccLock(&stripes[i], i + 1, id);
+	rc = ccApply(n, acts, amts, bls);
+	for(i = stripeNum - 1; i >= 0; i--)
+		if(!used || used[i])
+			LP_UNLOCK(&stripes[i], i + 1);
+	return rc;
+}
+
+/**PREP under the stripes of its accounts, taken in ascending order, id
+ * is not needed
+ * @ret void *: stripes held, NULL = timed out or no memory
+ * @author elithz
+ * @modified 10.18.2026*/
+static void * strPrep(arena * ar, int n, int * acts, long long deadline,
+	int id){
+	//stripe
+	int i;
+	//stripes used
+	char * used = strUsed(ar, n, acts);
+
+	(void) id;
+	if(!used)
+		return NULL;
+	for(i = 0; i < stripeNum; i++)
+		if(used[i] && ccLockBy(&stripes[i], deadline))
+			break;
+	if(i == stripeNum)
+		return used;
+	while(i--)
+		if(used[i])
+			pthread_mutex_unlock(&stripes[i]);
+	return NULL;
+}
+
+/**end a PREP under the stripes of its accounts
+ * @ret void
+ * @author elithz
+ * @modified 10.18.2026*/
+static void strCommit(void * held, int n, int * acts, int * bls){
+	//stripe
+	int i;
+	//stripes used
+	char * used = held;
+
+	if(bls)
+		ccWrite(n, acts, bls);
+	for(i = stripeNum - 1; i >= 0; i--)
+		if(used[i])
+			pthread_mutex_unlock(&stripes[i]);
+}
+
+/**CHECK without a lock, under the account lock if a commit ran
+ * meanwhile: commits write under it, and spinning on the version would
+ * burn a core for as long as the backend delays the write
+ * @param int acct: account
+ * @param int id: cmd
+ * @ret int: balance
+ * @author elithz
+ * @modified 10.18.2026*/
+static int occCheck(int acct, int id){
+	//versions before and after and balance
+	unsigned v1, v2;
+	int amount;
+
+	v1 = __atomic_load_n(&ccVer[acct], __ATOMIC_ACQUIRE);
+	amount = read_account(acct);
+	v2 = __atomic_load_n(&ccVer[acct], __ATOMIC_ACQUIRE);
+	if(v1 == v2 && !(v1 & 1))
+		return amount;
+	__atomic_fetch_add(&ccRetries, 1, __ATOMIC_RELAXED);
+	return actCheck(acct, id);
+}
+
+/**TRANS that reads without locks and locks only to validate and write
+ * @ret int: -1 = applied, i = leg i overdraws
+ * @author elithz
+ * @modified 10.18.2026*/
+static int occTrans(arena * ar, int n, int * acts, int * amts, int * bls,
+	int id){
+	//counters and result
+	int i, rc;
+	//versions read, NULL = no memory, lock before reading instead
+	unsigned * seen = arAlloc(ar, n * sizeof(unsigned));
+
+	while(1){
+		//read phase, the backend delay is paid here without locks
+		if(!seen)
+			for(i = 0; i < n; i++)
+				ccLock(actLk(acts[i]), acts[i], id);
+		for(i = 0; i < n; i++){
+			if(seen)
+				seen[i] = __atomic_load_n(&ccVer[acts[i]], __ATOMIC_ACQUIRE);
+			bls[i] = read_account(acts[i]);
+		}
+
+		//validate under the account locks
+		if(seen){
+			for(i = 0; i < n; i++)
+				ccLock(actLk(acts[i]), acts[i], id);
+			for(i = 0; i < n && seen[i] == ccVer[acts[i]] && !(seen[i] & 1);
+				i++)
+				;
+			if(i < n){
+				for(i = n - 1; i >= 0; i--)
+					LP_UNLOCK(actLk(acts[i]), acts[i]);
+				__atomic_fetch_add(&ccRetries, 1, __ATOMIC_RELAXED);
+				continue;
+			}
+		}
+
+		//write phase, versions are odd while the accounts change
+		for(rc = -1, i = 0; i < n && rc < 0; i++)
+			if(bls[i] + amts[i] < 0)
+				rc = i;
+		if(rc < 0){
+			for(i = 0; i < n; i++)
+				bls[i] += amts[i];
+			ccBump(n, acts);
+			ccWrite(n, acts, bls);
+			ccBump(n, acts);
+		}
+		for(i = n - 1; i >= 0; i--)
+			LP_UNLOCK(actLk(acts[i]), acts[i]);
+		return rc;
+	}
+}
+
+/**end a PREP under the locks of its accounts, stepping the versions
+ * around the write so optimistic readers see it
+ * @ret void
+ * @author elithz
+ * @modified 10.18.2026*/
+static void occCommit(void * held, int n, int * acts, int * bls){
+	if(bls){
+		ccBump(n, acts);
+		ccWrite(n, acts, bls);
+		ccBump(n, acts);
+	}
+	actCommit(held, n, acts, NULL);
+}
+
+//every strategy, the first is used for unknown names
+static ccStrat ccAll[] = {
+	{"account", actCheck, actTrans, actPrep, actCommit},
+	{"global", glbCheck, glbTrans, glbPrep, glbCommit},
+	{"striped", strCheck, strTrans, strPrep, strCommit},
+	{"occ", occCheck, occTrans, actPrep, occCommit}
+};
+ccStrat * cc = &ccAll[0];
+
+/**pick the strategy and allocate what it needs
+ * @param int accountNum: number of accounts
+ * @param account ** accts: account table of the server
+ * @param pthread_mutex_t ** bankLk: bank lock of the server
+ * @param const char * dflt: strategy when BAMNG_CC is not set
+ * @ret int: 0 = operation success, -1 = failure
+ * @author elithz
+ * @modified 10.18.2026*/
+int ccInit(int accountNum, account ** accts, pthread_mutex_t ** bankLk,
+	const char * dflt){
+	//counter
+	int i;
+	//environment values
+	char * val = getenv("BAMNG_CC");
+	const char * name = val ? val : dflt;
+
+	ccActs = accts;
+	ccBank = bankLk;
+	for(i = 0; i < (int) (sizeof(ccAll) / sizeof(ccAll[0]))
+		&& strcmp(ccAll[i].name, name); i++)
+		;
+	if(i == sizeof(ccAll) / sizeof(ccAll[0])){
+		fprintf(stderr, "error (baMng): bad BAMNG_CC \"%s\", ignored\n", name);
+		i = 0;
+	}
+	//private locks and versions do not reach other processes
+	if(shmProcs() && i > 1){
+		fprintf(stderr, "error (baMng): BAMNG_CC \"%s\" needs a single "
+			"process, using account\n", name);
+		i = 0;
+	}
+	cc = &ccAll[i];
+
+	if(cc->check == strCheck){
+		val = getenv("BAMNG_CC_STRIPES");
+		stripeNum = val && atoi(val) > 0 ? atoi(val) : CC_STRIPES;
+		if(stripeNum > accountNum)
+			stripeNum = accountNum;
+		stripes = malloc(stripeNum * sizeof(pthread_mutex_t));
+		if(!stripes)
+			return -1;
+		for(i = 0; i < stripeNum; i++)
+			pthread_mutex_init(&stripes[i], NULL);
+	}
+	if(cc->check == occCheck){
+		ccVer = calloc(accountNum + 1, sizeof(unsigned));
+		if(!ccVer)
+			return -1;
+	}
+	return 0;
+}
+
+/**print the strategy and its retries
+ * @param FILE * out: report file
+ * @ret void
+ * @author elithz
+ * @modified 10.18.2026*/
+void ccPrtStat(FILE * out){
+	fprintf(out, "cc %s", cc->name);
+	if(cc->check == strCheck)
+		fprintf(out, " stripes %d", stripeNum);
+	if(cc->check == occCheck)
+		fprintf(out, " retries %lld", ccRetries);
+	fprintf(out, "\n");
+}
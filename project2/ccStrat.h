@@ -0,0 +1,67 @@
+/**
+*		Filename:  ccStrat.h
+*    Description:  Concurrency control strategies of the server
+*        Version:  1.0
+*        Created:  10.18.2026 21h52min40s
+*         Author:  Ningyuan Zhang （狮子劫博丽）(elithz), elithz@iastate.edu
+*        Company:  NERVE Software
+*/
+
+/*
+ *  How CHECK and TRANS keep each other out is picked at startup with
+ *  BAMNG_CC (default account, global for baMng_coarse):
+ *    global    one bank lock around every cmd (the old baMng_coarse)
+ *    account   a lock per account, TRANS locks its accounts in
+ *              ascending order
+ *    striped   BAMNG_CC_STRIPES locks (default 64), account a uses
+ *              stripe (a-1) % stripes, stripes are locked in order
+ *    occ       optimistic: TRANS reads its balances without locks, then
+ *              locks its accounts only to check that no commit changed
+ *              them and to write, and starts over if one did. CHECK
+ *              reads seqlock style against the same version counters.
+ *  With BAMNG_PROCS only global and account work, their locks are in
+ *  shared memory. PREP (tpcPart.c) holds the same locks as a TRANS of
+ *  its legs until the decision, occ takes the account locks and steps
+ *  the versions when the COMMIT writes.
+ */
+
+#ifndef CCSTRAT
+#define CCSTRAT
+
+#include "baMng.h"
+#include "arena.h"
+
+//a strategy
+typedef struct ccStrat_struct{
+	//name in BAMNG_CC
+	const char * name;
+	//balance of account acct for CHECK cmd id
+	int (*check)(int acct, int id);
+	//apply the n legs of TRANS cmd id, accounts ascending and distinct,
+	//bls gets the balances read, ret -1 = applied, i = leg i would
+	//overdraw and nothing was written
+	int (*trans)(arena * ar, int n, int * acts, int * amts, int * bls,
+		int id);
+	//take what keeps the n legs of PREP cmd id apart from CHECK and
+	//TRANS, accounts ascending and distinct, giving up at deadline (usec
+	//since the epoch), ret what commit releases, NULL = nothing is held
+	void * (*prep)(arena * ar, int n, int * acts, long long deadline,
+		int id);
+	//end a prepared PREP: write the balances bls to its legs unless NULL
+	//(ABORT), then release held
+	void (*commit)(void * held, int n, int * acts, int * bls);
+}ccStrat;
+
+//strategy in use
+extern ccStrat * cc;
+
+//pick the strategy from BAMNG_CC, dflt if not set, the account table
+//and bank lock are looked up through accts and bankLk on every use
+//since BAMNG_PROCS moves them, ret 0 = success, -1 = failure
+int ccInit(int accountNum, account ** accts, pthread_mutex_t ** bankLk,
+	const char * dflt);
+
+//print the strategy and its retries
+void ccPrtStat(FILE * out);
+
+#endif
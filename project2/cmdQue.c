@@ -0,0 +1,570 @@
+/**
+*		Filename:  cmdQue.c
+*    Description:  Deadline aware cmd dispatcher shared by the bank servers
+*        Version:  1.0
+*        Created:  10.18.2026 10h02min11s
+*         Author:  Ningyuan Zhang （狮子劫博丽）(elithz), elithz@iastate.edu
+*        Company:  NERVE Software
+*/
+
+#include "cmdQue.h"
+#include "detSch.h"
+#include "trace.h"
+#include <math.h>
+
+//cmd buffer
+LinkedList * cmdBf;
+//finished cmds are counted here when set
+int * queDoneCnt = NULL;
+//signaled when a cmd is added
+static pthread_cond_t queCv = PTHREAD_COND_INITIALIZER;
+
+//relative deadline of each class in usec
+static long long clsBdgt[CLS_NUM] = {10000, 100000, 1000000};
+//names used in the statistics
+static const char * clsName[CLS_NUM] = {"URGENT", "TRANS", "CHECK"};
+
+//finished cmd latencies of each class in usec
+static long long * latSmp[CLS_NUM];
+static int latNum[CLS_NUM];
+static int latCap[CLS_NUM];
+//cmds that finished after their deadline
+static int latMiss[CLS_NUM];
+//lock for the statistics
+static pthread_mutex_t statLk = PTHREAD_MUTEX_INITIALIZER;
+
+//admission limit and cmds currently queued or running
+static int maxInflt = 0;
+static int inflt = 0;
+//cmds refused at admission and shed by CoDel, per class
+static int refused[CLS_NUM];
+static int shedNum[CLS_NUM];
+
+//CoDel target and interval in usec, target 0 = off
+static long long cdlTgt = 0;
+static long long cdlItv = 0;
+//CoDel state, guarded by cmdBf->lock
+static long long cdlFirstAbove = 0;
+static long long cdlDropNext = 0;
+static int cdlCount = 0;
+static int cdlDropping = 0;
+
+/**microseconds since the epoch of a timeval
+ * @param struct timeval tv: time to convert
+ * @ret long long: tv in usec
+ * @author elithz
+ * @modified 10.18.2026*/
+long long tvUsec(struct timeval tv){
+	return (long long) tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+/**initialize cmd buffer and read class deadlines
+ * @ret int: 0 = operation success, -1 = failure
+ * @author elithz
+ * @modified 10.18.2026 */
+int queInit(){
+	//counter
+	int i;
+	//deadlines from the environment
+	char * val = getenv("BAMNG_DEADLINE");
+	//parsed deadlines in ms
+	long long ms[CLS_NUM];
+
+	if(val){
+		if(sscanf(val, "%lld,%lld,%lld", &ms[0], &ms[1], &ms[2]) == CLS_NUM
+			&& ms[0] >= 0 && ms[1] >= 0 && ms[2] >= 0){
+			for(i = 0; i < CLS_NUM; i++)
+				clsBdgt[i] = ms[i] * 1000;
+		}
+		else
+			fprintf(stderr, "error (baMng): bad BAMNG_DEADLINE \"%s\", "
+				"ignored\n", val);
+	}
+
+	//admission control, timing dependent so not in deterministic mode
+	if(detOn())
+		;
+	else if((val = getenv("BAMNG_MAX_INFLIGHT")))
+		maxInflt = atoi(val) > 0 ? atoi(val) : 0;
+	if(!detOn() && (val = getenv("BAMNG_CODEL"))){
+		if(sscanf(val, "%lld:%lld", &ms[0], &ms[1]) == 2 && ms[0] > 0
+			&& ms[1] > 0){
+			cdlTgt = ms[0] * 1000;
+			cdlItv = ms[1] * 1000;
+		}
+		else
+			fprintf(stderr, "error (baMng): bad BAMNG_CODEL \"%s\", "
+				"ignored\n", val);
+	}
+
+	cmdBf = malloc(sizeof(LinkedList));
+	if(!cmdBf)
+		return -1;
+
+	pthread_mutex_init(&(cmdBf->lock), NULL);
+	for(i = 0; i < CLS_NUM; i++){
+		cmdBf->head[i] = NULL;
+		cmdBf->tail[i] = NULL;
+		cmdBf->clsSize[i] = 0;
+	}
+	cmdBf->size = 0;
+
+	//return successfully
+	return 0;
+}
+
+/**free cmd buffer and statistics
+ * @ret void
+ * @author elithz
+ * @modified 10.18.2026*/
+void queFree(){
+	//counter
+	int i;
+
+	for(i = 0; i < CLS_NUM; i++){
+		free(latSmp[i]);
+		latSmp[i] = NULL;
+		latNum[i] = latCap[i] = 0;
+	}
+	free(cmdBf);
+	cmdBf = NULL;
+	detFree();
+}
+
+/**pick the class whose head should be served next, cmdBf must be locked
+ * @param long long now: current time in usec
+ * @ret int: class to serve, -1 if the buffer is empty
+ * @author elithz
+ * @modified 10.18.2026*/
+static int quePick(long long now){
+	//counter
+	int c;
+	//best class so far
+	int best = -1;
+	//deadlines and arrivals of the candidates
+	long long dl, bestDl = 0, arv, bestArv = 0;
+
+	for(c = 0; c < CLS_NUM; c++){
+		if(!cmdBf->head[c])
+			continue;
+		dl = tvUsec(cmdBf->head[c]->deadline);
+		arv = tvUsec(cmdBf->head[c]->timestamp);
+
+		if(best < 0){
+			best = c;
+		}
+		//both overdue, oldest first so no class starves
+		else if(dl < now && bestDl < now){
+			if(arv < bestArv)
+				best = c;
+		}
+		//otherwise earliest deadline first, ties go to the lower class
+		else if(dl < bestDl){
+			best = c;
+		}
+
+		if(best == c){
+			bestDl = dl;
+			bestArv = arv;
+		}
+	}
+	return best;
+}
+
+/**CoDel decision for a cmd leaving the queue, cmdBf must be locked
+ * @param long long now: current time in usec
+ * @param long long sojourn: time the cmd spent queued in usec
+ * @ret int: 1 = shed the cmd, 0 = run it
+ * @author elithz
+ * @modified 10.18.2026*/
+static int cdlShed(long long now, long long sojourn){
+	//1 once the delay stayed above target for an interval
+	int okDrop = 0;
+
+	//delay fine or queue drained, leave the dropping state
+	if(sojourn < cdlTgt || cmdBf->size == 0){
+		cdlFirstAbove = 0;
+	}
+	else if(!cdlFirstAbove){
+		cdlFirstAbove = now + cdlItv;
+	}
+	else if(now >= cdlFirstAbove){
+		okDrop = 1;
+	}
+
+	if(cdlDropping){
+		if(!okDrop){
+			cdlDropping = 0;
+			return 0;
+		}
+		if(now >= cdlDropNext){
+			//drop faster the longer the queue stays bad
+			cdlCount++;
+			cdlDropNext += (long long) (cdlItv / sqrt(cdlCount));
+			return 1;
+		}
+		return 0;
+	}
+
+	if(okDrop){
+		cdlDropping = 1;
+		//resume near the previous drop rate if we only just left it
+		if(cdlCount > 2 && now - cdlDropNext < 16 * cdlItv)
+			cdlCount -= 2;
+		else
+			cdlCount = 1;
+		cdlDropNext = now + (long long) (cdlItv / sqrt(cdlCount));
+		return 1;
+	}
+	return 0;
+}
+
+/**get next element in linked list
+ * @ret LinkedCommand: next cmd to run, cmd field is NULL if no cmd
+ * exists
+ * @author elithz
+ * @modified 10.18.2026*/
+LinkedCommand nextCmd(){
+	//temporary pointer used to free head
+	LinkedCommand * temp_head;
+	//initialize return value
+	LinkedCommand ret;
+	//class to serve
+	int c;
+	//current time
+	struct timeval now;
+
+	ret.cmd = NULL;
+	gettimeofday(&now, NULL);
+
+	//lock cmd buffer
+	pthread_mutex_lock(&(cmdBf->lock));
+
+	//are there any commands to pull?
+	if(cmdBf->size > 0 && (c = quePick(tvUsec(now))) >= 0){
+		//hand the head over to the caller, it now owns cmd
+		temp_head = cmdBf->head[c];
+		ret = *temp_head;
+		ret.next = NULL;
+
+		//move head and free memory from linked list
+		cmdBf->head[c] = temp_head->next;
+		free(temp_head);
+
+		//if head ran past tail set tail back to null
+		if(!cmdBf->head[c])
+			cmdBf->tail[c] = NULL;
+
+		//update linked list size
+		cmdBf->clsSize[c]--;
+		cmdBf->size = cmdBf->size - 1;
+
+		//shed if the queue delay has been too high for too long
+		if(cdlTgt && c != CLS_URGENT && cdlShed(tvUsec(now),
+			tvUsec(now) - tvUsec(ret.timestamp))){
+			ret.shed = 1;
+			shedNum[c]++;
+		}
+	}
+
+	//unlock cmd buffer
+	pthread_mutex_unlock(&(cmdBf->lock));
+
+	if(trEnabled && ret.cmd)
+		trCmd(ret.id, ret.timestamp);
+
+	//return cmd
+	return ret;
+}
+
+/**add cmd onto linked list
+ * @param char * given_command: cmd line, may start with "PRI n"
+ * @param int id: id of the cmd
+ * @ret int: 0 = operation success, 1 = refused by admission control,
+ * -1 = operation failure
+ * @author elithz
+ * @modified 10.18.2026*/
+int addCmd(char * given_command, int id){
+	return addCmdAt(given_command, id, NULL);
+}
+
+/**add cmd that arrived at a given time onto linked list
+ * @param char * given_command: cmd line, may start with "PRI n"
+ * @param int id: id of the cmd
+ * @param struct timeval * arrive: arrival time, NULL = now
+ * @ret int: 0 = operation success, 1 = refused by admission control,
+ * -1 = operation failure
+ * @author elithz
+ * @modified 10.18.2026*/
+int addCmdAt(char * given_command, int id, struct timeval * arrive){
+	//initialize new LinkedCommand to add to list
+	LinkedCommand * new_tail = malloc(sizeof(LinkedCommand));
+	//explicit class and length of the PRI prefix
+	int cls, skip = 0;
+
+	if(!new_tail)
+		return -1;
+	TR_MARK(TR_ENQUEUE, id);
+
+	//pick the class
+	if(sscanf(given_command, "PRI %d %n", &cls, &skip) == 1 && skip > 0
+		&& cls >= 0 && cls < CLS_NUM)
+		given_command += skip;
+	else if(strncmp(given_command, "TRANS", 5) == 0
+		|| strncmp(given_command, "PREP", 4) == 0)
+		cls = CLS_TRANS;
+	else
+		cls = CLS_CHECK;
+
+	//copy the cmd, it may be any length
+	new_tail->cmd = strdup(given_command);
+	if(!new_tail->cmd){
+		free(new_tail);
+		return -1;
+	}
+
+	//refuse the cmd if too many are in flight already
+	if(maxInflt){
+		pthread_mutex_lock(&(cmdBf->lock));
+		if(inflt >= maxInflt){
+			refused[cls]++;
+			pthread_mutex_unlock(&(cmdBf->lock));
+			free(new_tail->cmd);
+			free(new_tail);
+			return 1;
+		}
+		inflt++;
+		pthread_mutex_unlock(&(cmdBf->lock));
+	}
+
+	//construct the cmd
+	new_tail->id = id;
+	new_tail->cls = cls;
+	new_tail->shed = 0;
+	if(arrive)
+		new_tail->timestamp = *arrive;
+	else
+		gettimeofday(&(new_tail->timestamp), NULL);
+	new_tail->deadline.tv_sec = new_tail->timestamp.tv_sec
+		+ (new_tail->timestamp.tv_usec + clsBdgt[cls]) / 1000000;
+	new_tail->deadline.tv_usec = (new_tail->timestamp.tv_usec
+		+ clsBdgt[cls]) % 1000000;
+	new_tail->det = NULL;
+	new_tail->next = NULL;
+
+	//in deterministic mode the cmd waits here for its locks
+	if(detAdmit(new_tail))
+		return 0;
+
+	quePush(new_tail);
+
+	//return successfully
+	return 0;
+}
+
+/**append a cmd to the list of its class and wake a worker
+ * @param LinkedCommand * new_tail: cmd to append
+ * @ret void
+ * @author elithz
+ * @modified 10.18.2026*/
+void quePush(LinkedCommand * new_tail){
+	//class of the cmd
+	int cls = new_tail->cls;
+
+	//lock command_buffer
+	pthread_mutex_lock(&(cmdBf->lock));
+
+	//is the class list currently empty
+	if(cmdBf->tail[cls]){
+		//have tail point to this new cmd
+		cmdBf->tail[cls]->next = new_tail;
+		cmdBf->tail[cls] = new_tail;
+	}
+	else{
+		//add first element and set head and tail to it
+		cmdBf->head[cls] = new_tail;
+		cmdBf->tail[cls] = new_tail;
+	}
+	cmdBf->clsSize[cls]++;
+	cmdBf->size = cmdBf->size + 1;
+
+	//wake one waiting worker
+	pthread_cond_signal(&queCv);
+
+	//unlock cmd buffer
+	pthread_mutex_unlock(&(cmdBf->lock));
+}
+
+/**record the latency of a finished cmd
+ * @param LinkedCommand * cmd: cmd whose result was just logged
+ * @ret void
+ * @author elithz
+ * @modified 10.18.2026*/
+void queStat(LinkedCommand * cmd){
+	//finish time
+	struct timeval now;
+	//latency and grown sample array
+	long long lat;
+	long long * grown;
+	//class of the cmd
+	int c = cmd->cls;
+
+	TR_MARK(TR_RESULT, cmd->id);
+	gettimeofday(&now, NULL);
+	lat = tvUsec(now) - tvUsec(cmd->timestamp);
+
+	pthread_mutex_lock(&statLk);
+	if(latNum[c] == latCap[c]){
+		latCap[c] = latCap[c] ? latCap[c] * 2 : 1024;
+		grown = realloc(latSmp[c], latCap[c] * sizeof(long long));
+		if(!grown){
+			latCap[c] = latNum[c];
+			pthread_mutex_unlock(&statLk);
+			return;
+		}
+		latSmp[c] = grown;
+	}
+	latSmp[c][latNum[c]++] = lat;
+	if(tvUsec(now) > tvUsec(cmd->deadline))
+		latMiss[c]++;
+	pthread_mutex_unlock(&statLk);
+}
+
+/**block until the buffer has cmds, queWake() is called or usec pass
+ * @param long usec: longest time to wait
+ * @ret void
+ * @author elithz
+ * @modified 10.18.2026*/
+void queWait(long usec){
+	//absolute wake up time
+	struct timeval now;
+	struct timespec until;
+
+	gettimeofday(&now, NULL);
+	until.tv_sec = now.tv_sec + (now.tv_usec + usec) / 1000000;
+	until.tv_nsec = ((now.tv_usec + usec) % 1000000) * 1000;
+
+	pthread_mutex_lock(&(cmdBf->lock));
+	if(cmdBf->size == 0)
+		pthread_cond_timedwait(&queCv, &(cmdBf->lock), &until);
+	pthread_mutex_unlock(&(cmdBf->lock));
+}
+
+/**wake every thread blocked in queWait
+ * @ret void
+ * @author elithz
+ * @modified 10.18.2026*/
+void queWake(){
+	pthread_mutex_lock(&(cmdBf->lock));
+	pthread_cond_broadcast(&queCv);
+	pthread_mutex_unlock(&(cmdBf->lock));
+}
+
+/**age of the oldest queued cmd
+ * @ret long long: age in usec, 0 if the buffer is empty
+ * @author elithz
+ * @modified 10.18.2026*/
+long long queDelay(){
+	//counter
+	int c;
+	//oldest arrival seen
+	long long oldest = 0, arv;
+	//current time
+	struct timeval now;
+
+	gettimeofday(&now, NULL);
+	pthread_mutex_lock(&(cmdBf->lock));
+	for(c = 0; c < CLS_NUM; c++){
+		if(!cmdBf->head[c])
+			continue;
+		arv = tvUsec(cmdBf->head[c]->timestamp);
+		if(!oldest || arv < oldest)
+			oldest = arv;
+	}
+	pthread_mutex_unlock(&(cmdBf->lock));
+
+	return oldest ? tvUsec(now) - oldest : 0;
+}
+
+/**tell the dispatcher a cmd is finished so it no longer counts in flight
+ * @param LinkedCommand * cmd: finished cmd
+ * @ret void
+ * @author elithz
+ * @modified 10.18.2026*/
+void cmdDone(LinkedCommand * cmd){
+	if(queDoneCnt)
+		__atomic_fetch_add(queDoneCnt, 1, __ATOMIC_RELAXED);
+	//let the cmds waiting for its locks go
+	detDone(cmd);
+	TR_END(TR_CMD, -1);
+	if(!maxInflt)
+		return;
+	pthread_mutex_lock(&(cmdBf->lock));
+	inflt--;
+	pthread_mutex_unlock(&(cmdBf->lock));
+}
+
+/**log a BUSY result for a refused or shed cmd
+ * @param FILE * out: result file
+ * @param int id: id of the cmd
+ * @param struct timeval arrive: arrival time of the cmd
+ * @ret void
+ * @author elithz
+ * @modified 10.18.2026*/
+void prtBusy(FILE * out, int id, struct timeval arrive){
+	//time of the answer
+	struct timeval now;
+
+	gettimeofday(&now, NULL);
+	flockfile(out);
+	fprintf(out, "%d BUSY TIME %ld.%06ld %ld.%06ld\n", id,
+		(long) arrive.tv_sec, (long) arrive.tv_usec, (long) now.tv_sec,
+		(long) now.tv_usec);
+	funlockfile(out);
+}
+
+/**compare two latencies for qsort
+ * @ret int: <0, 0, >0 as a is smaller, equal, larger than b
+ * @author elithz
+ * @modified 10.18.2026*/
+static int latCmp(const void * a, const void * b){
+	long long x = *(const long long *) a, y = *(const long long *) b;
+	return (x > y) - (x < y);
+}
+
+/**print per class latency percentiles in ms
+ * @param FILE * out: where to print
+ * @ret void
+ * @author elithz
+ * @modified 10.18.2026*/
+void quePrtStat(FILE * out){
+	//counter
+	int c;
+	//sample count
+	int n;
+	//sorted samples
+	long long * s;
+
+	pthread_mutex_lock(&statLk);
+	fprintf(out, "class\tcount\tmissed\tp50ms\tp95ms\tp99ms\tmaxms\n");
+	for(c = 0; c < CLS_NUM; c++){
+		n = latNum[c];
+		if(!n)
+			continue;
+		s = latSmp[c];
+		qsort(s, n, sizeof(long long), latCmp);
+		fprintf(out, "%s\t%d\t%d\t%.3f\t%.3f\t%.3f\t%.3f\n", clsName[c], n,
+			latMiss[c], s[(n - 1) * 50 / 100] / 1000.0,
+			s[(n - 1) * 95 / 100] / 1000.0, s[(n - 1) * 99 / 100] / 1000.0,
+			s[n - 1] / 1000.0);
+	}
+	pthread_mutex_unlock(&statLk);
+
+	//load shedding summary
+	if(maxInflt || cdlTgt){
+		fprintf(out, "class\trefused\tshed\n");
+		for(c = 0; c < CLS_NUM; c++)
+			fprintf(out, "%s\t%d\t%d\n", clsName[c], refused[c], shedNum[c]);
+	}
+	detPrtStat(out);
+}
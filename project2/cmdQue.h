@@ -0,0 +1,76 @@
+/**
+*		Filename:  cmdQue.h
+*    Description:  Deadline aware cmd dispatcher shared by the bank servers
+*        Version:  1.0
+*        Created:  10.18.2026 10h02min11s
+*         Author:  Ningyuan Zhang （狮子劫博丽）(elithz), elithz@iastate.edu
+*        Company:  NERVE Software
+*/
+
+/*
+ *  Every cmd gets a priority class when it is added: TRANS goes to
+ *  CLS_TRANS, everything else to CLS_CHECK, and a leading "PRI n"
+ *  token picks class n explicitly (e.g. "PRI 0 TRANS 1 -5 2 5").
+ *  The deadline of a cmd is its arrival time plus the budget of its
+ *  class, set in ms through BAMNG_DEADLINE (default "10,100,1000").
+ *
+ *  nextCmd() serves the head with the earliest deadline (EDF). Once
+ *  several heads are past their deadline they are served in arrival
+ *  order, so an overloaded class can not starve the others forever.
+ *
+ *  Admission control keeps tail latency bounded under overload:
+ *    BAMNG_MAX_INFLIGHT  max cmds queued or running, addCmd() refuses
+ *                        the rest (default 0 = unlimited)
+ *    BAMNG_CODEL         target:interval in ms, once the queue delay
+ *                        stays above target for a whole interval cmds
+ *                        are shed at dequeue at the CoDel rate
+ *                        (default off)
+ *  Refused and shed cmds are answered with a BUSY line, URGENT cmds
+ *  are never shed by CoDel.
+ */
+
+#ifndef CMDQUE
+#define CMDQUE
+
+#include "baMng.h"
+
+//set up cmdBf, ret 0 = success, -1 = failure
+int queInit();
+
+//free cmdBf
+void queFree();
+
+//add a cmd that arrived at *arrive (NULL = now), same results as addCmd()
+int addCmdAt(char * given_command, int id, struct timeval * arrive);
+
+//append a cmd to its class list, for cmds held back by detSch.c
+void quePush(LinkedCommand * cmd);
+
+//when set, cmdDone() counts finished cmds here
+extern int * queDoneCnt;
+
+//record the latency of a finished cmd in its class statistics
+void queStat(LinkedCommand * cmd);
+
+//block up to usec until the buffer has cmds or queWake() is called
+void queWait(long usec);
+
+//wake every thread blocked in queWait()
+void queWake();
+
+//age in usec of the oldest queued cmd, 0 if the buffer is empty
+long long queDelay();
+
+//tell the dispatcher a cmd taken with nextCmd() is finished
+void cmdDone(LinkedCommand * cmd);
+
+//log a BUSY result for a refused or shed cmd
+void prtBusy(FILE * out, int id, struct timeval arrive);
+
+//print per class latency percentiles
+void quePrtStat(FILE * out);
+
+//microseconds since the epoch of a timeval
+long long tvUsec(struct timeval tv);
+
+#endif
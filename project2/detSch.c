@@ -0,0 +1,277 @@
+/**
+*		Filename:  detSch.c
+*    Description:  Deterministic cmd scheduling in id order
+*        Version:  1.0
+*        Created:  10.18.2026 19h02min15s
+*         Author:  Ningyuan Zhang （狮子劫博丽）(elithz), elithz@iastate.edu
+*        Company:  NERVE Software
+*/
+
+#include "detSch.h"
+#include "cmdQue.h"
+
+//slot of the whole bank, accounts use their ID
+#define DET_BANK 0
+
+//a lock request of a cmd on one account
+typedef struct detReq_struct{
+	struct detCmd_struct * owner;
+	int slot;
+	int wr;
+	int granted;
+	struct detReq_struct * prev;
+	struct detReq_struct * next;
+}detReq;
+
+//lock set of a cmd
+typedef struct detCmd_struct{
+	LinkedCommand * cmd;
+	//requests not granted yet
+	int waits;
+	int n;
+	detReq req[];
+}detCmd;
+
+//FIFO of requests on one account
+typedef struct detQue_struct{
+	detReq * head;
+	detReq * tail;
+}detQue;
+
+//mode flag and request FIFOs, slot DET_BANK and accounts 1..detNum
+static int detMode = 0;
+static int detNum = 0;
+static detQue * detQs = NULL;
+//guards every FIFO
+static pthread_mutex_t detLk = PTHREAD_MUTEX_INITIALIZER;
+//statistics
+static long long admitted = 0;
+static long long held = 0;
+static int heldNow = 0;
+static int heldMax = 0;
+
+/**read BAMNG_DETERMINISTIC and set up the request FIFOs
+ * @param int accountNum: number of accounts
+ * @ret int: 0 = operation success, -1 = failure
+ * @author elithz
+ * @modified 10.18.2026*/
+int detInit(int accountNum){
+	//environment value
+	char * val = getenv("BAMNG_DETERMINISTIC");
+
+	if(!val || atoi(val) <= 0)
+		return 0;
+	detQs = calloc(accountNum + 1, sizeof(detQue));
+	if(!detQs)
+		return -1;
+	detNum = accountNum;
+	detMode = 1;
+	return 0;
+}
+
+/**is deterministic mode on
+ * @ret int: 1 = on, 0 = off
+ * @author elithz
+ * @modified 10.18.2026*/
+int detOn(){
+	return detMode;
+}
+
+/**compare two requests by slot for qsort
+ * @ret int: <0, 0, >0 as a is before, same as, after b
+ * @author elithz
+ * @modified 10.18.2026*/
+static int reqCmp(const void * a, const void * b){
+	return ((const detReq *) a)->slot - ((const detReq *) b)->slot;
+}
+
+/**grant a request, detLk must be held
+ * @param detReq * r: request
+ * @ret void
+ * @author elithz
+ * @modified 10.18.2026*/
+static void detGrant(detReq * r){
+	r->granted = 1;
+	if(--r->owner->waits == 0){
+		heldNow--;
+		quePush(r->owner->cmd);
+	}
+}
+
+/**queue the lock requests of a new cmd
+ * @param LinkedCommand * cmd: cmd, not in any queue yet
+ * @ret int: 1 = held until granted, 0 = may run now
+ * @author elithz
+ * @modified 10.18.2026*/
+int detAdmit(LinkedCommand * cmd){
+	//counters
+	int i;
+	//tokens of a copy of the cmd, a line of n chars has at most n / 2 + 1
+	char * line, ** tok, * save, * cur;
+	int tokNum = 0;
+	//requests made, first account token and token step
+	int n = 0, wr = 0, bankWr = 0, first = 1, step = 1, a;
+	//cmd has to wait
+	int wait;
+	detCmd * dc = NULL;
+	detQue * q;
+	detReq * r;
+
+	if(!detMode)
+		return 0;
+	line = strdup(cmd->cmd);
+	tok = malloc((strlen(cmd->cmd) / 2 + 1) * sizeof(char *));
+	if(!line || !tok)
+		goto out;
+	for(cur = strtok_r(line, " ", &save); cur; cur = strtok_r(NULL, " ", &save))
+		tok[tokNum++] = cur;
+	if(!tokNum)
+		goto out;
+
+	//lock set from the cmd type
+	if(strcmp(tok[0], "TRANS") == 0){
+		wr = 1;
+		step = 2;
+	}
+	else if(strcmp(tok[0], "PREP") == 0){
+		wr = 1;
+		first = 2;
+		step = 2;
+	}
+	else if(strcmp(tok[0], "SUM") == 0 || strcmp(tok[0], "AGG") == 0){
+		bankWr = 1;
+		first = tokNum;
+	}
+	else if(strcmp(tok[0], "CHECK"))
+		goto out;
+
+	//every cmd reads the bank slot, bank wide cmds write it
+	dc = malloc(sizeof(detCmd) + (tokNum + 1) * sizeof(detReq));
+	if(!dc)
+		goto out;
+	dc->req[n++].slot = DET_BANK;
+	for(i = first; i < tokNum; i += step){
+		a = atoi(tok[i]);
+		if(a >= 1 && a <= detNum)
+			dc->req[n++].slot = a;
+	}
+	//sorted, an account named twice is requested once
+	qsort(dc->req, n, sizeof(detReq), reqCmp);
+	for(i = 1, a = 1; i < n; i++)
+		if(dc->req[i].slot != dc->req[a - 1].slot)
+			dc->req[a++].slot = dc->req[i].slot;
+	n = a;
+	dc->cmd = cmd;
+	dc->n = n;
+	for(i = 0; i < n; i++){
+		dc->req[i].owner = dc;
+		dc->req[i].wr = dc->req[i].slot == DET_BANK ? bankWr : wr;
+		dc->req[i].granted = 0;
+	}
+	cmd->det = dc;
+
+out:
+	free(line);
+	free(tok);
+	if(!dc)
+		return 0;
+
+	pthread_mutex_lock(&detLk);
+	admitted++;
+	dc->waits = n;
+	for(i = 0; i < n; i++){
+		r = &dc->req[i];
+		q = &detQs[r->slot];
+		r->prev = q->tail;
+		r->next = NULL;
+		//free, or a read behind granted reads only
+		if(!q->tail || (!r->wr && !q->tail->wr && q->tail->granted)){
+			r->granted = 1;
+			dc->waits--;
+		}
+		if(q->tail)
+			q->tail->next = r;
+		else
+			q->head = r;
+		q->tail = r;
+	}
+	//dc may be granted, run and freed as soon as detLk is released
+	wait = dc->waits > 0;
+	if(wait){
+		held++;
+		if(++heldNow > heldMax)
+			heldMax = heldNow;
+	}
+	pthread_mutex_unlock(&detLk);
+	return wait;
+}
+
+/**release the locks of a finished cmd
+ * @param LinkedCommand * cmd: finished cmd
+ * @ret void
+ * @author elithz
+ * @modified 10.18.2026*/
+void detDone(LinkedCommand * cmd){
+	//counter
+	int i;
+	//lock set
+	detCmd * dc = cmd->det;
+	detQue * q;
+	detReq * r;
+	//nothing granted yet ahead of r
+	int first;
+
+	if(!dc)
+		return;
+	pthread_mutex_lock(&detLk);
+	for(i = 0; i < dc->n; i++){
+		r = &dc->req[i];
+		q = &detQs[r->slot];
+		if(r->prev)
+			r->prev->next = r->next;
+		else
+			q->head = r->next;
+		if(r->next)
+			r->next->prev = r->prev;
+		else
+			q->tail = r->prev;
+
+		//grant the write now first in line or the reads up to a write
+		for(r = q->head, first = 1; r; r = r->next, first = 0){
+			if(r->wr){
+				if(!r->granted && first)
+					detGrant(r);
+				break;
+			}
+			if(!r->granted)
+				detGrant(r);
+		}
+	}
+	pthread_mutex_unlock(&detLk);
+	free(dc);
+	cmd->det = NULL;
+}
+
+/**free the request queues
+ * @ret void
+ * @author elithz
+ * @modified 10.18.2026*/
+void detFree(){
+	free(detQs);
+	detQs = NULL;
+	detNum = 0;
+}
+
+/**print how many cmds had to wait for their locks
+ * @param FILE * out: where to print
+ * @ret void
+ * @author elithz
+ * @modified 10.18.2026*/
+void detPrtStat(FILE * out){
+	if(!detMode)
+		return;
+	pthread_mutex_lock(&detLk);
+	fprintf(out, "deterministic: %lld cmds, %lld waited for locks, at most %d "
+		"held at once\n", admitted, held, heldMax);
+	pthread_mutex_unlock(&detLk);
+}
@@ -0,0 +1,52 @@
+/**
+*		Filename:  detSch.h
+*    Description:  Deterministic cmd scheduling in id order
+*        Version:  1.0
+*        Created:  10.18.2026 19h02min15s
+*         Author:  Ningyuan Zhang （狮子劫博丽）(elithz), elithz@iastate.edu
+*        Company:  NERVE Software
+*/
+
+/*
+ *  With BAMNG_DETERMINISTIC=1 every cmd declares its lock set when it
+ *  is added, in id order, before any worker sees it (as in Calvin):
+ *    TRANS, PREP          write every account named
+ *    CHECK                read every account named
+ *    SUM, AGG             write the whole bank
+ *  Every account keeps a FIFO of requests. A cmd is handed to the
+ *  workers once it is granted all of them: a write when it is first in
+ *  line, a read when only reads are before it. Conflicting cmds thus
+ *  run in id order and the others in parallel, so the same input gives
+ *  the same balances, ISFs and snapshot answers on every run (and a
+ *  follower replaying the input would need no log at all).
+ *
+ *  Admission control and CoDel shedding depend on timing and are off
+ *  in this mode. The order holds within one process, not across
+ *  BAMNG_PROCS worker processes.
+ */
+
+#ifndef DETSCH
+#define DETSCH
+
+#include "baMng.h"
+
+//read BAMNG_DETERMINISTIC, accountNum accounts, ret 0 = success, -1 = failure
+int detInit(int accountNum);
+
+//1 = deterministic mode is on
+int detOn();
+
+//queue the lock requests of a new cmd, in id order
+//ret 1 = cmd is held until granted, 0 = cmd may run now
+int detAdmit(LinkedCommand * cmd);
+
+//release the locks of a finished cmd and hand over the cmds now granted
+void detDone(LinkedCommand * cmd);
+
+//free the request queues
+void detFree();
+
+//print how many cmds had to wait for their locks
+void detPrtStat(FILE * out);
+
+#endif
@@ -0,0 +1,245 @@
+/**
+*		Filename:  fiber.c
+*    Description:  User space fibers so one worker thread drives many cmds
+*        Version:  1.0
+*        Created:  10.18.2026 12h40min33s
+*         Author:  Ningyuan Zhang （狮子劫博丽）(elithz), elithz@iastate.edu
+*        Company:  NERVE Software
+*/
+
+#include "fiber.h"
+#include "latMdl.h"
+#include <ucontext.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <errno.h>
+
+//stack of every fiber
+#define FBR_STACK (128 * 1024)
+//first and longest back off of a fiber waiting for a lock in usec
+#define FBR_BACKOFF 50
+#define FBR_BACKOFF_MAX 2000
+
+//fiber states
+#define FBR_READY 0
+#define FBR_SLEEP 1
+#define FBR_DONE 2
+
+//one fiber
+typedef struct fiber_struct{
+	ucontext_t ctx;
+	char * stack;
+	int state;
+	long long wake;
+}fiber;
+
+//fibers of this thread, the one running and the scheduler context
+static __thread fiber * fbrs = NULL;
+static __thread int fbrCur = -1;
+static __thread ucontext_t fbrSch;
+static __thread void * (*fbrFn)();
+
+/**current time in usec
+ * @ret long long: time since the epoch
+ * @author elithz
+ * @modified 10.18.2026*/
+static long long fbrNow(){
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return (long long) tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+/**fibers per worker thread asked for in the environment
+ * @ret int: BAMNG_FIBERS, 0 = fibers off
+ * @author elithz
+ * @modified 10.18.2026*/
+int fbrNum(){
+	//environment value
+	char * val = getenv("BAMNG_FIBERS");
+	return val && atoi(val) > 0 ? atoi(val) : 0;
+}
+
+/**1 if the caller is a fiber
+ * @ret int: 1 = fiber, 0 = plain thread
+ * @author elithz
+ * @modified 10.18.2026*/
+int fbrActive(){
+	return fbrCur >= 0;
+}
+
+/**index of the calling fiber on its thread
+ * @ret int: fiber index, -1 = plain thread
+ * @author elithz
+ * @modified 10.18.2026*/
+int fbrIdx(){
+	return fbrCur;
+}
+
+/**entry of every fiber, runs the handler and marks the fiber done
+ * @ret void
+ * @author elithz
+ * @modified 10.18.2026*/
+static void fbrEntry(){
+	fbrFn();
+	fbrs[fbrCur].state = FBR_DONE;
+	//uc_link takes us back to the scheduler
+}
+
+/**let the other fibers of this thread run
+ * @ret void
+ * @author elithz
+ * @modified 10.18.2026*/
+void fbrYield(){
+	//index of the calling fiber
+	int me = fbrCur;
+
+	if(me < 0)
+		return;
+	swapcontext(&fbrs[me].ctx, &fbrSch);
+}
+
+/**sleep usec, yields to the other fibers when called from a fiber
+ * @param long usec: time to sleep
+ * @ret void
+ * @author elithz
+ * @modified 10.18.2026*/
+void fbrSleep(long usec){
+	if(fbrCur < 0){
+		while(usec >= 1000000){
+			sleep(1);
+			usec -= 1000000;
+		}
+		if(usec > 0)
+			usleep(usec);
+		return;
+	}
+	fbrs[fbrCur].state = FBR_SLEEP;
+	fbrs[fbrCur].wake = fbrNow() + usec;
+	fbrYield();
+}
+
+/**lock a mutex without blocking the other fibers of this thread
+ * @param pthread_mutex_t * lk: mutex to lock
+ * @ret void
+ * @author elithz
+ * @modified 10.18.2026*/
+void fbrLock(pthread_mutex_t * lk){
+	//time to sleep before the next attempt
+	long backoff = FBR_BACKOFF;
+	//result of the lock attempt
+	int rc;
+
+	if(fbrCur < 0){
+		//a shared account lock may come from a worker process that died
+		if(pthread_mutex_lock(lk) == EOWNERDEAD)
+			pthread_mutex_consistent(lk);
+		return;
+	}
+	while((rc = pthread_mutex_trylock(lk))){
+		if(rc == EOWNERDEAD){
+			pthread_mutex_consistent(lk);
+			return;
+		}
+		//holder is probably in a backend call, back off exponentially
+		//instead of burning the cpu
+		fbrSleep(backoff);
+		if(backoff < FBR_BACKOFF_MAX)
+			backoff *= 2;
+	}
+}
+
+/**yield hook for latMdl's throttle
+ * @ret int: 1 = yielded, 0 = caller is not a fiber
+ * @author elithz
+ * @modified 10.18.2026*/
+static int fbrLatYield(){
+	if(fbrCur < 0)
+		return 0;
+	fbrSleep(FBR_BACKOFF);
+	return 1;
+}
+
+/**run n fibers of fn on the calling thread until all of them return
+ * @param int n: number of fibers
+ * @param void * (*fn)(): body of every fiber
+ * @ret int: 0 = operation success, -1 = failure
+ * @author elithz
+ * @modified 10.18.2026*/
+int fbrRun(int n, void * (*fn)()){
+	//counter
+	int i;
+	//fibers not done yet, fibers run this pass
+	int live = n, ran;
+	//current time and earliest wake up
+	long long now, next;
+
+	fbrs = calloc(n, sizeof(fiber));
+	if(!fbrs)
+		return -1;
+	fbrFn = fn;
+
+	//backend delays and throttling must yield instead of blocking
+	latSleep = fbrSleep;
+	latYield = fbrLatYield;
+
+	for(i = 0; i < n; i++){
+		fbrs[i].stack = malloc(FBR_STACK);
+		if(!fbrs[i].stack || getcontext(&fbrs[i].ctx)){
+			//run with the fibers we managed to make
+			live = n = i;
+			break;
+		}
+		fbrs[i].ctx.uc_stack.ss_sp = fbrs[i].stack;
+		fbrs[i].ctx.uc_stack.ss_size = FBR_STACK;
+		fbrs[i].ctx.uc_link = &fbrSch;
+		fbrs[i].state = FBR_READY;
+		makecontext(&fbrs[i].ctx, fbrEntry, 0);
+	}
+	if(!n){
+		free(fbrs);
+		fbrs = NULL;
+		return -1;
+	}
+
+	//round robin over the fibers until every one has returned
+	while(live > 0){
+		ran = 0;
+		next = 0;
+		now = fbrNow();
+		for(i = 0; i < n; i++){
+			if(fbrs[i].state == FBR_DONE)
+				continue;
+			if(fbrs[i].state == FBR_SLEEP){
+				if(fbrs[i].wake > now){
+					if(!next || fbrs[i].wake < next)
+						next = fbrs[i].wake;
+					continue;
+				}
+				fbrs[i].state = FBR_READY;
+			}
+
+			fbrCur = i;
+			swapcontext(&fbrSch, &fbrs[i].ctx);
+			fbrCur = -1;
+			ran++;
+
+			if(fbrs[i].state == FBR_DONE)
+				live--;
+		}
+
+		//everybody sleeps, so can the thread
+		if(!ran && next){
+			now = fbrNow();
+			if(next > now)
+				usleep(next - now);
+		}
+	}
+
+	for(i = 0; i < n; i++)
+		free(fbrs[i].stack);
+	free(fbrs);
+	fbrs = NULL;
+	return 0;
+}
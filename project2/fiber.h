@@ -0,0 +1,47 @@
+/**
+*		Filename:  fiber.h
+*    Description:  User space fibers so one worker thread drives many cmds
+*        Version:  1.0
+*        Created:  10.18.2026 12h40min33s
+*         Author:  Ningyuan Zhang （狮子劫博丽）(elithz), elithz@iastate.edu
+*        Company:  NERVE Software
+*/
+
+/*
+ *  With BAMNG_FIBERS=n every worker thread runs n fibers, each one a
+ *  full request handler. A fiber gives the thread away whenever it
+ *  would block: while the Bank backend delays it (latSleep is routed
+ *  through fbrSleep) and while an account lock is held elsewhere
+ *  (fbrLock spins on trylock and yields). Fibers never move between
+ *  threads, so a mutex is always unlocked by the thread that locked it.
+ */
+
+#ifndef FIBER
+#define FIBER
+
+#include <pthread.h>
+
+//fibers per worker thread asked for in the environment, 0 = off
+int fbrNum();
+
+//run n fibers of fn on the calling thread until all of them return
+//ret 0 = success, -1 = failure
+int fbrRun(int n, void * (*fn)());
+
+//1 if the caller is a fiber
+int fbrActive();
+
+//index of the calling fiber on its thread, -1 = plain thread
+int fbrIdx();
+
+//let the other fibers of this thread run
+void fbrYield();
+
+//sleep usec, yields when called from a fiber
+void fbrSleep(long usec);
+
+//lock a mutex without blocking the other fibers of this thread, recovers
+//a robust mutex left locked by a process that died
+void fbrLock(pthread_mutex_t * lk);
+
+#endif
@@ -0,0 +1,287 @@
+/**
+*		Filename:  latMdl.c
+*    Description:  Simulated storage latency model for the Bank backend
+*        Version:  1.0
+*        Created:  10.18.2026 09h12min40s
+*         Author:  Ningyuan Zhang （狮子劫博丽）(elithz), elithz@iastate.edu
+*        Company:  NERVE Software
+*/
+
+#include "latMdl.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <math.h>
+
+//delay of the original backend, 100ms on every call
+#define LAT_DEFAULT_USEC 100000
+
+//sleep through usleep unless an executor says otherwise
+static void latUsleep(long usec);
+void (*latSleep)(long usec) = latUsleep;
+//no yielding unless an executor installs a hook
+int (*latYield)() = NULL;
+
+//model for each operation
+static latSpec specs[LAT_OPS];
+//tail spike probability and size
+static double spkProb = 0;
+static long spkUsec = 0;
+//throttle, max concurrent requests per operation (0 = unlimited)
+static int thMax[LAT_OPS];
+static int thCur[LAT_OPS];
+static pthread_mutex_t thLk = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t thCv[LAT_OPS] = {PTHREAD_COND_INITIALIZER,
+	PTHREAD_COND_INITIALIZER};
+//base seed and counter to give every thread its own stream
+static unsigned int baseSeed = 308;
+static unsigned int seedCnt = 0;
+//1 once the environment has been read
+static int latReady = 0;
+static pthread_once_t latOnce = PTHREAD_ONCE_INIT;
+//status of the last latInit
+static int latStat = 0;
+
+//per thread random state
+static __thread unsigned int rndSeed;
+static __thread int rndReady = 0;
+
+/**sleep for usec microseconds
+ * @param long usec: time to sleep
+ * @ret void
+ * @author elithz
+ * @modified 10.18.2026*/
+static void latUsleep(long usec){
+	//usleep does not like arguments of a second or more
+	while(usec >= 1000000){
+		sleep(1);
+		usec -= 1000000;
+	}
+	if(usec > 0)
+		usleep(usec);
+}
+
+/**parse one model description such as "normal:100000:20000"
+ * @param const char * str: description to parse
+ * @param latSpec * out: parsed model
+ * @ret int: 0 = operation success, -1 = malformed description
+ * @author elithz
+ * @modified 10.18.2026*/
+static int latParse(const char * str, latSpec * out){
+	//numbers following the model name
+	double a = 0, b = 0;
+
+	if(strcmp(str, "none") == 0){
+		out->kind = LAT_NONE;
+		out->a = out->b = 0;
+		return 0;
+	}
+	if(sscanf(str, "fixed:%lf", &a) == 1 && a >= 0){
+		out->kind = LAT_FIXED;
+		out->a = a;
+		out->b = 0;
+		return 0;
+	}
+	if(sscanf(str, "normal:%lf:%lf", &a, &b) == 2 && a >= 0 && b >= 0){
+		out->kind = LAT_NORMAL;
+		out->a = a;
+		out->b = b;
+		return 0;
+	}
+	if(sscanf(str, "lognormal:%lf:%lf", &a, &b) == 2 && a > 0 && b >= 0){
+		out->kind = LAT_LOGNORMAL;
+		//store mu of the underlying normal so draws are cheap
+		out->a = log(a);
+		out->b = b;
+		return 0;
+	}
+	return -1;
+}
+
+/**read one model variable from the environment
+ * @param const char * name: environment variable to read
+ * @param latSpec * out: model to overwrite if the variable is set
+ * @ret int: 0 = operation success, -1 = malformed description
+ * @author elithz
+ * @modified 10.18.2026*/
+static int latEnv(const char * name, latSpec * out){
+	//value of the variable
+	char * val = getenv(name);
+
+	if(!val)
+		return 0;
+	if(latParse(val, out)){
+		fprintf(stderr, "error (latMdl): bad %s \"%s\", ignored\n", name, val);
+		return -1;
+	}
+	return 0;
+}
+
+/**read the whole configuration, run once
+ * @ret void
+ * @author elithz
+ * @modified 10.18.2026*/
+static void latLoad(){
+	//environment values and where parsing one stopped
+	char * val;
+	int end;
+	//default model
+	latSpec dft = {LAT_FIXED, LAT_DEFAULT_USEC, 0};
+
+	latStat = latEnv("BANK_LAT", &dft);
+	specs[LAT_READ] = dft;
+	specs[LAT_WRITE] = dft;
+	latStat |= latEnv("BANK_LAT_READ", &specs[LAT_READ]);
+	latStat |= latEnv("BANK_LAT_WRITE", &specs[LAT_WRITE]);
+
+	if((val = getenv("BANK_LAT_SPIKE"))){
+		if(sscanf(val, "%lf:%ld", &spkProb, &spkUsec) != 2 || spkProb < 0
+			|| spkProb > 1 || spkUsec < 0){
+			fprintf(stderr, "error (latMdl): bad BANK_LAT_SPIKE \"%s\", "
+				"ignored\n", val);
+			spkProb = 0;
+			spkUsec = 0;
+			latStat = -1;
+		}
+	}
+
+	if((val = getenv("BANK_LAT_THROTTLE"))){
+		//one value limits both operations, -1 = not a number
+		end = 0;
+		if(sscanf(val, "%d:%d%n", &thMax[LAT_READ], &thMax[LAT_WRITE], &end)
+			!= 2 || val[end]){
+			end = 0;
+			if(sscanf(val, "%d%n", &thMax[LAT_READ], &end) == 1 && !val[end])
+				thMax[LAT_WRITE] = thMax[LAT_READ];
+			else
+				thMax[LAT_READ] = thMax[LAT_WRITE] = -1;
+		}
+		if(thMax[LAT_READ] < 0 || thMax[LAT_WRITE] < 0){
+			fprintf(stderr, "error (latMdl): bad BANK_LAT_THROTTLE \"%s\", "
+				"ignored\n", val);
+			thMax[LAT_READ] = thMax[LAT_WRITE] = 0;
+			latStat = -1;
+		}
+	}
+
+	if((val = getenv("BANK_LAT_SEED")))
+		baseSeed = (unsigned int) strtoul(val, NULL, 0);
+
+	latReady = 1;
+}
+
+/**read configuration from the environment
+ * @ret int: 0 = operation success, -1 = malformed configuration
+ * @author elithz
+ * @modified 10.18.2026*/
+int latInit(){
+	pthread_once(&latOnce, latLoad);
+	return latStat;
+}
+
+/**uniform random number in (0, 1) from the calling thread's stream
+ * @ret double: random number
+ * @author elithz
+ * @modified 10.18.2026*/
+static double latUni(){
+	//give every thread a different seed on first use
+	if(!rndReady){
+		rndSeed = baseSeed + 7919 * __sync_fetch_and_add(&seedCnt, 1);
+		rndReady = 1;
+	}
+	return (rand_r(&rndSeed) + 1.0) / (RAND_MAX + 2.0);
+}
+
+/**standard normal random number (Box-Muller)
+ * @ret double: random number
+ * @author elithz
+ * @modified 10.18.2026*/
+static double latGauss(){
+	return sqrt(-2.0 * log(latUni())) * cos(2.0 * M_PI * latUni());
+}
+
+/**draw one delay for an operation
+ * @param int op: LAT_READ or LAT_WRITE
+ * @ret long: delay in usec
+ * @author elithz
+ * @modified 10.18.2026*/
+long latDraw(int op){
+	//model of this operation
+	latSpec * spc;
+	//drawn delay
+	double usec = 0;
+
+	if(!latReady)
+		latInit();
+	spc = &specs[op];
+
+	switch(spc->kind){
+		case LAT_FIXED:
+			usec = spc->a;
+			break;
+		case LAT_NORMAL:
+			usec = spc->a + spc->b * latGauss();
+			break;
+		case LAT_LOGNORMAL:
+			usec = exp(spc->a + spc->b * latGauss());
+			break;
+		default:
+			usec = 0;
+	}
+	if(usec < 0)
+		usec = 0;
+
+	//add a tail spike once in a while
+	if(spkProb > 0 && latUni() < spkProb)
+		usec += spkUsec;
+
+	return (long) usec;
+}
+
+/**delay the calling thread as the model says
+ * @param int op: LAT_READ or LAT_WRITE
+ * @ret void
+ * @author elithz
+ * @modified 10.18.2026*/
+void latWait(int op){
+	//delay to apply
+	long usec = latDraw(op);
+	//1 if the yield hook gave the thread away
+	int yielded;
+
+	//without throttling just sleep
+	if(!thMax[op]){
+		if(usec)
+			latSleep(usec);
+		return;
+	}
+
+	//wait for a free slot of this operation
+	pthread_mutex_lock(&thLk);
+	while(thCur[op] >= thMax[op]){
+		//let a fiber executor run something else meanwhile
+		if(latYield){
+			pthread_mutex_unlock(&thLk);
+			yielded = latYield();
+			pthread_mutex_lock(&thLk);
+			if(yielded)
+				continue;
+			if(thCur[op] < thMax[op])
+				break;
+		}
+		pthread_cond_wait(&thCv[op], &thLk);
+	}
+	thCur[op]++;
+	pthread_mutex_unlock(&thLk);
+
+	if(usec)
+		latSleep(usec);
+
+	//give the slot back
+	pthread_mutex_lock(&thLk);
+	thCur[op]--;
+	pthread_cond_signal(&thCv[op]);
+	pthread_mutex_unlock(&thLk);
+}
@@ -0,0 +1,66 @@
+/**
+*		Filename:  latMdl.h
+*    Description:  Simulated storage latency model for the Bank backend
+*        Version:  1.0
+*        Created:  10.18.2026 09h12min40s
+*         Author:  Ningyuan Zhang （狮子劫博丽）(elithz), elithz@iastate.edu
+*        Company:  NERVE Software
+*/
+
+/*
+ *  The model is configured from the environment the first time
+ *  latInit() is called (initialize_accounts() does this):
+ *
+ *    BANK_LAT          model for both reads and writes (default fixed:100000)
+ *    BANK_LAT_READ     model for read_account() only, overrides BANK_LAT
+ *    BANK_LAT_WRITE    model for write_account() only, overrides BANK_LAT
+ *    BANK_LAT_SPIKE    prob:usec, add a tail spike of usec with probability prob
+ *    BANK_LAT_THROTTLE n or reads:writes, max concurrent requests per operation
+ *    BANK_LAT_SEED     seed of the per thread random generators
+ *
+ *  model is one of
+ *    none                  no delay at all
+ *    fixed:usec            constant delay
+ *    normal:mean:sd        normal distribution in usec, clamped at 0
+ *    lognormal:median:sig  lognormal distribution, median in usec
+ */
+
+#ifndef LATMDL
+#define LATMDL
+
+//operations the backend can be asked to perform
+#define LAT_READ 0
+#define LAT_WRITE 1
+#define LAT_OPS 2
+
+//latency distributions
+#define LAT_NONE 0
+#define LAT_FIXED 1
+#define LAT_NORMAL 2
+#define LAT_LOGNORMAL 3
+
+//delay description for one operation
+typedef struct latSpec_struct{
+	int kind;
+	double a;
+	double b;
+}latSpec;
+
+//read configuration from the environment, safe to call more than once
+//ret 0 = success, -1 = malformed configuration (defaults are used)
+int latInit();
+
+//delay the calling thread as the model says for operation op
+void latWait(int op);
+
+//draw one delay in usec for operation op without sleeping
+long latDraw(int op);
+
+//function used to sleep, replaced by executors that must not block
+extern void (*latSleep)(long usec);
+
+//called instead of blocking on a throttle slot when set,
+//ret 1 = caller yielded and will retry, 0 = caller may block
+extern int (*latYield)();
+
+#endif
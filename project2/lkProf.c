@@ -0,0 +1,249 @@
+/**
+*		Filename:  lkProf.c
+*    Description:  Contention profile of the account locks
+*        Version:  1.0
+*        Created:  10.18.2026 20h51min37s
+*         Author:  Ningyuan Zhang （狮子劫博丽）(elithz), elithz@iastate.edu
+*        Company:  NERVE Software
+*/
+
+#include "lkProf.h"
+#include <errno.h>
+#include <stdlib.h>
+#include <sys/time.h>
+
+//sketch counters per account reported
+#define LP_SPARE 4
+
+//one counter of the space-saving sketch
+typedef struct lpSlot_struct{
+	int acct;
+	//contended acquisitions and wait in usec, err = wait inherited from
+	//the account this counter replaced
+	long long waits;
+	long long waitSum;
+	long long err;
+	//longest wait and the cmd holding the lock meanwhile
+	long long waitMax;
+	int maxHolder;
+}lpSlot;
+
+int lpEnabled = 0;
+//accounts reported, counters in the sketch and the sketch itself
+static int lpTop;
+static int lpSlotNum;
+static lpSlot * lpSlots = NULL;
+//guards the sketch
+static pthread_mutex_t lpLk = PTHREAD_MUTEX_INITIALIZER;
+//counter of each account in the sketch plus 1, 0 = none
+static int * lpSlotOf = NULL;
+//cmd holding each lock and since when, index 0 = bank
+static int * lpHolder = NULL;
+static long long * lpSince = NULL;
+//wait of the holder of each lock and the cmd it waited for, charged
+//once the lock is released, -1 = it did not wait
+static long long * lpWait = NULL;
+static int * lpWaitFor = NULL;
+//totals over every lock, updated atomically
+static long long lpAcqs = 0, lpWaits = 0, lpWaitSum = 0, lpWaitMax = 0;
+static long long lpHoldSum = 0, lpHoldMax = 0;
+
+/**microseconds since the epoch
+ * @ret long long: now
+ * @author elithz
+ * @modified 10.18.2026*/
+static long long lpNow(){
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return (long long) tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+/**raise a shared maximum
+ * @param long long * max: maximum
+ * @param long long v: new sample
+ * @ret void
+ * @author elithz
+ * @modified 10.18.2026*/
+static void lpMax(long long * max, long long v){
+	//current maximum
+	long long cur = __atomic_load_n(max, __ATOMIC_RELAXED);
+
+	while(v > cur && !__atomic_compare_exchange_n(max, &cur, v, 0,
+		__ATOMIC_RELAXED, __ATOMIC_RELAXED))
+		;
+}
+
+/**read BAMNG_LOCKPROF and allocate the holder table and sketch
+ * @param int accountNum: number of accounts
+ * @ret int: 0 = operation success, -1 = failure
+ * @author elithz
+ * @modified 10.18.2026*/
+int lpInit(int accountNum){
+	//environment value
+	char * val = getenv("BAMNG_LOCKPROF");
+
+	if(!val)
+		return 0;
+	if(atoi(val) <= 0){
+		fprintf(stderr, "error (baMng): bad BAMNG_LOCKPROF \"%s\", ignored\n", val);
+		return 0;
+	}
+	lpTop = atoi(val);
+	lpSlotNum = lpTop * LP_SPARE;
+	lpSlots = calloc(lpSlotNum, sizeof(lpSlot));
+	lpSlotOf = calloc(accountNum + 1, sizeof(int));
+	lpHolder = calloc(accountNum + 1, sizeof(int));
+	lpSince = calloc(accountNum + 1, sizeof(long long));
+	lpWait = calloc(accountNum + 1, sizeof(long long));
+	lpWaitFor = calloc(accountNum + 1, sizeof(int));
+	if(!lpSlots || !lpSlotOf || !lpHolder || !lpSince || !lpWait
+		|| !lpWaitFor){
+		free(lpSlots);
+		free(lpSlotOf);
+		free(lpHolder);
+		free(lpSince);
+		free(lpWait);
+		free(lpWaitFor);
+		return -1;
+	}
+	lpEnabled = 1;
+	return 0;
+}
+
+/**charge a wait to an account in the sketch, called with no account
+ * lock held
+ * @param int acct: account
+ * @param long long wait: wait in usec
+ * @param int holder: cmd holding the lock when the wait began
+ * @ret void
+ * @author elithz
+ * @modified 10.18.2026*/
+static void lpCharge(int acct, long long wait, int holder){
+	//counter
+	int i;
+	//counter of acct, or the one with the least wait to replace
+	lpSlot * s, * min = &lpSlots[0];
+
+	pthread_mutex_lock(&lpLk);
+	s = lpSlotOf[acct] ? &lpSlots[lpSlotOf[acct] - 1] : NULL;
+	//space-saving: the new account takes over the smallest counter and
+	//its wait, which bounds how much it may be overestimated
+	if(!s){
+		for(i = 1; i < lpSlotNum && min->waits; i++)
+			if(!lpSlots[i].waits || lpSlots[i].waitSum < min->waitSum)
+				min = &lpSlots[i];
+		s = min;
+		if(s->waits)
+			lpSlotOf[s->acct] = 0;
+		lpSlotOf[acct] = s - lpSlots + 1;
+		s->err = s->waitSum;
+		s->acct = acct;
+		s->waits = 0;
+		s->waitMax = 0;
+	}
+	s->waits++;
+	s->waitSum += wait;
+	if(wait >= s->waitMax){
+		s->waitMax = wait;
+		s->maxHolder = holder;
+	}
+	pthread_mutex_unlock(&lpLk);
+}
+
+/**take the lock of an account, timing the wait if it is held
+ * @param pthread_mutex_t * lk: lock
+ * @param int acct: account, 0 = bank
+ * @param int id: cmd taking it
+ * @ret void
+ * @author elithz
+ * @modified 10.18.2026*/
+void lpLock(pthread_mutex_t * lk, int acct, int id){
+	//result of the first attempt
+	int rc = pthread_mutex_trylock(lk);
+	//start of the wait and cmd holding the lock
+	long long start, wait = -1;
+	int holder = 0;
+
+	__atomic_fetch_add(&lpAcqs, 1, __ATOMIC_RELAXED);
+	if(rc == EOWNERDEAD)
+		pthread_mutex_consistent(lk);
+	else if(rc){
+		holder = __atomic_load_n(&lpHolder[acct], __ATOMIC_RELAXED);
+		start = lpNow();
+		fbrLock(lk);
+		wait = lpNow() - start;
+		__atomic_fetch_add(&lpWaits, 1, __ATOMIC_RELAXED);
+		__atomic_fetch_add(&lpWaitSum, wait, __ATOMIC_RELAXED);
+		lpMax(&lpWaitMax, wait);
+	}
+	//the sketch is charged on release, not while others queue for lk
+	lpWait[acct] = wait;
+	lpWaitFor[acct] = holder;
+	__atomic_store_n(&lpHolder[acct], id, __ATOMIC_RELAXED);
+	lpSince[acct] = lpNow();
+}
+
+/**release the lock of an account
+ * @param pthread_mutex_t * lk: lock
+ * @param int acct: account, 0 = bank
+ * @ret void
+ * @author elithz
+ * @modified 10.18.2026*/
+void lpUnlock(pthread_mutex_t * lk, int acct){
+	//how long it was held
+	long long hold = lpNow() - lpSince[acct];
+	//wait to charge, read while the lock still guards it
+	long long wait = lpWait[acct];
+	int holder = lpWaitFor[acct];
+
+	__atomic_store_n(&lpHolder[acct], 0, __ATOMIC_RELAXED);
+	pthread_mutex_unlock(lk);
+	__atomic_fetch_add(&lpHoldSum, hold, __ATOMIC_RELAXED);
+	lpMax(&lpHoldMax, hold);
+	if(wait >= 0)
+		lpCharge(acct, wait, holder);
+}
+
+/**compare sketch counters by wait, longest first
+ * @param const void * a: first counter
+ * @param const void * b: second counter
+ * @ret int: order
+ * @author elithz
+ * @modified 10.18.2026*/
+static int lpCmp(const void * a, const void * b){
+	//waits compared
+	long long x = ((const lpSlot *) a)->waitSum, y = ((const lpSlot *) b)->waitSum;
+	return x < y ? 1 : x > y ? -1 : 0;
+}
+
+/**print the lock totals and the accounts waited on longest
+ * @param FILE * out: report file
+ * @ret void
+ * @author elithz
+ * @modified 10.18.2026*/
+void lpPrtStat(FILE * out){
+	//counter
+	int i;
+
+	if(!lpEnabled)
+		return;
+	fprintf(out, "locks\tacqs\twaits\twaitms\tmaxwaitms\tholdms\tmaxholdms\n");
+	fprintf(out, "all\t%lld\t%lld\t%.3f\t%.3f\t%.3f\t%.3f\n", lpAcqs, lpWaits,
+		lpWaitSum / 1000.0, lpWaitMax / 1000.0, lpHoldSum / 1000.0,
+		lpHoldMax / 1000.0);
+
+	//the workers are done, the index of the sketch is not needed any more
+	pthread_mutex_lock(&lpLk);
+	qsort(lpSlots, lpSlotNum, sizeof(lpSlot), lpCmp);
+	fprintf(out, "acct\twaits\twaitms\terrms\tmaxwaitms\tholder\n");
+	for(i = 0; i < lpTop && lpSlots[i].waits; i++){
+		if(lpSlots[i].acct)
+			fprintf(out, "%d", lpSlots[i].acct);
+		else
+			fprintf(out, "bank");
+		fprintf(out, "\t%lld\t%.3f\t%.3f\t%.3f\t%d\n", lpSlots[i].waits,
+			lpSlots[i].waitSum / 1000.0, lpSlots[i].err / 1000.0,
+			lpSlots[i].waitMax / 1000.0, lpSlots[i].maxHolder);
+	}
+	pthread_mutex_unlock(&lpLk);
+}
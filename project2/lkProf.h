@@ -0,0 +1,51 @@
+/**
+*		Filename:  lkProf.h
+*    Description:  Contention profile of the account locks
+*        Version:  1.0
+*        Created:  10.18.2026 20h51min37s
+*         Author:  Ningyuan Zhang （狮子劫博丽）(elithz), elithz@iastate.edu
+*        Company:  NERVE Software
+*/
+
+/*
+ *  With BAMNG_LOCKPROF=k every account lock (and bankLk as account 0)
+ *  is taken through lpLock: a trylock first, and only when that fails
+ *  the wait is timed and, once the lock is released again, charged to
+ *  the account together with the cmd holding it, so the critical
+ *  section does not grow by the bookkeeping. Contended accounts go into
+ *  a space-saving sketch of 4k counters indexed by account, so memory
+ *  for the counters stays fixed however many accounts there are and
+ *  any account with more than 1/(4k) of the total wait is sure to be
+ *  kept. At END the totals and the k accounts waited on longest are
+ *  printed. Disabled, LP_LOCK and LP_UNLOCK are one load and a branch
+ *  in front of the plain lock calls.
+ */
+
+#ifndef LKPROF
+#define LKPROF
+
+#include "fiber.h"
+#include <stdio.h>
+
+//set when profiling, checked by the macros before any call
+extern int lpEnabled;
+
+//read BAMNG_LOCKPROF, accountNum accounts, ret 0 = success, -1 = failure
+int lpInit(int accountNum);
+
+//take lk of account acct (0 = bank) for cmd id, timing the wait
+void lpLock(pthread_mutex_t * lk, int acct, int id);
+
+//release lk of account acct
+void lpUnlock(pthread_mutex_t * lk, int acct);
+
+//print totals and the hottest accounts
+void lpPrtStat(FILE * out);
+
+//hooks, plain lock calls when profiling is off
+#define LP_LOCK(lk, acct, id) do{ if(lpEnabled) lpLock(lk, acct, id); \
+	else fbrLock(lk); }while(0)
+#define LP_UNLOCK(lk, acct) do{ if(lpEnabled) lpUnlock(lk, acct); \
+	else pthread_mutex_unlock(lk); }while(0)
+
+#endif
@@ -0,0 +1,430 @@
+/**
+*		Filename:  mvStore.c
+*    Description:  Multi version account store for snapshot reads
+*        Version:  1.0
+*        Created:  10.18.2026 14h03min52s
+*         Author:  Ningyuan Zhang （狮子劫博丽）(elithz), elithz@iastate.edu
+*        Company:  NERVE Software
+*/
+
+#include "mvStore.h"
+#include "cmdQue.h"
+#include "aggScan.h"
+
+//one version of an account
+typedef struct mvVer_struct{
+	int value;
+	long long epoch;
+	struct mvVer_struct * older;
+}mvVer;
+
+//scans retried before an aggregate takes the commit lock
+#define MV_AGG_TRIES 4
+
+//newest version of every account
+static mvVer ** mvHead;
+static int mvNum = 0;
+//latest committed value of every account, flat for aggregate scans
+static int * mvLast;
+//odd while a commit updates mvLast
+static unsigned long mvSeq = 0;
+//last committed epoch
+static long long mvClock = 0;
+//pinned snapshots, oldest first
+static mvSnap * pinOld = NULL;
+static mvSnap * pinNew = NULL;
+//guards commits and pins, never held while reading versions
+static pthread_mutex_t mvLk = PTHREAD_MUTEX_INITIALIZER;
+//statistics
+static long long verLive = 0;
+static long long verFreed = 0;
+static long long snapTaken = 0;
+//set once the store is switched off
+static int mvIsOff = 0;
+
+/**create n accounts with value 0 at epoch 0
+ * @param int n: number of accounts
+ * @ret int: 0 = operation success, -1 = failure
+ * @author elithz
+ * @modified 10.18.2026*/
+int mvInit(int n){
+	//counter
+	int i;
+
+	mvHead = malloc(n * sizeof(mvVer *));
+	mvLast = calloc(n, sizeof(int));
+	if(!mvHead || !mvLast)
+		return -1;
+	for(i = 0; i < n; i++){
+		mvHead[i] = malloc(sizeof(mvVer));
+		if(!mvHead[i])
+			return -1;
+		mvHead[i]->value = 0;
+		mvHead[i]->epoch = 0;
+		mvHead[i]->older = NULL;
+	}
+	mvNum = n;
+	verLive = n;
+	aggInit(0);
+	return 0;
+}
+
+/**free every version
+ * @ret void
+ * @author elithz
+ * @modified 10.18.2026*/
+void mvFree(){
+	//counter
+	int i;
+	//version to free
+	mvVer * v, * o;
+
+	for(i = 0; i < mvNum; i++){
+		for(v = mvHead[i]; v; v = o){
+			o = v->older;
+			free(v);
+		}
+	}
+	free(mvHead);
+	free(mvLast);
+	mvHead = NULL;
+	mvLast = NULL;
+	mvNum = 0;
+	aggFree();
+}
+
+/**free every version and turn the store off, commits are ignored and
+ * snapshot cmds refused from now on
+ * @ret void
+ * @author elithz
+ * @modified 10.18.2026*/
+void mvOff(){
+	mvFree();
+	mvIsOff = 1;
+}
+
+/**drop versions nobody can reach any more, mvLk must be held
+ * @param int i: account index
+ * @ret void
+ * @author elithz
+ * @modified 10.18.2026*/
+static void mvPrune(int i){
+	//oldest epoch any reader may ask for
+	long long floor = pinOld ? pinOld->epoch : mvClock;
+	//newest version visible at floor and versions behind it
+	mvVer * keep, * v, * o;
+
+	for(keep = mvHead[i]; keep && keep->epoch > floor; keep = keep->older)
+		;
+	if(!keep)
+		return;
+
+	//readers stop at keep, so nothing behind it is in use
+	v = keep->older;
+	keep->older = NULL;
+	for(; v; v = o){
+		o = v->older;
+		free(v);
+		verLive--;
+		verFreed++;
+	}
+}
+
+/**install new values of n accounts as one commit
+ * @param int n: number of accounts written
+ * @param int * acts: account IDs, from 1
+ * @param int * vals: new values
+ * @ret void
+ * @author elithz
+ * @modified 10.18.2026*/
+void mvCommit(int n, int * acts, int * vals){
+	//counter
+	int i;
+	//new versions
+	mvVer * v;
+	//epoch of this commit
+	long long ep;
+
+	if(mvIsOff)
+		return;
+	pthread_mutex_lock(&mvLk);
+	ep = mvClock + 1;
+	__atomic_store_n(&mvSeq, mvSeq + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	for(i = 0; i < n; i++)
+		mvLast[acts[i] - 1] = vals[i];
+	__atomic_store_n(&mvSeq, mvSeq + 1, __ATOMIC_RELEASE);
+
+	for(i = 0; i < n; i++){
+		v = malloc(sizeof(mvVer));
+		if(!v)
+			continue;
+		v->value = vals[i];
+		v->epoch = ep;
+		v->older = mvHead[acts[i] - 1];
+		//publish after the version is complete
+		__atomic_store_n(&mvHead[acts[i] - 1], v, __ATOMIC_RELEASE);
+		verLive++;
+	}
+	//make the whole commit visible at once
+	__atomic_store_n(&mvClock, ep, __ATOMIC_RELEASE);
+
+	for(i = 0; i < n; i++)
+		mvPrune(acts[i] - 1);
+	pthread_mutex_unlock(&mvLk);
+}
+
+/**pin the latest committed epoch
+ * @ret mvSnap *: snapshot, NULL on failure
+ * @author elithz
+ * @modified 10.18.2026*/
+mvSnap * mvBegin(){
+	//pin to use
+	mvSnap * s;
+
+	pthread_mutex_lock(&mvLk);
+	snapTaken++;
+	//readers of the same epoch share one pin
+	if(pinNew && pinNew->epoch == mvClock){
+		pinNew->refs++;
+		pthread_mutex_unlock(&mvLk);
+		return pinNew;
+	}
+
+	s = malloc(sizeof(mvSnap));
+	if(s){
+		s->epoch = mvClock;
+		s->refs = 1;
+		s->next = NULL;
+		s->prev = pinNew;
+		if(pinNew)
+			pinNew->next = s;
+		else
+			pinOld = s;
+		pinNew = s;
+	}
+	pthread_mutex_unlock(&mvLk);
+	return s;
+}
+
+/**value of an account as of the snapshot
+ * @param mvSnap * snap: pinned snapshot
+ * @param int ID: account ID, from 1
+ * @ret int: value
+ * @author elithz
+ * @modified 10.18.2026*/
+int mvRead(mvSnap * snap, int ID){
+	//version being looked at
+	mvVer * v = __atomic_load_n(&mvHead[ID - 1], __ATOMIC_ACQUIRE);
+
+	while(v->epoch > snap->epoch)
+		v = v->older;
+	return v->value;
+}
+
+/**unpin a snapshot
+ * @param mvSnap * snap: snapshot from mvBegin
+ * @ret void
+ * @author elithz
+ * @modified 10.18.2026*/
+void mvEnd(mvSnap * snap){
+	pthread_mutex_lock(&mvLk);
+	if(--snap->refs == 0){
+		if(snap->prev)
+			snap->prev->next = snap->next;
+		else
+			pinOld = snap->next;
+		if(snap->next)
+			snap->next->prev = snap->prev;
+		else
+			pinNew = snap->prev;
+		free(snap);
+	}
+	pthread_mutex_unlock(&mvLk);
+}
+
+/**scan the latest committed values once they are consistent
+ * @param aggRes * res: sum, min and max
+ * @param int nb: histogram buckets, 0 = no histogram
+ * @param long long * cnt: bucket counts
+ * @ret void
+ * @author elithz
+ * @modified 10.18.2026*/
+static void mvAgg(aggRes * res, int nb, long long * cnt){
+	//attempts and sequence seen before the scan
+	int tries;
+	unsigned long seq;
+
+	for(tries = 0; tries < MV_AGG_TRIES; tries++){
+		seq = __atomic_load_n(&mvSeq, __ATOMIC_ACQUIRE);
+		if(seq & 1)
+			continue;
+		aggScan(mvLast, mvNum, res);
+		if(nb)
+			aggHist(mvLast, mvNum, res->min, res->max, nb, cnt);
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		if(__atomic_load_n(&mvSeq, __ATOMIC_RELAXED) == seq)
+			return;
+	}
+
+	//commits keep getting in the way, hold them off for one scan
+	pthread_mutex_lock(&mvLk);
+	aggScan(mvLast, mvNum, res);
+	if(nb)
+		aggHist(mvLast, mvNum, res->min, res->max, nb, cnt);
+	pthread_mutex_unlock(&mvLk);
+}
+
+/**read an account ID token
+ * @param char * tok: token
+ * @param int * ID: parsed ID
+ * @ret int: 0 = valid account, -1 = not a valid account
+ * @author elithz
+ * @modified 10.18.2026*/
+static int mvId(char * tok, int * ID){
+	//end of the number
+	char * end;
+	long v = strtol(tok, &end, 10);
+
+	if(*end || v < 1 || v > mvNum)
+		return -1;
+	*ID = (int) v;
+	return 0;
+}
+
+/**run a snapshot cmd and log its result
+ * @param FILE * out: result file
+ * @param LinkedCommand * cmd: cmd being run
+ * @param char ** tok: tokens of the cmd
+ * @param int tokNum: number of tokens
+ * @ret int: 0 = handled, -1 = not a snapshot cmd, 1 = bad arguments
+ * @author elithz
+ * @modified 10.18.2026*/
+int mvCmd(FILE * out, LinkedCommand * cmd, char ** tok, int tokNum){
+	//counter
+	int i;
+	//account IDs
+	int ID, lo, hi;
+	//pinned snapshot
+	mvSnap * snap;
+	//results
+	int * vals;
+	long long total = 0;
+	//aggregate scan, histogram buckets and counts
+	aggRes agg;
+	int nb;
+	long long cnt[AGG_MAX_BUCKETS];
+	//time of the answer
+	struct timeval now;
+
+	//snapshot cmds are refused while the store is off
+	if(mvIsOff)
+		return (strcmp(tok[0], "CHECK") == 0 && tokNum > 2)
+			|| strcmp(tok[0], "SUM") == 0 || strcmp(tok[0], "AGG") == 0 ? 1 : -1;
+
+	//single account CHECK stays on the backend
+	if(strcmp(tok[0], "CHECK") == 0 && tokNum > 2){
+		for(i = 1; i < tokNum; i++)
+			if(mvId(tok[i], &ID))
+				return 1;
+		//any number of accounts, too many for a fiber's stack
+		vals = malloc(tokNum * sizeof(int));
+		if(!vals)
+			return 1;
+		if(!(snap = mvBegin())){
+			free(vals);
+			return 1;
+		}
+		for(i = 1; i < tokNum; i++){
+			mvId(tok[i], &ID);
+			vals[i] = mvRead(snap, ID);
+		}
+		mvEnd(snap);
+
+		gettimeofday(&now, NULL);
+		flockfile(out);
+		fprintf(out, "%d BAL", cmd->id);
+		for(i = 1; i < tokNum; i++)
+			fprintf(out, " %d", vals[i]);
+		fprintf(out, " TIME %ld.%06ld %ld.%06ld\n", (long) cmd->timestamp.tv_sec,
+			(long) cmd->timestamp.tv_usec, (long) now.tv_sec,
+			(long) now.tv_usec);
+		funlockfile(out);
+		free(vals);
+		queStat(cmd);
+		return 0;
+	}
+
+	if(strcmp(tok[0], "SUM") == 0){
+		if(tokNum != 3 || mvId(tok[1], &lo) || mvId(tok[2], &hi) || lo > hi)
+			return 1;
+		if(!(snap = mvBegin()))
+			return 1;
+		for(ID = lo; ID <= hi; ID++)
+			total += mvRead(snap, ID);
+		mvEnd(snap);
+
+		gettimeofday(&now, NULL);
+		flockfile(out);
+		fprintf(out, "%d SUM %lld TIME %ld.%06ld %ld.%06ld\n", cmd->id, total,
+			(long) cmd->timestamp.tv_sec, (long) cmd->timestamp.tv_usec,
+			(long) now.tv_sec, (long) now.tv_usec);
+		funlockfile(out);
+		queStat(cmd);
+		return 0;
+	}
+
+	if(strcmp(tok[0], "AGG") == 0){
+		if(tokNum == 2 && (strcmp(tok[1], "SUM") == 0 || strcmp(tok[1], "MIN")
+			== 0 || strcmp(tok[1], "MAX") == 0)){
+			mvAgg(&agg, 0, NULL);
+			total = tok[1][1] == 'U' ? agg.sum : tok[1][1] == 'I' ? agg.min
+				: agg.max;
+
+			gettimeofday(&now, NULL);
+			flockfile(out);
+			fprintf(out, "%d AGG %s %lld TIME %ld.%06ld %ld.%06ld\n", cmd->id,
+				tok[1], total, (long) cmd->timestamp.tv_sec,
+				(long) cmd->timestamp.tv_usec, (long) now.tv_sec,
+				(long) now.tv_usec);
+			funlockfile(out);
+			queStat(cmd);
+			return 0;
+		}
+		if(tokNum == 3 && strcmp(tok[1], "HIST") == 0){
+			nb = atoi(tok[2]);
+			if(nb < 1 || nb > AGG_MAX_BUCKETS)
+				return 1;
+			mvAgg(&agg, nb, cnt);
+
+			gettimeofday(&now, NULL);
+			flockfile(out);
+			fprintf(out, "%d HIST %d %d", cmd->id, agg.min, agg.max);
+			for(i = 0; i < nb; i++)
+				fprintf(out, " %lld", cnt[i]);
+			fprintf(out, " TIME %ld.%06ld %ld.%06ld\n",
+				(long) cmd->timestamp.tv_sec, (long) cmd->timestamp.tv_usec,
+				(long) now.tv_sec, (long) now.tv_usec);
+			funlockfile(out);
+			queStat(cmd);
+			return 0;
+		}
+		return 1;
+	}
+
+	return -1;
+}
+
+/**print version statistics
+ * @param FILE * out: where to print
+ * @ret void
+ * @author elithz
+ * @modified 10.18.2026*/
+void mvPrtStat(FILE * out){
+	if(!snapTaken)
+		return;
+	pthread_mutex_lock(&mvLk);
+	fprintf(out, "mvcc epoch %lld snapshots %lld versions live %lld freed %lld\n",
+		mvClock, snapTaken, verLive, verFreed);
+	pthread_mutex_unlock(&mvLk);
+}
@@ -0,0 +1,75 @@
+/**
+*		Filename:  mvStore.h
+*    Description:  Multi version account store for snapshot reads
+*        Version:  1.0
+*        Created:  10.18.2026 14h03min52s
+*         Author:  Ningyuan Zhang （狮子劫博丽）(elithz), elithz@iastate.edu
+*        Company:  NERVE Software
+*/
+
+/*
+ *  Every committed TRANS installs a new version of each account it
+ *  wrote, all stamped with the same commit epoch, so a reader that
+ *  pins an epoch sees whole transactions or nothing. Readers never
+ *  take account locks and writers never wait for readers.
+ *
+ *  Versions older than the newest one visible to the oldest pinned
+ *  epoch can not be reached by anyone and are freed when the account
+ *  is written next.
+ *
+ *  Snapshot cmds, answered from the store without backend delay:
+ *    CHECK a1 a2 ... an   "<id> BAL v1 v2 ... vn TIME <arrive> <answer>"
+ *    SUM lo hi            "<id> SUM total TIME <arrive> <answer>"
+ *
+ *  Aggregates over every account scan a flat array of the latest
+ *  committed values in parallel (see aggScan.h). A sequence counter
+ *  bumped around every commit tells the scan whether it saw a
+ *  consistent state; it retries a few times and then scans holding
+ *  the commit lock.
+ *    AGG SUM | AGG MIN | AGG MAX   "<id> AGG SUM|MIN|MAX value TIME ..."
+ *    AGG HIST nb                   "<id> HIST lo hi c1 ... cnb TIME ..."
+ */
+
+#ifndef MVSTORE
+#define MVSTORE
+
+#include "baMng.h"
+
+//a pinned snapshot
+typedef struct mvSnap_struct{
+	long long epoch;
+	int refs;
+	struct mvSnap_struct * prev;
+	struct mvSnap_struct * next;
+}mvSnap;
+
+//create n accounts with value 0, ret 0 = success, -1 = failure
+int mvInit(int n);
+
+//free every version
+void mvFree();
+
+//free every version, ignore commits and refuse snapshot cmds from now on
+void mvOff();
+
+//install new values of n accounts (IDs from 1) as one commit,
+//the caller must hold the locks of those accounts
+void mvCommit(int n, int * acts, int * vals);
+
+//pin the latest committed epoch
+mvSnap * mvBegin();
+
+//value of account ID (from 1) as of the snapshot
+int mvRead(mvSnap * snap, int ID);
+
+//unpin a snapshot
+void mvEnd(mvSnap * snap);
+
+//run a snapshot cmd, ret 0 = handled, -1 = not a snapshot cmd,
+//1 = snapshot cmd with bad arguments
+int mvCmd(FILE * out, LinkedCommand * cmd, char ** tok, int tokNum);
+
+//print version statistics
+void mvPrtStat(FILE * out);
+
+#endif
@@ -0,0 +1,100 @@
+/**
+*		Filename:  recLog.c
+*    Description:  Recording of the incoming cmd stream for replay
+*        Version:  1.0
+*        Created:  10.18.2026 19h48min03s
+*         Author:  Ningyuan Zhang （狮子劫博丽）(elithz), elithz@iastate.edu
+*        Company:  NERVE Software
+*/
+
+#include "recLog.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+//recording, NULL when off
+static FILE * recFPt = NULL;
+//arrival of the previous line in usec
+static long long recLast;
+
+/**microseconds since the epoch
+ * @ret long long: now
+ * @author elithz
+ * @modified 10.18.2026*/
+static long long recNow(){
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return (long long) tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+/**write an unsigned LEB128 varint
+ * @param unsigned long long v: value
+ * @ret void
+ * @author elithz
+ * @modified 10.18.2026*/
+static void recVarint(unsigned long long v){
+	while(v >= 0x80){
+		putc((int) (v & 0x7f) | 0x80, recFPt);
+		v >>= 7;
+	}
+	putc((int) v, recFPt);
+}
+
+/**open the recording BAMNG_RECORD asks for
+ * @ret int: 0 = operation success, -1 = failure
+ * @author elithz
+ * @modified 10.18.2026*/
+int recInit(){
+	//counter
+	int i;
+	//path of the recording
+	char * val = getenv("BAMNG_RECORD");
+
+	if(!val)
+		return 0;
+	recFPt = fopen(val, "wb");
+	if(!recFPt){
+		fprintf(stderr, "error (baMng): failed to open recording \"%s\"\n", val);
+		return -1;
+	}
+	recLast = recNow();
+	fwrite(REC_MAGIC, 1, 4, recFPt);
+	putc(REC_VERSION, recFPt);
+	//start time, little endian
+	for(i = 0; i < 8; i++)
+		putc((int) (recLast >> (i * 8) & 0xff), recFPt);
+	return 0;
+}
+
+/**record a line read from stdin
+ * @param char * line: line without newline
+ * @ret void
+ * @author elithz
+ * @modified 10.18.2026*/
+void recCmd(char * line){
+	//arrival of this line
+	long long now;
+	size_t len;
+
+	if(!recFPt)
+		return;
+	now = recNow();
+	len = strlen(line);
+	recVarint(now > recLast ? now - recLast : 0);
+	recVarint(len);
+	fwrite(line, 1, len, recFPt);
+	if(now > recLast)
+		recLast = now;
+}
+
+/**flush and close the recording
+ * @ret void
+ * @author elithz
+ * @modified 10.18.2026*/
+void recClose(){
+	if(!recFPt)
+		return;
+	fclose(recFPt);
+	recFPt = NULL;
+}
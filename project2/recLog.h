@@ -0,0 +1,37 @@
+/**
+*		Filename:  recLog.h
+*    Description:  Recording of the incoming cmd stream for replay
+*        Version:  1.0
+*        Created:  10.18.2026 19h48min03s
+*         Author:  Ningyuan Zhang （狮子劫博丽）(elithz), elithz@iastate.edu
+*        Company:  NERVE Software
+*/
+
+/*
+ *  With BAMNG_RECORD=path every line read from stdin, END included, is
+ *  appended to path with its arrival time. The file is
+ *    "BAMR" version(1 byte) start(8 bytes, usec since the epoch)
+ *  followed by one record per line
+ *    varint usec since the previous line, varint length, bytes
+ *  (varints are LEB128, 7 bits a byte, low bits first), so a busy
+ *  stream costs about two bytes a line more than the text.
+ *  baRply.c plays a recording back and reports latency and throughput.
+ */
+
+#ifndef RECLOG
+#define RECLOG
+
+//magic and version of a recording
+#define REC_MAGIC "BAMR"
+#define REC_VERSION 1
+
+//open the recording BAMNG_RECORD asks for, ret 0 = success, -1 = failure
+int recInit();
+
+//record a line read from stdin, no-op when not recording
+void recCmd(char * line);
+
+//flush and close the recording
+void recClose();
+
+#endif
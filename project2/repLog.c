@@ -0,0 +1,540 @@
+/**
+*		Filename:  repLog.c
+*    Description:  Log shipping replication from a primary to a follower
+*        Version:  1.0
+*        Created:  10.18.2026 17h12min26s
+*         Author:  Ningyuan Zhang （狮子劫博丽）(elithz), elithz@iastate.edu
+*        Company:  NERVE Software
+*/
+
+#include "repLog.h"
+#include "cmdQue.h"
+#include "mvStore.h"
+#include <errno.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+//roles
+#define REP_OFF 0
+#define REP_PRIMARY 1
+#define REP_FOLLOWER 2
+//bytes that end a batch early
+#define REP_BATCH_BYTES 65536
+//room for one record of n legs
+#define REP_REC_SIZE(n) (64 + (n) * 24)
+
+//balances of the Bank backend
+extern int * BANK_accounts;
+
+//role and socket path
+static int repRole = REP_OFF;
+static char repPath[108];
+//socket to the other side, listening socket of the primary
+static int repFd = -1;
+static int lstnFd = -1;
+//set by repStop()
+static int repStopping = 0;
+//guards the log and the counters below
+static pthread_mutex_t repLk = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t repCv = PTHREAD_COND_INITIALIZER;
+//log not shipped yet and the buffer it is swapped with
+static char * logBuf = NULL;
+static size_t logLen = 0;
+static size_t logCap = 0;
+static char * sendBuf = NULL;
+static size_t sendCap = 0;
+//last appended, last acked / applied record
+static long long repLsn = 0;
+static long long ackLsn = 0;
+//usec the shipper gathers a batch, ms to wait for acks at END
+static long long batchUs = 1000;
+static long long waitMs = 2000;
+//statistics
+static long long batchNum = 0;
+static long long byteNum = 0;
+static long long * lagSmp = NULL;
+static int lagNum = 0;
+static int lagCap = 0;
+static int promoted = 0;
+//threads
+static pthread_t shipper;
+static pthread_t acker;
+static int ackerOn = 0;
+//follower state
+static int repActNum;
+static account * repActs;
+static pthread_mutex_t * repBankLk;
+
+/**microseconds since the epoch
+ * @ret long long: now
+ * @author elithz
+ * @modified 10.18.2026*/
+static long long repNow(){
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return tvUsec(tv);
+}
+
+/**write a whole buffer to the socket
+ * @param int fd: socket
+ * @param char * buf: bytes to write
+ * @param size_t len: number of bytes
+ * @ret int: 0 = operation success, -1 = the other side is gone
+ * @author elithz
+ * @modified 10.18.2026*/
+static int repSend(int fd, char * buf, size_t len){
+	//bytes written by one call
+	ssize_t w;
+
+	while(len > 0){
+		w = send(fd, buf, len, MSG_NOSIGNAL);
+		if(w < 0 && errno == EINTR)
+			continue;
+		if(w <= 0)
+			return -1;
+		buf += w;
+		len -= w;
+	}
+	return 0;
+}
+
+/**read acks of the follower and record the lag of each
+ * @ret void *: NULL
+ * @author elithz
+ * @modified 10.18.2026*/
+static void * repAckRun(void * arg){
+	//received bytes and length of the partial line kept
+	char buf[4096];
+	size_t len = 0;
+	ssize_t r;
+	//current line
+	char * line, * nl;
+	//acked record and its commit time
+	long long lsn, usec;
+	long long * grown;
+
+	while((r = read(repFd, buf + len, sizeof(buf) - 1 - len)) > 0){
+		len += r;
+		buf[len] = '\0';
+		line = buf;
+		while((nl = strchr(line, '\n'))){
+			*nl = '\0';
+			if(sscanf(line, "A %lld %lld", &lsn, &usec) == 2){
+				pthread_mutex_lock(&repLk);
+				if(lsn > ackLsn)
+					ackLsn = lsn;
+				if(lagNum == lagCap){
+					lagCap = lagCap ? lagCap * 2 : 1024;
+					grown = realloc(lagSmp, lagCap * sizeof(long long));
+					if(grown)
+						lagSmp = grown;
+					else
+						lagCap = lagNum;
+				}
+				if(lagNum < lagCap)
+					lagSmp[lagNum++] = repNow() - usec;
+				pthread_mutex_unlock(&repLk);
+			}
+			line = nl + 1;
+		}
+		//keep the partial line
+		len = strlen(line);
+		memmove(buf, line, len);
+	}
+	return NULL;
+}
+
+/**ship the log to the follower in batches, never waits for acks
+ * @ret void *: NULL
+ * @author elithz
+ * @modified 10.18.2026*/
+static void * repShipRun(void * arg){
+	//buffer swapped out of the log
+	char * b;
+	size_t len, cap;
+	//end of the batch window
+	struct timespec until;
+	long long end;
+
+	//the log is kept from lsn 1 until a follower shows up
+	while((repFd = accept(lstnFd, NULL, NULL)) < 0)
+		if(errno != EINTR || repStopping)
+			return NULL;
+	if(!pthread_create(&acker, NULL, repAckRun, NULL))
+		ackerOn = 1;
+
+	pthread_mutex_lock(&repLk);
+	while(1){
+		while(!logLen && !repStopping)
+			pthread_cond_wait(&repCv, &repLk);
+		if(!logLen)
+			break;
+
+		//gather what commits during the batch window
+		end = repNow() + batchUs;
+		until.tv_sec = end / 1000000;
+		until.tv_nsec = end % 1000000 * 1000;
+		while(!repStopping && logLen < REP_BATCH_BYTES
+			&& pthread_cond_timedwait(&repCv, &repLk, &until) != ETIMEDOUT)
+			;
+
+		//swap buffers so appends go on while this batch is sent
+		b = logBuf;
+		len = logLen;
+		cap = logCap;
+		logBuf = sendBuf;
+		logCap = sendCap;
+		logLen = 0;
+		pthread_mutex_unlock(&repLk);
+
+		if(repSend(repFd, b, len)){
+			fprintf(stderr, "error (baMng): follower gone, replication stopped\n");
+			pthread_mutex_lock(&repLk);
+			sendBuf = b;
+			sendCap = cap;
+			break;
+		}
+
+		pthread_mutex_lock(&repLk);
+		sendBuf = b;
+		sendCap = cap;
+		batchNum++;
+		byteNum += len;
+	}
+	pthread_mutex_unlock(&repLk);
+	return NULL;
+}
+
+/**apply one log record under the account locks
+ * @param char * rec: record line without the newline
+ * @param long long * lsn: set to the lsn of the record
+ * @param long long * usec: set to the commit time of the record
+ * @ret int: 0 = applied, -1 = malformed record
+ * @author elithz
+ * @modified 10.18.2026*/
+static int repApply(char * rec, long long * lsn, long long * usec){
+	//counter
+	int i;
+	//legs of the record and position in the line
+	int n, pos, used;
+	int * acts, * vals;
+
+	if(sscanf(rec, "L %lld %lld %d%n", lsn, usec, &n, &pos) != 3 || n < 1)
+		return -1;
+	acts = malloc(2 * n * sizeof(int));
+	if(!acts)
+		return -1;
+	vals = acts + n;
+	for(i = 0; i < n; i++){
+		if(sscanf(rec + pos, "%d %d%n", &acts[i], &vals[i], &used) != 2
+			|| acts[i] < 1 || acts[i] > repActNum){
+			free(acts);
+			return -1;
+		}
+		pos += used;
+	}
+
+	//accounts are in ascending order like the primary locked them
+	pthread_mutex_lock(repBankLk);
+	for(i = 0; i < n; i++)
+		pthread_mutex_lock(&(repActs[acts[i] - 1].lock));
+	for(i = 0; i < n; i++)
+		BANK_accounts[acts[i] - 1] = vals[i];
+	mvCommit(n, acts, vals);
+	for(i = n - 1; i >= 0; i--)
+		pthread_mutex_unlock(&(repActs[acts[i] - 1].lock));
+	pthread_mutex_unlock(repBankLk);
+
+	free(acts);
+	return 0;
+}
+
+/**connect to the primary, apply its log and ack it, promote this
+ * server when the primary goes away
+ * @ret void *: NULL
+ * @author elithz
+ * @modified 10.18.2026*/
+static void * repFollowRun(void * arg){
+	//socket address of the primary
+	struct sockaddr_un addr;
+	int fd = -1;
+	//received bytes, length kept and a grown buffer
+	char * buf, * grown;
+	size_t len = 0, cap = REP_BATCH_BYTES;
+	ssize_t r;
+	//current line
+	char * line, * nl;
+	//last applied record
+	long long lsn = 0, usec = 0, lastLsn = 0, lastUs = 0;
+	//ack line
+	char ack[64];
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	strncpy(addr.sun_path, repPath, sizeof(addr.sun_path) - 1);
+
+	//wait for the primary to come up
+	while(!repStopping){
+		fd = socket(AF_UNIX, SOCK_STREAM, 0);
+		if(fd < 0)
+			return NULL;
+		if(!connect(fd, (struct sockaddr *) &addr, sizeof(addr)))
+			break;
+		close(fd);
+		fd = -1;
+		usleep(10000);
+	}
+	if(fd < 0)
+		return NULL;
+	pthread_mutex_lock(&repLk);
+	repFd = fd;
+	pthread_mutex_unlock(&repLk);
+
+	buf = malloc(cap);
+	if(!buf)
+		return NULL;
+	while(1){
+		//a record longer than the buffer
+		if(len + 1 >= cap){
+			grown = realloc(buf, cap * 2);
+			if(!grown)
+				break;
+			buf = grown;
+			cap *= 2;
+		}
+		r = read(fd, buf + len, cap - 1 - len);
+		if(r < 0 && errno == EINTR)
+			continue;
+		if(r <= 0)
+			break;
+		len += r;
+		buf[len] = '\0';
+
+		line = buf;
+		while((nl = strchr(line, '\n'))){
+			*nl = '\0';
+			if(!repApply(line, &lsn, &usec)){
+				lastLsn = lsn;
+				lastUs = usec;
+			}
+			else
+				fprintf(stderr, "error (baMng): bad log record \"%s\", ignored\n",
+					line);
+			line = nl + 1;
+		}
+		len = strlen(line);
+		memmove(buf, line, len);
+
+		//one ack for everything applied from this read
+		pthread_mutex_lock(&repLk);
+		ackLsn = lastLsn;
+		pthread_mutex_unlock(&repLk);
+		snprintf(ack, sizeof(ack), "A %lld %lld\n", lastLsn, lastUs);
+		repSend(fd, ack, strlen(ack));
+	}
+	free(buf);
+
+	//primary is gone, take writes from now on
+	pthread_mutex_lock(&repLk);
+	if(!repStopping){
+		promoted = 1;
+		fprintf(stderr, "baMng: primary gone after lsn %lld, promoted\n",
+			lastLsn);
+	}
+	pthread_mutex_unlock(&repLk);
+	return NULL;
+}
+
+/**start replication as BAMNG_REPL asks
+ * @param int accountNum: number of accounts
+ * @param account * accts: account table, a follower applies under its locks
+ * @param pthread_mutex_t * bankLock: bank lock, also taken by a follower
+ * @ret int: 0 = operation success, -1 = failure
+ * @author elithz
+ * @modified 10.18.2026*/
+int repInit(int accountNum, account * accts, pthread_mutex_t * bankLock){
+	//environment values
+	char * val = getenv("BAMNG_REPL");
+	long long n;
+	//socket address
+	struct sockaddr_un addr;
+
+	if(!val)
+		return 0;
+	if(strncmp(val, "primary:", 8) == 0)
+		repRole = REP_PRIMARY;
+	else if(strncmp(val, "follower:", 9) == 0)
+		repRole = REP_FOLLOWER;
+	if(!repRole || !strchr(val, ':')[1]
+		|| strlen(strchr(val, ':') + 1) >= sizeof(repPath)){
+		fprintf(stderr, "error (baMng): bad BAMNG_REPL \"%s\", ignored\n", val);
+		repRole = REP_OFF;
+		return 0;
+	}
+	strcpy(repPath, strchr(val, ':') + 1);
+	if((val = getenv("BAMNG_REPL_BATCH")) && sscanf(val, "%lld", &n) == 1
+		&& n >= 0)
+		batchUs = n;
+	if((val = getenv("BAMNG_REPL_WAIT")) && sscanf(val, "%lld", &n) == 1
+		&& n >= 0)
+		waitMs = n;
+
+	repActNum = accountNum;
+	repActs = accts;
+	repBankLk = bankLock;
+
+	if(repRole == REP_FOLLOWER)
+		return pthread_create(&shipper, NULL, repFollowRun, NULL) ? -1 : 0;
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	strcpy(addr.sun_path, repPath);
+	unlink(repPath);
+	lstnFd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if(lstnFd < 0 || bind(lstnFd, (struct sockaddr *) &addr, sizeof(addr))
+		|| listen(lstnFd, 1)){
+		perror("error (baMng): replication socket");
+		return -1;
+	}
+	return pthread_create(&shipper, NULL, repShipRun, NULL) ? -1 : 0;
+}
+
+/**log a committed TRANS as one record of after images
+ * @param int n: number of accounts written
+ * @param int * acts: account IDs, from 1
+ * @param int * vals: new values
+ * @ret void
+ * @author elithz
+ * @modified 10.18.2026*/
+void repAppend(int n, int * acts, int * vals){
+	//counter
+	int i;
+	//commit time
+	long long now;
+	char * grown;
+	//log was empty before this record
+	int wasEmpty;
+
+	if(repRole != REP_PRIMARY)
+		return;
+	now = repNow();
+
+	pthread_mutex_lock(&repLk);
+	wasEmpty = logLen == 0;
+	if(logLen + REP_REC_SIZE(n) > logCap){
+		grown = realloc(logBuf, (logLen + REP_REC_SIZE(n)) * 2);
+		if(!grown){
+			pthread_mutex_unlock(&repLk);
+			return;
+		}
+		logBuf = grown;
+		logCap = (logLen + REP_REC_SIZE(n)) * 2;
+	}
+	logLen += sprintf(logBuf + logLen, "L %lld %lld %d", ++repLsn, now, n);
+	for(i = 0; i < n; i++)
+		logLen += sprintf(logBuf + logLen, " %d %d", acts[i], vals[i]);
+	logBuf[logLen++] = '\n';
+	//wake the shipper for the first record of a batch or a full batch
+	if(wasEmpty || logLen >= REP_BATCH_BYTES)
+		pthread_cond_signal(&repCv);
+	pthread_mutex_unlock(&repLk);
+}
+
+/**is this a follower that still refuses TRANS
+ * @ret int: 1 = read only, 0 = takes TRANS
+ * @author elithz
+ * @modified 10.18.2026*/
+int repReadOnly(){
+	return repRole == REP_FOLLOWER && !__atomic_load_n(&promoted,
+		__ATOMIC_RELAXED);
+}
+
+/**log a READONLY result for a TRANS sent to a follower
+ * @param FILE * out: result file
+ * @param int id: id of the cmd
+ * @param struct timeval arrive: arrival time of the cmd
+ * @ret void
+ * @author elithz
+ * @modified 10.18.2026*/
+void prtRdOnly(FILE * out, int id, struct timeval arrive){
+	//time of the answer
+	struct timeval now;
+
+	gettimeofday(&now, NULL);
+	flockfile(out);
+	fprintf(out, "%d READONLY TIME %ld.%06ld %ld.%06ld\n", id,
+		(long) arrive.tv_sec, (long) arrive.tv_usec, (long) now.tv_sec,
+		(long) now.tv_usec);
+	funlockfile(out);
+}
+
+/**compare two lags for qsort
+ * @ret int: <0, 0, >0 as a is smaller, equal, larger than b
+ * @author elithz
+ * @modified 10.18.2026*/
+static int lagCmp(const void * a, const void * b){
+	long long x = *(const long long *) a, y = *(const long long *) b;
+	return (x > y) - (x < y);
+}
+
+/**flush the log, wait for acks, stop replication and print statistics
+ * @param FILE * log: where to print
+ * @ret void
+ * @author elithz
+ * @modified 10.18.2026*/
+void repStop(FILE * log){
+	//end of the ack wait
+	long long until = repNow() + waitMs * 1000;
+
+	if(repRole == REP_OFF)
+		return;
+
+	if(repRole == REP_FOLLOWER){
+		pthread_mutex_lock(&repLk);
+		repStopping = 1;
+		if(repFd >= 0)
+			shutdown(repFd, SHUT_RDWR);
+		pthread_mutex_unlock(&repLk);
+		pthread_join(shipper, NULL);
+		fprintf(log, "repl follower: applied up to lsn %lld%s\n", ackLsn,
+			promoted ? ", promoted" : "");
+		if(repFd >= 0)
+			close(repFd);
+		return;
+	}
+
+	//let the shipper send the rest of the log
+	pthread_mutex_lock(&repLk);
+	repStopping = 1;
+	pthread_cond_signal(&repCv);
+	pthread_mutex_unlock(&repLk);
+	//a follower that never came can not be waited for
+	if(repFd < 0)
+		shutdown(lstnFd, SHUT_RDWR);
+	pthread_join(shipper, NULL);
+
+	//give the follower a moment to ack the tail
+	while(ackerOn && __atomic_load_n(&ackLsn, __ATOMIC_RELAXED) < repLsn
+		&& repNow() < until)
+		usleep(1000);
+	if(repFd >= 0)
+		shutdown(repFd, SHUT_RDWR);
+	if(ackerOn)
+		pthread_join(acker, NULL);
+	if(repFd >= 0)
+		close(repFd);
+	close(lstnFd);
+	unlink(repPath);
+
+	fprintf(log, "repl primary: %lld records in %lld batches (%lld bytes), "
+		"acked lsn %lld\n", repLsn, batchNum, byteNum, ackLsn);
+	if(lagNum){
+		qsort(lagSmp, lagNum, sizeof(long long), lagCmp);
+		fprintf(log, "repl lag ms: p50 %.3f p99 %.3f max %.3f\n",
+			lagSmp[lagNum / 2] / 1000.0, lagSmp[(int) (lagNum * 0.99)] / 1000.0,
+			lagSmp[lagNum - 1] / 1000.0);
+	}
+	free(lagSmp);
+	free(logBuf);
+	free(sendBuf);
+}
@@ -0,0 +1,55 @@
+/**
+*		Filename:  repLog.h
+*    Description:  Log shipping replication from a primary to a follower
+*        Version:  1.0
+*        Created:  10.18.2026 17h12min26s
+*         Author:  Ningyuan Zhang （狮子劫博丽）(elithz), elithz@iastate.edu
+*        Company:  NERVE Software
+*/
+
+/*
+ *  A primary appends every committed TRANS to an in memory log as one
+ *  record of after images
+ *    L lsn commitUsec n a1 v1 ... an vn
+ *  and a shipper thread streams the log over a unix socket. Records
+ *  committed while a batch is on the wire are gathered into the next
+ *  one, the shipper never waits for acks, so a TRANS only pays for
+ *  appending its record.
+ *
+ *  A follower connects to the primary, applies records in log order
+ *  under the account locks (balances and snapshot versions, without
+ *  backend delay) and acks "A lsn commitUsec" after every read. It
+ *  serves CHECK, snapshot and AGG cmds from its own stdin and answers
+ *  TRANS with READONLY. When the primary goes away the follower is
+ *  promoted and takes TRANS itself.
+ *
+ *    BAMNG_REPL        primary:path or follower:path of the socket
+ *    BAMNG_REPL_BATCH  usec the shipper gathers a batch (default 1000)
+ *    BAMNG_REPL_WAIT   ms a primary waits at END for the follower to
+ *                      ack the whole log (default 2000)
+ *
+ *  The primary reports lag (commit to ack) at END.
+ */
+
+#ifndef REPLOG
+#define REPLOG
+
+#include "baMng.h"
+
+//start replication as BAMNG_REPL asks, nothing to do if it is not set
+//ret 0 = success, -1 = failure
+int repInit(int accountNum, account * accts, pthread_mutex_t * bankLock);
+
+//log a committed TRANS, the caller must hold the locks of its accounts
+void repAppend(int n, int * acts, int * vals);
+
+//1 = this is a follower that was not promoted yet, TRANS are refused
+int repReadOnly();
+
+//log a READONLY result for a TRANS sent to a follower
+void prtRdOnly(FILE * out, int id, struct timeval arrive);
+
+//flush the log, wait for acks, stop replication and print statistics
+void repStop(FILE * log);
+
+#endif
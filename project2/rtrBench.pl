@@ -0,0 +1,53 @@
+#!/usr/bin/perl
+# Scaling benchmark of baRtr over 1 to 8 baMng instances
+#
+# Every run gets the same workload: the accounts are funded, then
+# random two account transfers, a share of them crossing instances
+# whenever there is more than one. BANK_LAT and the other BANK_* and
+# BAMNG_* settings of the environment are passed on to the instances.
+use strict;
+use warnings;
+use Time::HiRes qw(time);
+
+my($thread, $accts, $cmds, $seed) = @ARGV;
+
+$thread ||= 10;		# workers of each instance
+$accts ||= 1000;	# accounts over all instances
+$cmds ||= 2000;		# transfers per run
+$seed ||= 0;
+
+srand($seed + 5);
+
+my $input = "rtrBench-$$.in";
+open my $in, '>', $input or die "can not write $input: $!\n";
+for my $acct (1..$accts) {
+	print $in "TRANS $acct 1000000\n";
+}
+for (1..$cmds) {
+	my $a = 1 + int(rand($accts));
+	my $b = 1 + int(rand($accts - 1));
+	$b++ if $b >= $a;
+	my $amt = 1 + int(rand(1000));
+	print $in "TRANS $a -$amt $b $amt\n";
+}
+print $in "END\n";
+close $in;
+
+my $total = $accts + $cmds;
+print "instances\tsecs\tcmds/s\tcross\n";
+for my $n (1..8) {
+	my $out = "rtrBench-$$.out";
+	my $t0 = time;
+	system("./baRtr $n $thread $accts $out < $input > /dev/null 2> $out.err") == 0
+		or die "baRtr failed with $n instances\n";
+	my $secs = time - $t0;
+	my $cross = 0;
+	open my $err, '<', "$out.err";
+	while (<$err>) {
+		$cross = $1 if /(\d+) cross instance TRANS/;
+	}
+	close $err;
+	printf "%d\t%.3f\t%.0f\t%d\n", $n, $secs, $total / $secs, $cross;
+	unlink $out, "$out.err";
+}
+unlink $input;
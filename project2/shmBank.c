@@ -0,0 +1,411 @@
+/**
+*		Filename:  shmBank.c
+*    Description:  Worker processes sharing the accounts through shared memory
+*        Version:  1.0
+*        Created:  10.18.2026 16h31min44s
+*         Author:  Ningyuan Zhang （狮子劫博丽）(elithz), elithz@iastate.edu
+*        Company:  NERVE Software
+*/
+
+#define _GNU_SOURCE
+#include "shmBank.h"
+#include "cmdQue.h"
+#include "wkPool.h"
+#include "mvStore.h"
+#include <errno.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+//cmds the ring holds
+#define SHM_RING 1024
+//longest cmd passed through the ring
+#define SHM_CMD_SIZE 200
+//most worker processes
+#define SHM_MAX_PROCS 64
+//local queue length at which a process stops taking cmds
+#define SHM_PUMP_FACTOR 2
+
+//a cmd in the ring
+typedef struct shmSlot_struct{
+	int id;
+	struct timeval timestamp;
+	char cmd[SHM_CMD_SIZE];
+}shmSlot;
+
+//start of the shared mapping
+typedef struct shmHdr_struct{
+	//ring of cmds from the parent
+	pthread_mutex_t lock;
+	pthread_cond_t notEmpty;
+	pthread_cond_t notFull;
+	int head;
+	int tail;
+	int count;
+	int closed;
+	//bank wide lock
+	pthread_mutex_t bankLk;
+	//worker processes, cmds they took and finished
+	pid_t pid[SHM_MAX_PROCS];
+	int taken[SHM_MAX_PROCS];
+	int done[SHM_MAX_PROCS];
+	shmSlot ring[SHM_RING];
+}shmHdr;
+
+//balances of the Bank backend
+extern int * BANK_accounts;
+
+//shared mapping
+static shmHdr * hdr = NULL;
+//worker processes and what they run
+static int procNum = 0;
+static int procWk;
+static void * (*procFn)();
+static int * procRng;
+static FILE * procOut;
+//fate of the worker processes, kept by the parent
+static int respawned[SHM_MAX_PROCS];
+static int lost = 0;
+static pthread_t supervisor;
+
+/**worker processes asked for in the environment
+ * @ret int: BAMNG_PROCS, 0 = single process
+ * @author elithz
+ * @modified 10.18.2026*/
+int shmProcs(){
+	//environment value
+	char * val = getenv("BAMNG_PROCS");
+	int n = val ? atoi(val) : 0;
+
+	if(n > SHM_MAX_PROCS)
+		n = SHM_MAX_PROCS;
+	return n > 0 ? n : 0;
+}
+
+/**lock a mutex that may have been held by a process that died
+ * @param pthread_mutex_t * lk: robust mutex
+ * @ret void
+ * @author elithz
+ * @modified 10.18.2026*/
+void shmLock(pthread_mutex_t * lk){
+	if(pthread_mutex_lock(lk) == EOWNERDEAD)
+		pthread_mutex_consistent(lk);
+}
+
+/**wait on a ring condition, hdr->lock must be held
+ * @param pthread_cond_t * cv: condition to wait on
+ * @ret void
+ * @author elithz
+ * @modified 10.18.2026*/
+static void shmWait(pthread_cond_t * cv){
+	if(pthread_cond_wait(cv, &(hdr->lock)) == EOWNERDEAD)
+		pthread_mutex_consistent(&(hdr->lock));
+}
+
+/**init a process shared, robust mutex
+ * @param pthread_mutex_t * lk: mutex in the shared mapping
+ * @ret void
+ * @author elithz
+ * @modified 10.18.2026*/
+static void shmMutex(pthread_mutex_t * lk){
+	pthread_mutexattr_t attr;
+
+	pthread_mutexattr_init(&attr);
+	pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+	pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);
+	pthread_mutex_init(lk, &attr);
+	pthread_mutexattr_destroy(&attr);
+}
+
+/**init a process shared condition
+ * @param pthread_cond_t * cv: condition in the shared mapping
+ * @ret void
+ * @author elithz
+ * @modified 10.18.2026*/
+static void shmCond(pthread_cond_t * cv){
+	pthread_condattr_t attr;
+
+	pthread_condattr_init(&attr);
+	pthread_condattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+	pthread_cond_init(cv, &attr);
+	pthread_condattr_destroy(&attr);
+}
+
+/**take the next cmd from the ring
+ * @param int k: index of the calling process
+ * @param shmSlot * out: the cmd
+ * @ret int: 0 = got a cmd, 1 = ring closed and empty
+ * @author elithz
+ * @modified 10.18.2026*/
+static int shmPop(int k, shmSlot * out){
+	shmLock(&(hdr->lock));
+	while(hdr->count == 0 && !hdr->closed)
+		shmWait(&(hdr->notEmpty));
+	if(hdr->count == 0){
+		pthread_mutex_unlock(&(hdr->lock));
+		return 1;
+	}
+
+	*out = hdr->ring[hdr->head];
+	hdr->head = (hdr->head + 1) % SHM_RING;
+	hdr->count--;
+	hdr->taken[k]++;
+	pthread_cond_signal(&(hdr->notFull));
+	pthread_mutex_unlock(&(hdr->lock));
+	return 0;
+}
+
+/**body of worker process k, never returns
+ * @param int k: index of the process
+ * @ret void
+ * @author elithz
+ * @modified 10.18.2026*/
+static void shmChild(int k){
+	//cmd from the ring
+	shmSlot slot;
+	//keep only a few cmds locally so idle processes get the rest
+	int pumpMax = procWk * SHM_PUMP_FACTOR;
+
+	//count finished cmds where the parent can see them
+	queDoneCnt = &(hdr->done[k]);
+	//the flag is this process's own copy, a process respawned after the
+	//parent read END still runs until the ring is closed and drained
+	*procRng = 1;
+
+	if(poolStart(procWk, procFn, procRng))
+		exit(1);
+
+	while(1){
+		while(cmdBf->size >= pumpMax)
+			queWait(1000);
+		if(shmPop(k, &slot))
+			break;
+		//a refused cmd is answered here, it is not lost if we crash
+		if(addCmdAt(slot.cmd, slot.id, &slot.timestamp) > 0){
+			prtBusy(procOut, slot.id, slot.timestamp);
+			__atomic_fetch_add(&(hdr->done[k]), 1, __ATOMIC_RELAXED);
+		}
+	}
+
+	//ring is closed, finish what we have
+	*procRng = 0;
+	poolJoin();
+
+	flockfile(stderr);
+	fprintf(stderr, "process %d (pid %d)\n", k, (int) getpid());
+	quePrtStat(stderr);
+	poolPrtStat(stderr);
+	funlockfile(stderr);
+	fflush(procOut);
+	exit(0);
+}
+
+/**fork worker process k
+ * @param int k: index of the process
+ * @ret int: 0 = operation success, -1 = failure
+ * @author elithz
+ * @modified 10.18.2026*/
+static int shmFork(int k){
+	//new process
+	pid_t pid;
+
+	//nobody may be half way through a result line when we fork
+	flockfile(procOut);
+	fflush(procOut);
+	fflush(stdout);
+	hdr->taken[k] = hdr->done[k] = 0;
+	pid = fork();
+	funlockfile(procOut);
+
+	if(pid < 0)
+		return -1;
+	if(pid == 0)
+		shmChild(k);
+	hdr->pid[k] = pid;
+	return 0;
+}
+
+/**replace worker processes that die, returns once all exited after END
+ * @ret void *: NULL
+ * @author elithz
+ * @modified 10.18.2026*/
+static void * shmWatch(void * arg){
+	//counter
+	int k;
+	//processes alive
+	int alive = procNum;
+	//exited process and its status
+	pid_t pid;
+	int st;
+
+	while(alive > 0){
+		pid = waitpid(-1, &st, 0);
+		if(pid < 0){
+			if(errno == EINTR)
+				continue;
+			break;
+		}
+		for(k = 0; k < procNum && hdr->pid[k] != pid; k++)
+			;
+		if(k == procNum)
+			continue;
+
+		//clean exit after END
+		if(WIFEXITED(st) && WEXITSTATUS(st) == 0){
+			alive--;
+			continue;
+		}
+
+		//crashed, its cmds are gone, start a new one in its place
+		lost += hdr->taken[k] - hdr->done[k];
+		if(WIFSIGNALED(st))
+			fprintf(stderr, "error (baMng): process %d (pid %d) killed by "
+				"signal %d, respawning\n", k, (int) pid, WTERMSIG(st));
+		else
+			fprintf(stderr, "error (baMng): process %d (pid %d) exited with "
+				"%d, respawning\n", k, (int) pid, WEXITSTATUS(st));
+		respawned[k]++;
+		if(shmFork(k))
+			alive--;
+	}
+	return NULL;
+}
+
+/**move the bank into shared memory and fork the worker processes
+ * @param int workersNum: workers per process
+ * @param int accountNum: number of accounts
+ * @param account ** accts: account table, moved into shared memory
+ * @param pthread_mutex_t ** bankLock: bank lock, moved into shared memory
+ * @param FILE * out: result file
+ * @param void * (*fn)(): worker body
+ * @param int * running: server flag
+ * @ret int: 0 = operation success, -1 = failure
+ * @author elithz
+ * @modified 10.18.2026*/
+int shmStart(int workersNum, int accountNum, account ** accts,
+	pthread_mutex_t ** bankLock, FILE * out, void * (*fn)(), int * running){
+	//counter
+	int i;
+	//shared memory file and size of its parts
+	int fd;
+	size_t hdrSz = (sizeof(shmHdr) + 63) & ~(size_t) 63;
+	size_t actSz = ((accountNum * sizeof(account)) + 63) & ~(size_t) 63;
+	size_t balSz = accountNum * sizeof(int);
+	//shared mapping
+	char * base;
+	account * shAct;
+	int * shBal;
+
+	procNum = shmProcs();
+	procWk = workersNum;
+	procFn = fn;
+	procRng = running;
+	procOut = out;
+
+	fd = memfd_create("baMng", 0);
+	if(fd < 0 || ftruncate(fd, hdrSz + actSz + balSz)){
+		perror("error (baMng): shared memory");
+		return -1;
+	}
+	base = mmap(NULL, hdrSz + actSz + balSz, PROT_READ | PROT_WRITE,
+		MAP_SHARED, fd, 0);
+	close(fd);
+	if(base == MAP_FAILED){
+		perror("error (baMng): mmap");
+		return -1;
+	}
+	hdr = (shmHdr *) base;
+	shAct = (account *) (base + hdrSz);
+	shBal = (int *) (base + hdrSz + actSz);
+
+	//ring and bank lock
+	shmMutex(&(hdr->lock));
+	shmCond(&(hdr->notEmpty));
+	shmCond(&(hdr->notFull));
+	hdr->head = hdr->tail = hdr->count = hdr->closed = 0;
+	shmMutex(&(hdr->bankLk));
+	*bankLock = &(hdr->bankLk);
+
+	//accounts and their balances
+	for(i = 0; i < accountNum; i++){
+		shmMutex(&(shAct[i].lock));
+		shAct[i].value = (*accts)[i].value;
+		shBal[i] = BANK_accounts[i];
+	}
+	free(*accts);
+	*accts = shAct;
+	free(BANK_accounts);
+	BANK_accounts = shBal;
+
+	//versions and scan helpers live in one process only
+	mvOff();
+
+	//results of several processes go to one file, one line at a time
+	setvbuf(out, NULL, _IOLBF, 0);
+
+	for(i = 0; i < procNum; i++){
+		if(shmFork(i)){
+			perror("error (baMng): fork");
+			procNum = i;
+			break;
+		}
+	}
+	if(!procNum)
+		return -1;
+
+	if(pthread_create(&supervisor, NULL, shmWatch, NULL))
+		return -1;
+	return 0;
+}
+
+/**hand a cmd to the worker processes
+ * @param char * cmd: cmd line
+ * @param int id: id of the cmd
+ * @ret int: 0 = operation success, -1 = failure
+ * @author elithz
+ * @modified 10.18.2026*/
+int shmPush(char * cmd, int id){
+	//slot to fill
+	shmSlot * slot;
+
+	//a wide TRANS must not run cut short
+	if(strlen(cmd) >= SHM_CMD_SIZE)
+		return 1;
+	shmLock(&(hdr->lock));
+	while(hdr->count == SHM_RING)
+		shmWait(&(hdr->notFull));
+
+	slot = &(hdr->ring[hdr->tail]);
+	slot->id = id;
+	gettimeofday(&(slot->timestamp), NULL);
+	strcpy(slot->cmd, cmd);
+	hdr->tail = (hdr->tail + 1) % SHM_RING;
+	hdr->count++;
+
+	pthread_cond_signal(&(hdr->notEmpty));
+	pthread_mutex_unlock(&(hdr->lock));
+	return 0;
+}
+
+/**close the ring and wait for the worker processes
+ * @param FILE * log: where to report crashes
+ * @ret void
+ * @author elithz
+ * @modified 10.18.2026*/
+void shmJoin(FILE * log){
+	//counter
+	int k;
+
+	shmLock(&(hdr->lock));
+	hdr->closed = 1;
+	pthread_cond_broadcast(&(hdr->notEmpty));
+	pthread_mutex_unlock(&(hdr->lock));
+
+	pthread_join(supervisor, NULL);
+
+	for(k = 0; k < procNum; k++)
+		if(respawned[k])
+			fprintf(log, "process %d respawned %d times\n", k, respawned[k]);
+	if(lost)
+		fprintf(log, "%d cmds lost with crashed processes\n", lost);
+}
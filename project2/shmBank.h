@@ -0,0 +1,51 @@
+/**
+*		Filename:  shmBank.h
+*    Description:  Worker processes sharing the accounts through shared memory
+*        Version:  1.0
+*        Created:  10.18.2026 16h31min44s
+*         Author:  Ningyuan Zhang （狮子劫博丽）(elithz), elithz@iastate.edu
+*        Company:  NERVE Software
+*/
+
+/*
+ *  With BAMNG_PROCS=n the server forks n worker processes instead of
+ *  running the workers itself. One shared mapping holds
+ *    - the account table with process shared, robust mutexes,
+ *    - the balances the Bank backend reads and writes,
+ *    - the bank wide lock,
+ *    - a bounded ring of cmds the parent fills from stdin.
+ *  Every worker process runs its own worker pool (threads, fibers,
+ *  priorities and admission control all apply per process) fed from
+ *  the ring, and appends its results to out_file.
+ *
+ *  A worker process that dies is replaced; the cmds it held are lost
+ *  and counted. Locks it held are recovered (EOWNERDEAD) by the next
+ *  process that takes them. Snapshot and AGG cmds need one address
+ *  space and are refused in this mode.
+ */
+
+#ifndef SHMBANK
+#define SHMBANK
+
+#include "baMng.h"
+
+//worker processes asked for in BAMNG_PROCS, 0 = single process
+int shmProcs();
+
+//move accounts, balances and bank lock into shared memory and fork the
+//worker processes, only the parent returns
+//ret 0 = success, -1 = failure
+int shmStart(int workersNum, int accountNum, account ** accts,
+	pthread_mutex_t ** bankLock, FILE * out, void * (*fn)(), int * running);
+
+//hand a cmd to the worker processes, blocks while the ring is full
+//ret 0 = success, 1 = longer than a ring slot, -1 = failure
+int shmPush(char * cmd, int id);
+
+//close the ring, wait for the worker processes and print their fate
+void shmJoin(FILE * log);
+
+//lock a mutex that may have been held by a process that died
+void shmLock(pthread_mutex_t * lk);
+
+#endif
@@ -0,0 +1,200 @@
+/**
+*		Filename:  tpcPart.c
+*    Description:  Two phase commit participant for partitioned banks
+*        Version:  1.0
+*        Created:  10.18.2026 18h05min37s
+*         Author:  Ningyuan Zhang （狮子劫博丽）(elithz), elithz@iastate.edu
+*        Company:  NERVE Software
+*/
+
+#include "tpcPart.h"
+#include "ccStrat.h"
+#include "cmdQue.h"
+#include "fiber.h"
+#include "shmBank.h"
+#include "txLegs.h"
+
+//decisions
+#define TPC_NONE 0
+#define TPC_COMMIT 1
+#define TPC_ABORT 2
+//backoff of a fiber waiting for a decision, usec
+#define TPC_BACKOFF 50
+
+//a prepared transaction waiting for its decision
+typedef struct tpcTxn_struct{
+	long long txid;
+	int decision;
+	//id and arrival of the decision line
+	int decId;
+	struct timeval decArrive;
+	struct tpcTxn_struct * next;
+}tpcTxn;
+
+//prepared transactions
+static tpcTxn * tpcList = NULL;
+static pthread_mutex_t tpcLk = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t tpcCv = PTHREAD_COND_INITIALIZER;
+//ms a PREP waits for its locks, -1 = not read yet
+static long long prepWait = -1;
+
+/**print a vote or an outcome with the TIME of a cmd
+ * @param FILE * out: result file
+ * @param int id: id to answer
+ * @param struct timeval arrive: arrival of that cmd
+ * @param char * what: text between the id and TIME
+ * @ret void
+ * @author elithz
+ * @modified 10.18.2026*/
+static void tpcPrt(FILE * out, int id, struct timeval arrive, char * what){
+	//time of the answer
+	struct timeval now;
+
+	gettimeofday(&now, NULL);
+	flockfile(out);
+	fprintf(out, "%d %s TIME %ld.%06ld %ld.%06ld\n", id, what,
+		(long) arrive.tv_sec, (long) arrive.tv_usec, (long) now.tv_sec,
+		(long) now.tv_usec);
+	funlockfile(out);
+}
+
+/**run a PREP cmd, vote and apply or drop it once decided
+ * @param FILE * out: result file
+ * @param LinkedCommand * cmd: the cmd
+ * @param char ** tok: tokens of the cmd
+ * @param int tokNum: number of tokens
+ * @param int accountNum: number of accounts
+ * @param arena * ar: arena of the cmd
+ * @ret int: 0 = handled, -1 = not a PREP cmd, 1 = bad arguments
+ * @author elithz
+ * @modified 10.18.2026*/
+int tpcCmd(FILE * out, LinkedCommand * cmd, char ** tok, int tokNum,
+	int accountNum, arena * ar){
+	//counter
+	int i;
+	//legs in ascending account order, one per account
+	int n, * acts, * amts, * bls;
+	//transaction id, vote text and lock deadline
+	long long txid;
+	char what[64];
+	struct timeval now;
+	char * val;
+	//this transaction while it waits
+	tpcTxn me, ** p;
+	//locks of the strategy
+	void * held;
+
+	if(strcmp(tok[0], "PREP"))
+		return -1;
+	//decisions are read by the parent and never reach a worker process,
+	//a PREP there would hold its locks forever
+	if(shmProcs())
+		return 1;
+	if(tokNum < 4 || tokNum % 2 || sscanf(tok[1], "%lld", &txid) != 1
+		|| (n = txLegs(ar, tok + 2, (tokNum - 2) / 2, accountNum, &acts,
+		&amts)) < 0 || !(bls = arAlloc(ar, n * sizeof(int))))
+		return 1;
+
+	if(prepWait < 0){
+		val = getenv("BAMNG_PREP_WAIT");
+		prepWait = val && atoll(val) >= 0 ? atoll(val) : 50;
+	}
+	gettimeofday(&now, NULL);
+
+	//take the locks a TRANS of the legs would take or vote BUSY
+	if(!(held = cc->prep(ar, n, acts, tvUsec(now) + prepWait * 1000,
+		cmd->id))){
+		snprintf(what, sizeof(what), "NO %lld BUSY", txid);
+		tpcPrt(out, cmd->id, cmd->timestamp, what);
+		queStat(cmd);
+		return 0;
+	}
+
+	//vote NO on insufficient funds
+	for(i = 0; i < n; i++){
+		bls[i] = read_account(acts[i]);
+		if(bls[i] + amts[i] < 0)
+			break;
+	}
+	if(i < n){
+		snprintf(what, sizeof(what), "NO %lld ISF %d", txid, acts[i]);
+		cc->commit(held, n, acts, NULL);
+		tpcPrt(out, cmd->id, cmd->timestamp, what);
+		queStat(cmd);
+		return 0;
+	}
+
+	//vote yes and wait for the decision holding the locks
+	me.txid = txid;
+	me.decision = TPC_NONE;
+	pthread_mutex_lock(&tpcLk);
+	me.next = tpcList;
+	tpcList = &me;
+	pthread_mutex_unlock(&tpcLk);
+	snprintf(what, sizeof(what), "PREPARED %lld", txid);
+	tpcPrt(out, cmd->id, cmd->timestamp, what);
+	queStat(cmd);
+
+	if(fbrActive()){
+		//a fiber must not block its thread
+		while(!__atomic_load_n(&me.decision, __ATOMIC_ACQUIRE))
+			fbrSleep(TPC_BACKOFF);
+		pthread_mutex_lock(&tpcLk);
+	}
+	else{
+		pthread_mutex_lock(&tpcLk);
+		while(!me.decision)
+			pthread_cond_wait(&tpcCv, &tpcLk);
+	}
+	for(p = &tpcList; *p != &me; p = &((*p)->next))
+		;
+	*p = me.next;
+	pthread_mutex_unlock(&tpcLk);
+
+	if(me.decision == TPC_COMMIT){
+		for(i = 0; i < n; i++)
+			bls[i] += amts[i];
+		cc->commit(held, n, acts, bls);
+		tpcPrt(out, me.decId, me.decArrive, "OK");
+	}
+	else{
+		cc->commit(held, n, acts, NULL);
+		tpcPrt(out, me.decId, me.decArrive, "ABORTED");
+	}
+	return 0;
+}
+
+/**hand a COMMIT or ABORT line to the prepared transaction
+ * @param char * line: cmd line
+ * @param int id: id of the line
+ * @ret int: 1 = it was a decision, 0 = some other cmd
+ * @author elithz
+ * @modified 10.18.2026*/
+int tpcDecide(char * line, int id){
+	//decision and transaction it is for
+	int dec;
+	long long txid;
+	char tail;
+	tpcTxn * t;
+
+	if(sscanf(line, "COMMIT %lld %c", &txid, &tail) == 1)
+		dec = TPC_COMMIT;
+	else if(sscanf(line, "ABORT %lld %c", &txid, &tail) == 1)
+		dec = TPC_ABORT;
+	else
+		return 0;
+
+	pthread_mutex_lock(&tpcLk);
+	for(t = tpcList; t && (t->txid != txid || t->decision); t = t->next)
+		;
+	if(t){
+		t->decId = id;
+		gettimeofday(&(t->decArrive), NULL);
+		__atomic_store_n(&(t->decision), dec, __ATOMIC_RELEASE);
+		pthread_cond_broadcast(&tpcCv);
+	}
+	else
+		fprintf(stderr, "%d INVALID REQUEST FORMAT\n", id);
+	pthread_mutex_unlock(&tpcLk);
+	return 1;
+}
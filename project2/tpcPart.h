@@ -0,0 +1,45 @@
+/**
+*		Filename:  tpcPart.h
+*    Description:  Two phase commit participant for partitioned banks
+*        Version:  1.0
+*        Created:  10.18.2026 18h05min37s
+*         Author:  Ningyuan Zhang （狮子劫博丽）(elithz), elithz@iastate.edu
+*        Company:  NERVE Software
+*/
+
+/*
+ *  A TRANS that spans several baMng instances (see baRtr.c) is sent to
+ *  each of them as
+ *    PREP txid a1 m1 ... an mn
+ *  The worker takes the locks a TRANS of the legs would take under the
+ *  strategy in use (ccStrat.h), checks the funds and votes
+ *    "<id> PREPARED txid TIME ..."          locks are kept
+ *    "<id> NO txid ISF acct TIME ..."       insufficient funds
+ *    "<id> NO txid BUSY TIME ..."           locks not free within
+ *                                           BAMNG_PREP_WAIT ms (default 50)
+ *  A yes voter keeps its locks until the main thread reads
+ *    COMMIT txid   applied, "<id> OK TIME ..."
+ *    ABORT txid    released, "<id> ABORTED TIME ..."
+ *  Decisions never queue behind other cmds, so workers waiting for
+ *  one can not starve the decision. Timing out on locks instead of
+ *  waiting breaks deadlocks between instances, the router retries.
+ *  With BAMNG_PROCS the decision would not reach the worker process
+ *  holding the locks, so PREP is refused there as invalid.
+ */
+
+#ifndef TPCPART
+#define TPCPART
+
+#include "baMng.h"
+#include "arena.h"
+
+//run a PREP cmd, its legs go in ar
+//ret 0 = handled, -1 = not a PREP cmd, 1 = bad arguments
+int tpcCmd(FILE * out, LinkedCommand * cmd, char ** tok, int tokNum,
+	int accountNum, arena * ar);
+
+//hand a COMMIT or ABORT line to the waiting PREP, called by the main
+//thread with the id the line got, ret 1 = it was a decision, 0 = not
+int tpcDecide(char * line, int id);
+
+#endif
@@ -0,0 +1,303 @@
+/**
+*		Filename:  trace.c
+*    Description:  Per thread event rings exported as Chrome trace JSON
+*        Version:  1.0
+*        Created:  10.18.2026 20h24min51s
+*         Author:  Ningyuan Zhang （狮子劫博丽）(elithz), elithz@iastate.edu
+*        Company:  NERVE Software
+*/
+
+#include "trace.h"
+#include "fiber.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+//ring size when BAMNG_TRACE_EVENTS is not set
+#define TR_EVENTS 65536
+
+//one event
+typedef struct trEvt_struct{
+	long long ts;
+	long long dur;
+	int id;
+	int arg;
+	short type;
+	short track;
+	char ph;
+}trEvt;
+
+//events of one thread
+typedef struct trRing_struct{
+	trEvt * evts;
+	unsigned long long num;
+	int idx;
+	//tracks, the thread itself and one per fiber
+	int tracks;
+	//cmd each track is working on and tracks that saw events
+	int * cur;
+	char * used;
+	//1 while no thread owns it
+	int idle;
+	struct trRing_struct * next;
+}trRing;
+
+int trEnabled = 0;
+//trace file, ring size and start of the trace
+static char * trPath;
+static unsigned long long trSize = TR_EVENTS;
+static long long trStart;
+//every ring, guarded by trLk
+static trRing * trRings = NULL;
+static int trRingNum = 0;
+static pthread_mutex_t trLk = PTHREAD_MUTEX_INITIALIZER;
+//ring of the calling thread
+static __thread trRing * myRing = NULL;
+//names in the trace
+static const char * trName[] = {"enqueue", "queued", "cmd", "lock", "read",
+	"write", "result"};
+
+/**microseconds since the epoch
+ * @ret long long: now
+ * @author elithz
+ * @modified 10.18.2026*/
+static long long trNow(){
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return (long long) tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+/**ring of the calling thread, made on first use
+ * @ret trRing *: ring, NULL if out of memory
+ * @author elithz
+ * @modified 10.18.2026*/
+static trRing * trMine(){
+	//new ring
+	trRing * r;
+
+	if(myRing)
+		return myRing;
+	//take over the ring of a thread that left, its events stay
+	pthread_mutex_lock(&trLk);
+	for(r = trRings; r && !r->idle; r = r->next)
+		;
+	if(r)
+		r->idle = 0;
+	pthread_mutex_unlock(&trLk);
+	if(r){
+		memset(r->cur, 0, r->tracks * sizeof(int));
+		myRing = r;
+		return r;
+	}
+	r = calloc(1, sizeof(trRing));
+	if(!r)
+		return NULL;
+	r->tracks = fbrNum() + 1;
+	r->evts = malloc(trSize * sizeof(trEvt));
+	r->cur = calloc(r->tracks, sizeof(int));
+	r->used = calloc(r->tracks, 1);
+	if(!r->evts || !r->cur || !r->used){
+		free(r->evts);
+		free(r->cur);
+		free(r->used);
+		free(r);
+		return NULL;
+	}
+	pthread_mutex_lock(&trLk);
+	r->idx = trRingNum++;
+	r->next = trRings;
+	trRings = r;
+	pthread_mutex_unlock(&trLk);
+	myRing = r;
+	return r;
+}
+
+/**hand the ring of the calling thread to the next thread made, called
+ * by a thread about to exit
+ * @ret void
+ * @author elithz
+ * @modified 10.18.2026*/
+void trRelease(){
+	if(!myRing)
+		return;
+	pthread_mutex_lock(&trLk);
+	myRing->idle = 1;
+	pthread_mutex_unlock(&trLk);
+	myRing = NULL;
+}
+
+/**append an event to the ring of the calling thread
+ * @param int type: event type
+ * @param char ph: Chrome phase, B, E, X or i
+ * @param int id: cmd id, 0 = current cmd of the track
+ * @param int arg: account or -1
+ * @param long long ts: time in usec
+ * @param long long dur: length of an X event
+ * @ret void
+ * @author elithz
+ * @modified 10.18.2026*/
+static void trPush(int type, char ph, int id, int arg, long long ts,
+	long long dur){
+	//ring, track and slot
+	trRing * r = trMine();
+	int track = fbrIdx() + 1;
+	trEvt * e;
+
+	if(!r || track >= r->tracks)
+		return;
+	e = &r->evts[r->num++ % trSize];
+	e->ts = ts;
+	e->dur = dur;
+	e->id = id ? id : r->cur[track];
+	e->arg = arg;
+	e->type = type;
+	e->track = track;
+	e->ph = ph;
+	r->used[track] = 1;
+}
+
+/**read BAMNG_TRACE and make the ring of the main thread
+ * @ret int: 0 = operation success, -1 = failure
+ * @author elithz
+ * @modified 10.18.2026*/
+int trInit(){
+	//environment values
+	char * val = getenv("BAMNG_TRACE");
+
+	if(!val)
+		return 0;
+	trPath = val;
+	if((val = getenv("BAMNG_TRACE_EVENTS")) && atoll(val) > 0)
+		trSize = atoll(val);
+	trStart = trNow();
+	if(!trMine())
+		return -1;
+	trEnabled = 1;
+	return 0;
+}
+
+/**instant event of a cmd
+ * @param int type: event type
+ * @param int id: cmd id, 0 = current cmd
+ * @ret void
+ * @author elithz
+ * @modified 10.18.2026*/
+void trMark(int type, int id){
+	trPush(type, 'i', id, -1, trNow(), 0);
+}
+
+/**a worker took a cmd, log its time in the queue and start its span
+ * @param int id: cmd id
+ * @param struct timeval arrive: arrival of the cmd
+ * @ret void
+ * @author elithz
+ * @modified 10.18.2026*/
+void trCmd(int id, struct timeval arrive){
+	//now and arrival in usec
+	long long now = trNow();
+	long long at = (long long) arrive.tv_sec * 1000000 + arrive.tv_usec;
+	trRing * r = trMine();
+
+	if(!r)
+		return;
+	if(fbrIdx() + 1 < r->tracks)
+		r->cur[fbrIdx() + 1] = id;
+	trPush(TR_QUEUED, 'X', id, -1, at, now - at);
+	trPush(TR_CMD, 'B', id, -1, now, 0);
+}
+
+/**begin a span of the current cmd
+ * @param int type: event type
+ * @param int arg: account or -1
+ * @ret void
+ * @author elithz
+ * @modified 10.18.2026*/
+void trBegin(int type, int arg){
+	trPush(type, 'B', 0, arg, trNow(), 0);
+}
+
+/**end a span of the current cmd
+ * @param int type: event type
+ * @param int arg: account or -1
+ * @ret void
+ * @author elithz
+ * @modified 10.18.2026*/
+void trEnd(int type, int arg){
+	trPush(type, 'E', 0, arg, trNow(), 0);
+}
+
+/**write every ring to the trace file as Chrome trace JSON
+ * @ret void
+ * @author elithz
+ * @modified 10.18.2026*/
+void trDump(){
+	//counters
+	unsigned long long i, first;
+	int t;
+	//trace file, ring and event
+	FILE * out;
+	trRing * r, * o;
+	trEvt * e;
+	//separator before the next event
+	const char * sep = "";
+
+	if(!trEnabled)
+		return;
+	trEnabled = 0;
+	out = fopen(trPath, "w");
+	if(!out){
+		fprintf(stderr, "error (baMng): failed to open trace \"%s\"\n", trPath);
+		return;
+	}
+
+	fprintf(out, "{\"traceEvents\":[\n");
+	pthread_mutex_lock(&trLk);
+	for(r = trRings; r; r = r->next){
+		//name the tracks, the first ring made is the main thread
+		for(t = 0; t < r->tracks; t++){
+			if(!r->used[t])
+				continue;
+			fprintf(out, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,"
+				"\"tid\":%d,\"args\":{\"name\":\"", sep, r->idx * 10000 + t);
+			if(!r->idx)
+				fprintf(out, "main");
+			else if(t)
+				fprintf(out, "worker %d fiber %d", r->idx, t - 1);
+			else
+				fprintf(out, "worker %d", r->idx);
+			fprintf(out, "\"}}");
+			sep = ",\n";
+		}
+
+		//oldest event first, older ones may have been overwritten
+		first = r->num > trSize ? r->num - trSize : 0;
+		for(i = first; i < r->num; i++){
+			e = &r->evts[i % trSize];
+			fprintf(out, "%s{\"name\":\"%s\",\"ph\":\"%c\",\"pid\":1,\"tid\":%d,"
+				"\"ts\":%lld", sep, trName[e->type], e->ph,
+				r->idx * 10000 + e->track, e->ts - trStart);
+			if(e->ph == 'X')
+				fprintf(out, ",\"dur\":%lld", e->dur);
+			if(e->ph == 'i')
+				fprintf(out, ",\"s\":\"t\"");
+			fprintf(out, ",\"args\":{\"id\":%d", e->id);
+			if(e->arg >= 0)
+				fprintf(out, ",\"acct\":%d", e->arg);
+			fprintf(out, "}}");
+			sep = ",\n";
+		}
+	}
+	fprintf(out, "\n]}\n");
+	fclose(out);
+
+	for(r = trRings; r; r = o){
+		o = r->next;
+		free(r->evts);
+		free(r->cur);
+		free(r->used);
+		free(r);
+	}
+	trRings = NULL;
+	pthread_mutex_unlock(&trLk);
+}
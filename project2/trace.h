@@ -0,0 +1,68 @@
+/**
+*		Filename:  trace.h
+*    Description:  Per thread event rings exported as Chrome trace JSON
+*        Version:  1.0
+*        Created:  10.18.2026 20h24min51s
+*         Author:  Ningyuan Zhang （狮子劫博丽）(elithz), elithz@iastate.edu
+*        Company:  NERVE Software
+*/
+
+/*
+ *  With BAMNG_TRACE=path every thread records the life of the cmds it
+ *  touches into its own ring of BAMNG_TRACE_EVENTS events (default
+ *  65536, the oldest are overwritten), without any shared lock:
+ *    enqueue        instant, main thread, when the cmd is read
+ *    queued         span from arrival to the worker taking the cmd
+ *    cmd            span of the whole handling
+ *    lock           span waiting for an account lock (acct 0 = bank)
+ *    read / write   span of a backend call
+ *    result         instant, when the result line is logged
+ *  Every fiber gets its own track. A worker that leaves the pool hands
+ *  its ring to the next thread that starts, so there are never more
+ *  rings than threads alive at once. At END the rings are written to
+ *  path as Chrome trace JSON for chrome://tracing or ui.perfetto.dev.
+ *  Disabled, each hook is one load and a branch.
+ */
+
+#ifndef TRACE
+#define TRACE
+
+#include <sys/time.h>
+
+//event types
+#define TR_ENQUEUE 0
+#define TR_QUEUED 1
+#define TR_CMD 2
+#define TR_LOCK 3
+#define TR_READ 4
+#define TR_WRITE 5
+#define TR_RESULT 6
+
+//set when tracing, checked by the macros before any call
+extern int trEnabled;
+
+//read BAMNG_TRACE, ret 0 = success, -1 = failure
+int trInit();
+
+//instant event of cmd id
+void trMark(int type, int id);
+
+//a worker took cmd id that arrived at arrive, starts its cmd span
+void trCmd(int id, struct timeval arrive);
+
+//begin and end a span of the current cmd, arg is the account
+void trBegin(int type, int arg);
+void trEnd(int type, int arg);
+
+//give the ring of the calling thread to the next thread, before it exits
+void trRelease();
+
+//write every ring to the trace file
+void trDump();
+
+//hooks, free when tracing is off
+#define TR_MARK(type, id) do{ if(trEnabled) trMark(type, id); }while(0)
+#define TR_BEGIN(type, arg) do{ if(trEnabled) trBegin(type, arg); }while(0)
+#define TR_END(type, arg) do{ if(trEnabled) trEnd(type, arg); }while(0)
+
+#endif
@@ -0,0 +1,130 @@
+/**
+*		Filename:  txLegs.c
+*    Description:  Parsing and lock ordering of the legs of a transfer
+*        Version:  1.0
+*        Created:  10.18.2026 21h14min26s
+*         Author:  Ningyuan Zhang （狮子劫博丽）(elithz), elithz@iastate.edu
+*        Company:  NERVE Software
+*/
+
+#include "txLegs.h"
+#include <errno.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+//one leg
+typedef struct txLeg_struct{
+	int act;
+	int amt;
+}txLeg;
+
+/**parse a whole token as an int
+ * @param char * tok: token
+ * @param int * val: value
+ * @ret int: 0 = operation success, -1 = not an int
+ * @author elithz
+ * @modified 10.18.2026*/
+int txInt(char * tok, int * val){
+	//end of the number and its value
+	char * end;
+	long v;
+
+	errno = 0;
+	v = strtol(tok, &end, 10);
+	if(end == tok || *end || errno || v < INT_MIN || v > INT_MAX)
+		return -1;
+	*val = (int) v;
+	return 0;
+}
+
+/**sort legs by account, a byte at a time from the lowest
+ * @param txLeg * legs: legs
+ * @param txLeg * tmp: scratch of the same size
+ * @param int n: number of legs
+ * @param int accountNum: largest account
+ * @ret txLeg *: legs or tmp, whichever holds the sorted legs
+ * @author elithz
+ * @modified 10.18.2026*/
+static txLeg * txRadix(txLeg * legs, txLeg * tmp, int n, int accountNum){
+	//counters
+	int i, shift;
+	//legs per byte value, then where they start
+	int cnt[256];
+	//sorted legs go from src to dst each pass
+	txLeg * src = legs, * dst = tmp, * swap;
+
+	for(shift = 0; shift < 32 && accountNum >> shift; shift += 8){
+		memset(cnt, 0, sizeof(cnt));
+		for(i = 0; i < n; i++)
+			cnt[(src[i].act >> shift) & 0xff]++;
+		for(i = 1; i < 256; i++)
+			cnt[i] += cnt[i - 1];
+		//backwards keeps the pass stable
+		for(i = n - 1; i >= 0; i--)
+			dst[--cnt[(src[i].act >> shift) & 0xff]] = src[i];
+		swap = src;
+		src = dst;
+		dst = swap;
+	}
+	return src;
+}
+
+/**parse, sort and merge the legs of a transfer
+ * @param arena * ar: arena of the cmd
+ * @param char ** tok: account and amount tokens
+ * @param int legNum: number of legs
+ * @param int accountNum: number of accounts
+ * @param int ** acts: accounts in ascending order
+ * @param int ** amts: amount of each account
+ * @ret int: number of accounts, -1 = bad leg or out of memory
+ * @author elithz
+ * @modified 10.18.2026*/
+int txLegs(arena * ar, char ** tok, int legNum, int accountNum, int ** acts,
+	int ** amts){
+	//counters
+	int i, j, n;
+	//parsed legs and the sorted ones
+	txLeg * legs, * sorted, leg;
+	//merged amount
+	long long sum;
+
+	legs = arAlloc(ar, legNum * sizeof(txLeg));
+	*acts = arAlloc(ar, legNum * sizeof(int));
+	*amts = arAlloc(ar, legNum * sizeof(int));
+	if(!legs || !*acts || !*amts || legNum < 1)
+		return -1;
+	for(i = 0; i < legNum; i++)
+		if(txInt(tok[i * 2], &legs[i].act) || txInt(tok[i * 2 + 1], &legs[i].amt)
+			|| legs[i].act < 1 || legs[i].act > accountNum)
+			return -1;
+
+	//ascending account order
+	sorted = legs;
+	if(legNum <= TX_SMALL)
+		for(i = 1; i < legNum; i++){
+			leg = legs[i];
+			for(j = i; j > 0 && legs[j - 1].act > leg.act; j--)
+				legs[j] = legs[j - 1];
+			legs[j] = leg;
+		}
+	else{
+		sorted = arAlloc(ar, legNum * sizeof(txLeg));
+		if(!sorted)
+			return -1;
+		sorted = txRadix(legs, sorted, legNum, accountNum);
+	}
+
+	//one leg per account
+	for(i = 0, n = 0; i < legNum; n++){
+		sum = 0;
+		for(j = i; j < legNum && sorted[j].act == sorted[i].act; j++)
+			sum += sorted[j].amt;
+		if(sum < INT_MIN || sum > INT_MAX)
+			return -1;
+		(*acts)[n] = sorted[i].act;
+		(*amts)[n] = (int) sum;
+		i = j;
+	}
+	return n;
+}
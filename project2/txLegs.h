@@ -0,0 +1,37 @@
+/**
+*		Filename:  txLegs.h
+*    Description:  Parsing and lock ordering of the legs of a transfer
+*        Version:  1.0
+*        Created:  10.18.2026 21h14min26s
+*         Author:  Ningyuan Zhang （狮子劫博丽）(elithz), elithz@iastate.edu
+*        Company:  NERVE Software
+*/
+
+/*
+ *  TRANS and PREP take any number of "account amount" legs. The legs
+ *  are parsed into the cmd's arena, put in ascending account order (the
+ *  order every worker takes account locks in) and legs naming the same
+ *  account are merged into one with the summed amount, so each lock is
+ *  taken once. Up to TX_SMALL legs an insertion sort is cheapest; wider
+ *  transfers such as payroll batches are radix sorted a byte of the
+ *  account number at a time, linear in the number of legs.
+ */
+
+#ifndef TXLEGS
+#define TXLEGS
+
+#include "arena.h"
+
+//legs sorted by insertion sort, more are radix sorted
+#define TX_SMALL 32
+
+//parse a whole token as an int, ret 0 = success, -1 = not an int
+int txInt(char * tok, int * val);
+
+//parse legNum legs from tok (account, amount, account, ...), accounts
+//1..accountNum, into arrays *acts and *amts taken from ar
+//ret number of distinct accounts, -1 = bad leg or out of memory
+int txLegs(arena * ar, char ** tok, int legNum, int accountNum, int ** acts,
+	int ** amts);
+
+#endif
@@ -0,0 +1,241 @@
+/**
+*		Filename:  wkPool.c
+*    Description:  Adaptive pool of request handling worker threads
+*        Version:  1.0
+*        Created:  10.18.2026 11h20min05s
+*         Author:  Ningyuan Zhang （狮子劫博丽）(elithz), elithz@iastate.edu
+*        Company:  NERVE Software
+*/
+
+#include "wkPool.h"
+#include "cmdQue.h"
+#include "fiber.h"
+#include "trace.h"
+
+//how often the monitor samples the queue in usec
+#define POOL_TICK 5000
+
+//worker body and server running flag
+static void * (*poolFn)();
+static int * poolRng;
+//bounds and thresholds
+static int poolMin, poolMax;
+static long long growUsec = 20000;
+static long long idleUsec = 1000000;
+//workers counted against the bounds, idle ones and threads alive
+static int poolCur = 0;
+static int poolIdle = 0;
+static int poolAlive = 0;
+//statistics
+static int poolPeak = 0;
+static int poolGrown = 0;
+static int poolShrunk = 0;
+//guards the counters
+static pthread_mutex_t poolLk = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t poolCv = PTHREAD_COND_INITIALIZER;
+//monitor thread
+static pthread_t poolMon;
+
+//1 once this worker decided to leave the pool
+static __thread int retiring = 0;
+
+/**body of every pool thread, runs the worker and books its exit
+ * @ret void *: NULL
+ * @author elithz
+ * @modified 10.18.2026*/
+static void * poolRun(void * arg){
+	//fibers per thread, 0 = run the worker directly
+	int n = fbrNum();
+
+	if(!n || fbrRun(n, poolFn))
+		poolFn();
+	trRelease();
+
+	pthread_mutex_lock(&poolLk);
+	if(!retiring)
+		poolCur--;
+	poolAlive--;
+	pthread_cond_broadcast(&poolCv);
+	pthread_mutex_unlock(&poolLk);
+	return NULL;
+}
+
+/**spawn n workers, poolLk must be held
+ * @param int n: number of workers to add
+ * @ret int: number of workers actually added
+ * @author elithz
+ * @modified 10.18.2026*/
+static int poolSpawn(int n){
+	//counter
+	int i;
+	//new thread
+	pthread_t t;
+	pthread_attr_t attr;
+
+	pthread_attr_init(&attr);
+	pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+	for(i = 0; i < n; i++){
+		if(pthread_create(&t, &attr, poolRun, NULL))
+			break;
+		poolCur++;
+		poolAlive++;
+	}
+	pthread_attr_destroy(&attr);
+
+	if(poolCur > poolPeak)
+		poolPeak = poolCur;
+	return i;
+}
+
+/**monitor thread, grows the pool while cmds wait too long
+ * @ret void *: NULL
+ * @author elithz
+ * @modified 10.18.2026*/
+static void * poolWatch(void * arg){
+	//queue delay and workers to add
+	long long delay;
+	int add;
+
+	while(*poolRng || cmdBf->size > 0){
+		usleep(POOL_TICK);
+		delay = queDelay();
+
+		pthread_mutex_lock(&poolLk);
+		if(delay > growUsec && poolIdle == 0 && poolCur < poolMax){
+			//one worker per waiting cmd, at most doubling per tick
+			add = cmdBf->size;
+			if(add > poolCur)
+				add = poolCur;
+			if(add > poolMax - poolCur)
+				add = poolMax - poolCur;
+			if(add < 1)
+				add = 1;
+			poolGrown += poolSpawn(add);
+		}
+		pthread_mutex_unlock(&poolLk);
+	}
+	return NULL;
+}
+
+/**start the pool
+ * @param int workersNum: pool size when BAMNG_POOL is not set
+ * @param void * (*fn)(): worker body
+ * @param int * running: server flag, 0 once END was read
+ * @ret int: 0 = operation success, -1 = failure
+ * @author elithz
+ * @modified 10.18.2026*/
+int poolStart(int workersNum, void * (*fn)(), int * running){
+	//environment values
+	char * val;
+	//parsed values
+	int lo, hi;
+	long long ms;
+
+	poolFn = fn;
+	poolRng = running;
+	poolMin = poolMax = workersNum;
+
+	if((val = getenv("BAMNG_POOL"))){
+		if(sscanf(val, "%d:%d", &lo, &hi) == 2 && lo > 0 && hi >= lo){
+			poolMin = lo;
+			poolMax = hi;
+		}
+		else
+			fprintf(stderr, "error (baMng): bad BAMNG_POOL \"%s\", "
+				"ignored\n", val);
+	}
+	if((val = getenv("BAMNG_POOL_GROW")) && sscanf(val, "%lld", &ms) == 1)
+		growUsec = ms * 1000;
+	if((val = getenv("BAMNG_POOL_IDLE")) && sscanf(val, "%lld", &ms) == 1)
+		idleUsec = ms * 1000;
+
+	pthread_mutex_lock(&poolLk);
+	poolSpawn(poolMin);
+	pthread_mutex_unlock(&poolLk);
+	if(poolCur < 1)
+		return -1;
+
+	//a fixed size pool needs no monitor
+	if(poolMax > poolMin && pthread_create(&poolMon, NULL, poolWatch, NULL))
+		poolMax = poolMin;
+
+	return 0;
+}
+
+/**wait for work, called by a worker that found the buffer empty
+ * @ret int: 1 = worker was idle too long and must return, 0 = go on
+ * @author elithz
+ * @modified 10.18.2026*/
+int poolWait(){
+	//when the worker started idling and the current time
+	struct timeval start, now;
+	//time idle so far
+	long long idle;
+
+	gettimeofday(&start, NULL);
+	pthread_mutex_lock(&poolLk);
+	poolIdle++;
+	pthread_mutex_unlock(&poolLk);
+
+	//fibers poll so the thread keeps driving the others, and never leave
+	//or block the thread, even when another worker took the cmd first
+	while(fbrActive() && cmdBf->size == 0 && *poolRng)
+		fbrSleep(POOL_TICK / 5);
+
+	while(!fbrActive() && cmdBf->size == 0 && *poolRng){
+		gettimeofday(&now, NULL);
+		idle = tvUsec(now) - tvUsec(start);
+
+		//leave the pool if it is above its minimum
+		if(idle >= idleUsec){
+			pthread_mutex_lock(&poolLk);
+			if(poolCur > poolMin){
+				poolCur--;
+				poolIdle--;
+				poolShrunk++;
+				retiring = 1;
+				pthread_mutex_unlock(&poolLk);
+				return 1;
+			}
+			pthread_mutex_unlock(&poolLk);
+			gettimeofday(&start, NULL);
+			idle = 0;
+		}
+
+		queWait(idleUsec - idle < POOL_TICK * 20 ? idleUsec - idle
+			: POOL_TICK * 20);
+	}
+
+	pthread_mutex_lock(&poolLk);
+	poolIdle--;
+	pthread_mutex_unlock(&poolLk);
+	return 0;
+}
+
+/**wait until every worker and the monitor are finished
+ * @ret void
+ * @author elithz
+ * @modified 10.18.2026*/
+void poolJoin(){
+	//wake idle workers so they notice END
+	queWake();
+
+	pthread_mutex_lock(&poolLk);
+	while(poolAlive > 0)
+		pthread_cond_wait(&poolCv, &poolLk);
+	pthread_mutex_unlock(&poolLk);
+
+	if(poolMax > poolMin)
+		pthread_join(poolMon, NULL);
+}
+
+/**print pool sizing statistics
+ * @param FILE * out: where to print
+ * @ret void
+ * @author elithz
+ * @modified 10.18.2026*/
+void poolPrtStat(FILE * out){
+	if(poolMax > poolMin)
+		fprintf(out, "pool min %d max %d peak %d grown %d shrunk %d\n",
+			poolMin, poolMax, poolPeak, poolGrown, poolShrunk);
+}
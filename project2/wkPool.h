@@ -0,0 +1,42 @@
+/**
+*		Filename:  wkPool.h
+*    Description:  Adaptive pool of request handling worker threads
+*        Version:  1.0
+*        Created:  10.18.2026 11h20min05s
+*         Author:  Ningyuan Zhang （狮子劫博丽）(elithz), elithz@iastate.edu
+*        Company:  NERVE Software
+*/
+
+/*
+ *  The pool starts with min workers. A monitor thread adds workers
+ *  while the oldest queued cmd has waited longer than the grow
+ *  threshold and nobody is idle, and workers that found nothing to do
+ *  for the idle timeout leave as long as more than min remain.
+ *
+ *    BAMNG_POOL       min:max workers (default workersNum:workersNum)
+ *    BAMNG_POOL_GROW  queue delay in ms that triggers growth (default 20)
+ *    BAMNG_POOL_IDLE  idle time in ms before a worker leaves (default 1000)
+ *
+ *  With BAMNG_FIBERS set every pool thread runs that many fibers (see
+ *  fiber.h). Growing still adds threads, fibers never leave the pool.
+ */
+
+#ifndef WKPOOL
+#define WKPOOL
+
+#include <stdio.h>
+
+//start the pool, workersNum is used when BAMNG_POOL is not set
+//ret 0 = success, -1 = failure
+int poolStart(int workersNum, void * (*fn)(), int * running);
+
+//called by a worker with nothing to do, ret 1 = worker must return
+int poolWait();
+
+//wait until every worker and the monitor are finished
+void poolJoin();
+
+//print pool sizing statistics
+void poolPrtStat(FILE * out);
+
+#endif